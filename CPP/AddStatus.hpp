@@ -0,0 +1,10 @@
+#ifndef ADD_STATUS_HPP
+#define ADD_STATUS_HPP
+
+/**
+ * What tryAdd() did. It never throws, so running out of memory for the new node
+ * comes back as OUT_OF_MEMORY, with the list unchanged.
+ */
+enum class AddStatus { ADDED, PRESENT, OUT_OF_MEMORY };
+
+#endif
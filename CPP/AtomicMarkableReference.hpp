@@ -0,0 +1,108 @@
+#ifndef ATOMIC_MARKABLE_REFERENCE_HPP
+#define ATOMIC_MARKABLE_REFERENCE_HPP
+
+//
+// Used for the packed word
+#include <atomic>
+#include <cstdint>
+
+/**
+ * C++ version of Java's AtomicMarkableReference.
+ *
+ * The mark is stored in the lowest bit of the pointer, so the (reference, mark)
+ * pair can be read and compare-and-swapped as a single machine word. Java
+ * allocates a new pair object on every update, we don't need to.
+ *
+ * T has to be at least 2 byte aligned, which every node in this project is.
+ */
+template<typename T> class AtomicMarkableReference {
+    private:
+        //
+        // Pointer bits with the mark folded into bit 0.
+        std::atomic<std::uintptr_t> value;
+
+        /**
+         * Pack a reference and a mark into one word.
+         */
+        static std::uintptr_t pack(T* reference, bool mark){
+            return reinterpret_cast<std::uintptr_t>(reference) | (mark ? 1 : 0);
+        }
+
+        /**
+         * Get the reference part of a packed word.
+         */
+        static T* unpackReference(std::uintptr_t word){
+            return reinterpret_cast<T*>(word & ~static_cast<std::uintptr_t>(1));
+        }
+
+    public:
+        /**
+         * Constructor, the reference starts out unmarked by default.
+         */
+        AtomicMarkableReference(T* reference = nullptr, bool mark = false) : value(pack(reference, mark)) {
+            static_assert(alignof(T) >= 2, "The low pointer bit is used as the mark.");
+        }
+
+        /**
+         * @return the current reference
+         */
+        T* getReference() const {
+            return unpackReference(value.load(std::memory_order_acquire));
+        }
+
+        /**
+         * @return the current mark
+         */
+        bool isMarked() const {
+            return (value.load(std::memory_order_acquire) & 1) != 0;
+        }
+
+        /**
+         * Read the reference and the mark at the same time.
+         * @param mark set to the current mark
+         * @return the current reference
+         */
+        T* get(bool& mark) const {
+            std::uintptr_t word = value.load(std::memory_order_acquire);
+            mark = (word & 1) != 0;
+            return unpackReference(word);
+        }
+
+        /**
+         * Unconditionally set the reference and the mark. Only safe before
+         * the owning node is visible to other threads.
+         */
+        void set(T* reference, bool mark){
+            value.store(pack(reference, mark), std::memory_order_release);
+        }
+
+        /**
+         * Atomically set (reference, mark) if the current pair is (expectedReference, expectedMark).
+         * @return true iff the swap happened
+         */
+        bool compareAndSet(T* expectedReference, T* newReference, bool expectedMark, bool newMark){
+            std::uintptr_t expected = pack(expectedReference, expectedMark);
+            return value.compare_exchange_strong(expected, pack(newReference, newMark),
+                                                 std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+
+        /**
+         * Atomically set the mark if the current reference is expectedReference.
+         * @return true iff the reference matched and the mark now equals newMark
+         */
+        bool attemptMark(T* expectedReference, bool newMark){
+            std::uintptr_t word = value.load(std::memory_order_acquire);
+            while (unpackReference(word) == expectedReference){
+                if (((word & 1) != 0) == newMark){
+                    return true;
+                }
+                if (value.compare_exchange_weak(word, pack(expectedReference, newMark),
+                                                std::memory_order_acq_rel, std::memory_order_acquire)){
+                    return true;
+                }
+            }
+            return false;
+        }
+};
+
+#endif
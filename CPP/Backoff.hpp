@@ -0,0 +1,108 @@
+#ifndef BACKOFF_HPP
+#define BACKOFF_HPP
+
+//
+// Used for pausing
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include "SpinLock.hpp"
+
+/**
+ * Backoff policies for the retry loops of the optimistic, lazy and lock-free lists.
+ *
+ * An update that fails validation, or loses a CAS, makes one Backoff for the whole
+ * operation and calls pause() before every retry. A retry that comes straight back
+ * tends to lose to the same thread again, so on a hot key the losers only burn
+ * their cores and the winner's cache line.
+ */
+
+/**
+ * Retry at once. Fine while conflicts are rare, and the cheapest when they are.
+ */
+class NoBackoff {
+    public:
+        void pause(){}
+};
+
+/**
+ * Spin twice as long after every failure, up to a cap, then give the core away.
+ */
+class ExponentialBackoff {
+    private:
+        //
+        // Pauses after the first failure, and the most it backs off to.
+        static constexpr int MIN_DELAY = 4;
+        static constexpr int MAX_DELAY = 1024;
+
+        int delay = MIN_DELAY;
+
+    public:
+        void pause(){
+            if (delay > MAX_DELAY){
+                std::this_thread::yield();
+                return;
+            }
+            for (int i = 0; i < delay; i++){
+                cpuRelax();
+            }
+            delay *= 2;
+        }
+};
+
+/**
+ * Exponential backoff with jitter: spin a random time up to a window that doubles
+ * after every failure. Threads that failed together retry apart instead of
+ * colliding again in lockstep.
+ */
+class RandomizedBackoff {
+    private:
+        static constexpr std::uint32_t MIN_WINDOW = 8;
+        static constexpr std::uint32_t MAX_WINDOW = 4096;
+
+        std::uint32_t window = MIN_WINDOW;
+
+        /**
+         * @return the calling thread's next pseudo random number, xorshift
+         */
+        static std::uint32_t next(){
+            thread_local std::uint32_t state = static_cast<std::uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1;
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+    public:
+        void pause(){
+            std::uint32_t spins = next() % window + 1;
+            for (std::uint32_t i = 0; i < spins; i++){
+                cpuRelax();
+            }
+            if (window < MAX_WINDOW){
+                window *= 2;
+            }
+        }
+};
+
+/**
+ * Spin briefly for the first Tries failures, then yield on every one after. Best
+ * when threads outnumber cores and the winner may be waiting for a core.
+ */
+template<int Tries = 8> class YieldBackoff {
+    private:
+        int failures = 0;
+
+    public:
+        void pause(){
+            if (failures < Tries){
+                failures++;
+                cpuRelax();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+};
+
+#endif
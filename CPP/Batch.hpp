@@ -0,0 +1,47 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+//
+// Used for sorting the batch
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "Order.hpp"
+
+/**
+ * One item of a batch: its key, and where it sits in the caller's vector.
+ */
+class BatchEntry {
+    public:
+        std::size_t key;
+        std::size_t index;
+};
+
+/**
+ * Sort a batch into list order for a single merged traversal. Equal items keep
+ * their order, so the first of them is the one that gets added or removed.
+ * @param items the batch, in the caller's order
+ * @return one entry per item, in the list's (key, item) order
+ */
+template<typename Order, typename T> std::vector<BatchEntry> sortBatch(const std::vector<T>& items){
+    std::vector<BatchEntry> entries;
+    entries.reserve(items.size());
+    for (std::size_t i = 0; i < items.size(); i++){
+        entries.push_back(BatchEntry{Order::key(items[i]), i});
+    }
+    std::sort(entries.begin(), entries.end(), [&](const BatchEntry& a, const BatchEntry& b){
+        if (a.key != b.key){
+            return a.key < b.key;
+        }
+        if (Order::less(items[a.index], items[b.index])){
+            return true;
+        }
+        if (Order::less(items[b.index], items[a.index])){
+            return false;
+        }
+        return a.index < b.index;
+    });
+    return entries;
+}
+
+#endif
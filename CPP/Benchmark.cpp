@@ -0,0 +1,245 @@
+#include "Benchmark.hpp"
+
+#include "CoarseList.hpp"
+#include "FineList.hpp"
+#include "OptimisticList.hpp"
+#include "LazyList.hpp"
+#include "LockFreeList.hpp"
+#include "LazySkipList.hpp"
+#include "LockFreeSkipList.hpp"
+#include "SplitOrderedHashSet.hpp"
+#include "StripedHashSet.hpp"
+#include "RefinableHashSet.hpp"
+#include "RcuList.hpp"
+#include "FlatCombiningList.hpp"
+#include "UnrolledList.hpp"
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+using BenchmarkRunner = std::function<BenchmarkResult(const BenchmarkConfig&, int)>;
+
+/**
+ * Register a list type under the name used on the command line.
+ */
+template<typename List> static void registerList(std::map<std::string, BenchmarkRunner>& lists, const std::string& name){
+    lists[name] = [name](const BenchmarkConfig& config, int threads){ return runBenchmark<List>(name, config, threads); };
+}
+
+/**
+ * Every list the benchmark knows, by the name used on the command line.
+ */
+static std::map<std::string, BenchmarkRunner> benchmarks(){
+    std::map<std::string, BenchmarkRunner> lists;
+    registerList<CoarseList<int>>(lists, "coarse");
+    registerList<FineList<int>>(lists, "fine");
+    registerList<OptimisticList<int>>(lists, "optimistic");
+    registerList<LazyList<int>>(lists, "lazy");
+    registerList<LockFreeList<int>>(lists, "lockfree");
+    registerList<LazyList<int, HazardPointerReclaimer>>(lists, "lazy-hp");
+    registerList<LockFreeList<int, HazardPointerReclaimer>>(lists, "lockfree-hp");
+    registerList<CoarseList<int, PoolAllocator<>>>(lists, "coarse-pool");
+    registerList<FineList<int, PoolAllocator<>>>(lists, "fine-pool");
+    registerList<OptimisticList<int, EpochReclaimer, PoolAllocator<>>>(lists, "optimistic-pool");
+    registerList<LazyList<int, EpochReclaimer, PoolAllocator<>>>(lists, "lazy-pool");
+    registerList<LockFreeList<int, EpochReclaimer, PoolAllocator<>>>(lists, "lockfree-pool");
+    registerList<LazySkipList<int>>(lists, "lazy-skiplist");
+    registerList<LockFreeSkipList<int>>(lists, "lockfree-skiplist");
+    registerList<SplitOrderedHashSet<int>>(lists, "split-ordered");
+    registerList<SplitOrderedHashSet<int, HazardPointerReclaimer>>(lists, "split-ordered-hp");
+    registerList<StripedHashSet<int>>(lists, "striped");
+    registerList<StripedHashSet<int, FineList<int>>>(lists, "striped-fine");
+    registerList<RefinableHashSet<int>>(lists, "refinable");
+    registerList<RefinableHashSet<int, FineList<int>>>(lists, "refinable-fine");
+    registerList<RcuList<int>>(lists, "rcu");
+    registerList<RcuList<int, HazardPointerReclaimer>>(lists, "rcu-hp");
+    registerList<FlatCombiningList<int>>(lists, "flat-combining");
+    registerList<UnrolledList<int>>(lists, "unrolled");
+    registerList<UnrolledList<int, 8>>(lists, "unrolled-8");
+    registerList<UnrolledList<int, 32>>(lists, "unrolled-32");
+    registerList<UnrolledList<int, 16, HazardPointerReclaimer>>(lists, "unrolled-hp");
+
+    //
+    // Lock policies. The plain names above use std::mutex for coarse and SpinLock for the rest.
+    using Hash = HashOrder<int>;
+    registerList<CoarseList<int, HeapAllocator, Hash, AdaptiveMutex>>(lists, "coarse-adaptive");
+    registerList<CoarseList<int, HeapAllocator, Hash, SpinLock>>(lists, "coarse-spin");
+    registerList<CoarseList<int, HeapAllocator, Hash, BackoffSpinLock>>(lists, "coarse-backoff");
+    registerList<CoarseList<int, HeapAllocator, Hash, MCSLock>>(lists, "coarse-mcs");
+    registerList<CoarseList<int, HeapAllocator, Hash, CLHLock>>(lists, "coarse-clh");
+    registerList<CoarseRWList<int>>(lists, "coarse-rw");
+    registerList<CoarseList<int, HeapAllocator, Hash, WriterPreferringRWLock>>(lists, "coarse-rw-writer");
+    registerList<FineList<int, HeapAllocator, Hash, std::mutex>>(lists, "fine-mutex");
+    registerList<FineList<int, HeapAllocator, Hash, BackoffSpinLock>>(lists, "fine-backoff");
+    registerList<FineList<int, HeapAllocator, Hash, MCSLock>>(lists, "fine-mcs");
+    registerList<FineList<int, HeapAllocator, Hash, CLHLock>>(lists, "fine-clh");
+    registerList<OptimisticList<int, EpochReclaimer, HeapAllocator, Hash, std::mutex>>(lists, "optimistic-mutex");
+    registerList<OptimisticList<int, EpochReclaimer, HeapAllocator, Hash, BackoffSpinLock>>(lists, "optimistic-backoff");
+    registerList<OptimisticList<int, EpochReclaimer, HeapAllocator, Hash, MCSLock>>(lists, "optimistic-mcs");
+    registerList<OptimisticList<int, EpochReclaimer, HeapAllocator, Hash, CLHLock>>(lists, "optimistic-clh");
+    registerList<LazyList<int, EpochReclaimer, HeapAllocator, Hash, std::mutex>>(lists, "lazy-mutex");
+    registerList<LazyList<int, EpochReclaimer, HeapAllocator, Hash, BackoffSpinLock>>(lists, "lazy-backoff");
+    registerList<LazyList<int, EpochReclaimer, HeapAllocator, Hash, MCSLock>>(lists, "lazy-mcs");
+    registerList<LazyList<int, EpochReclaimer, HeapAllocator, Hash, CLHLock>>(lists, "lazy-clh");
+
+    //
+    // Backoff policies for the retry loops. The plain names above use ExponentialBackoff.
+    registerList<OptimisticList<int, EpochReclaimer, HeapAllocator, Hash, SpinLock, NoBackoff>>(lists, "optimistic-nobackoff");
+    registerList<OptimisticList<int, EpochReclaimer, HeapAllocator, Hash, SpinLock, RandomizedBackoff>>(lists, "optimistic-random");
+    registerList<OptimisticList<int, EpochReclaimer, HeapAllocator, Hash, SpinLock, YieldBackoff<>>>(lists, "optimistic-yield");
+    registerList<LazyList<int, EpochReclaimer, HeapAllocator, Hash, SpinLock, NoBackoff>>(lists, "lazy-nobackoff");
+    registerList<LazyList<int, EpochReclaimer, HeapAllocator, Hash, SpinLock, RandomizedBackoff>>(lists, "lazy-random");
+    registerList<LazyList<int, EpochReclaimer, HeapAllocator, Hash, SpinLock, YieldBackoff<>>>(lists, "lazy-yield");
+    registerList<LockFreeList<int, EpochReclaimer, HeapAllocator, Hash, NoBackoff>>(lists, "lockfree-nobackoff");
+    registerList<LockFreeList<int, EpochReclaimer, HeapAllocator, Hash, RandomizedBackoff>>(lists, "lockfree-random");
+    registerList<LockFreeList<int, EpochReclaimer, HeapAllocator, Hash, YieldBackoff<>>>(lists, "lockfree-yield");
+
+    //
+    // Instrumented builds, for the traversal, lock hold and allocation columns.
+    // Their throughput is not comparable with the plain names'.
+    registerList<CoarseList<int, HeapAllocator, Hash, std::mutex, Instrumented>>(lists, "coarse-instrumented");
+    registerList<FineList<int, HeapAllocator, Hash, SpinLock, Instrumented>>(lists, "fine-instrumented");
+    registerList<OptimisticList<int, EpochReclaimer, HeapAllocator, Hash, SpinLock, ExponentialBackoff, Instrumented>>(lists, "optimistic-instrumented");
+    registerList<LazyList<int, EpochReclaimer, HeapAllocator, Hash, SpinLock, ExponentialBackoff, Instrumented>>(lists, "lazy-instrumented");
+    registerList<LockFreeList<int, EpochReclaimer, HeapAllocator, Hash, ExponentialBackoff, Instrumented>>(lists, "lockfree-instrumented");
+    return lists;
+}
+
+/**
+ * Split "a,b,c" (or "a/b/c") into its parts.
+ */
+static std::vector<std::string> split(const std::string& text, char separator){
+    std::vector<std::string> parts;
+    std::stringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)){
+        if (!part.empty()){
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+static void usage(){
+    std::cerr << "usage: benchmark [options]\n"
+              << "  --lists coarse,fine,optimistic,lazy,lockfree   lists to run (default: those five)\n"
+              << "  --threads 1,2,4,8       thread counts, one run each (default: 1,2,4,8)\n"
+              << "  --threads max           powers of two up to every core, for scaling curves\n"
+              << "  --range N               keys are drawn from [0, N) (default: 1024)\n"
+              << "  --prefill N             keys inserted before timing (default: range / 2)\n"
+              << "  --mix R/I/D             read/insert/delete percentages (default: 90/5/5)\n"
+              << "  --seconds S             duration of every run (default: 1)\n"
+              << "  --sample N              time one op out of every N (default: 1)\n"
+              << "  --format csv|json       output format (default: csv)\n"
+              << "  --help                  this text, and every list name\n";
+}
+
+int main(int argc, char** argv){
+    BenchmarkConfig config;
+    std::vector<std::string> lists = {"coarse", "fine", "optimistic", "lazy", "lockfree"};
+    std::vector<int> threadCounts = {1, 2, 4, 8};
+    std::string format = "csv";
+    bool prefillGiven = false;
+
+    auto available = benchmarks();
+
+    for (int i = 1; i < argc; i++){
+        std::string option = argv[i];
+        if (option == "--help"){
+            usage();
+            std::cerr << "lists:";
+            for (auto& entry : available){
+                std::cerr << ' ' << entry.first;
+            }
+            std::cerr << '\n';
+            return 0;
+        }
+        if (i + 1 >= argc){
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+
+        if (option == "--lists"){
+            lists = split(value, ',');
+        }
+        else if (option == "--threads"){
+            threadCounts.clear();
+            if (value == "max"){
+                int cores = static_cast<int>(std::thread::hardware_concurrency());
+                for (int count = 1; count < cores; count *= 2){
+                    threadCounts.push_back(count);
+                }
+                threadCounts.push_back(cores > 0 ? cores : 1);
+            }
+            else {
+                for (const std::string& count : split(value, ',')){
+                    threadCounts.push_back(std::atoi(count.c_str()));
+                }
+            }
+        }
+        else if (option == "--range"){
+            config.keyRange = std::atoi(value.c_str());
+        }
+        else if (option == "--prefill"){
+            config.prefill = std::atoi(value.c_str());
+            prefillGiven = true;
+        }
+        else if (option == "--mix"){
+            std::vector<std::string> mix = split(value, '/');
+            if (mix.size() != 3){
+                usage();
+                return 1;
+            }
+            config.readPercent = std::atoi(mix[0].c_str());
+            config.insertPercent = std::atoi(mix[1].c_str());
+            config.deletePercent = std::atoi(mix[2].c_str());
+        }
+        else if (option == "--seconds"){
+            config.seconds = std::atof(value.c_str());
+        }
+        else if (option == "--sample"){
+            config.sampleEvery = std::atoi(value.c_str());
+        }
+        else if (option == "--format"){
+            format = value;
+        }
+        else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (!prefillGiven){
+        config.prefill = config.keyRange / 2;
+    }
+    if (config.keyRange <= 0 || config.readPercent + config.insertPercent + config.deletePercent != 100){
+        std::cerr << "the key range must be positive and the mix must add up to 100\n";
+        return 1;
+    }
+
+    std::vector<BenchmarkResult> results;
+    for (const std::string& name : lists){
+        auto entry = available.find(name);
+        if (entry == available.end()){
+            std::cerr << "unknown list: " << name << '\n';
+            return 1;
+        }
+        for (int threads : threadCounts){
+            results.push_back(entry->second(config, threads));
+            std::cerr << name << " x" << threads << ": " << static_cast<std::uint64_t>(results.back().opsPerSecond()) << " ops/s\n";
+        }
+    }
+
+    if (format == "json"){
+        writeJson(std::cout, config, results);
+    }
+    else {
+        writeCsv(std::cout, config, results);
+    }
+    return 0;
+}
@@ -0,0 +1,286 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+//
+// Used for timing
+#include <chrono>
+//
+// Used for the worker threads
+#include <atomic>
+#include <thread>
+#include <vector>
+//
+// Used for the report
+#include <cstdint>
+#include <ostream>
+#include <string>
+//
+// Used for the retry and instrumentation columns and the latency percentiles
+#include "StripedCounter.hpp"
+#include "LatencyHistogram.hpp"
+#include "Instrumentation.hpp"
+//
+// Used for the instructions per operation
+#include "InstructionCounter.hpp"
+
+/**
+ * Workload description for one benchmark run.
+ */
+class BenchmarkConfig {
+    public:
+        //
+        // Keys are drawn uniformly from [0, keyRange).
+        int keyRange = 1024;
+
+        //
+        // How many distinct keys are inserted before the clock starts.
+        int prefill = 512;
+
+        //
+        // Operation mix in percent, they add up to 100.
+        int readPercent = 90;
+        int insertPercent = 5;
+        int deletePercent = 5;
+
+        //
+        // How long every thread count runs.
+        double seconds = 1.0;
+
+        //
+        // Time one operation out of every sampleEvery. 1 times all of them.
+        int sampleEvery = 1;
+};
+
+/**
+ * What one (list, thread count) run measured.
+ */
+class BenchmarkResult {
+    public:
+        std::string list;
+        int threads = 0;
+        std::uint64_t operations = 0;
+        double seconds = 0;
+        LatencyHistogram latency;
+
+        //
+        // sizeof one element's node, what the list costs per item.
+        std::size_t nodeBytes = 0;
+
+        //
+        // The list's retry counters, all 0 for a list without retryStats().
+        RetryStats retries;
+
+        //
+        // What an instrumented list recorded, empty for the rest.
+        InstrumentationReport instrumentation;
+
+        //
+        // User space instructions the workers retired in the timed part, 0 where
+        // there is no hardware counter. Includes the loop, the random numbers and
+        // the latency clock, the same for every list.
+        std::uint64_t instructions = 0;
+
+        double opsPerSecond() const {
+            return seconds > 0 ? static_cast<double>(operations) / seconds : 0;
+        }
+
+        double instructionsPerOperation() const {
+            return operations > 0 ? static_cast<double>(instructions) / static_cast<double>(operations) : 0;
+        }
+};
+
+/**
+ * Small, fast per-thread random numbers (xorshift64*).
+ */
+class BenchmarkRandom {
+    private:
+        std::uint64_t state;
+
+    public:
+        explicit BenchmarkRandom(std::uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+        std::uint64_t next(){
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 0x2545F4914F6CDD1DULL;
+        }
+
+        /**
+         * @return a number in [0, bound)
+         */
+        int below(int bound){
+            return static_cast<int>((next() >> 32) % static_cast<std::uint64_t>(bound));
+        }
+};
+
+/**
+ * Run one workload against a freshly built List with the given number of threads.
+ *
+ * List needs add(int), remove(int), contains(int) and a static nodeSize(). If it
+ * has retryStats() or instrumentation(), the numbers of the timed part go in the result.
+ */
+template<typename List> BenchmarkResult runBenchmark(const std::string& name, const BenchmarkConfig& config, int threads){
+    using Clock = std::chrono::steady_clock;
+
+    List list;
+
+    //
+    // Prefill with distinct random keys, so the list starts at its steady state size.
+    BenchmarkRandom prefillRandom(12345);
+    int inserted = 0;
+    while (inserted < config.prefill && inserted < config.keyRange){
+        if (list.add(prefillRandom.below(config.keyRange))){
+            inserted++;
+        }
+    }
+
+    std::atomic<int> ready{0};
+    std::atomic<bool> start{false};
+    std::atomic<bool> stop{false};
+    std::vector<std::uint64_t> operations(threads, 0);
+    std::vector<std::uint64_t> instructions(threads, 0);
+    std::vector<LatencyHistogram> histograms(threads);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; t++){
+        workers.emplace_back([&, t]{
+            BenchmarkRandom random(static_cast<std::uint64_t>(t) + 1);
+            LatencyHistogram& histogram = histograms[t];
+            std::uint64_t done = 0;
+            InstructionCounter counter;
+
+            ready.fetch_add(1);
+            while (!start.load(std::memory_order_acquire)){
+                std::this_thread::yield();
+            }
+            counter.start();
+
+            while (!stop.load(std::memory_order_relaxed)){
+                int key = random.below(config.keyRange);
+                int dice = random.below(100);
+                bool timed = config.sampleEvery <= 1 || done % config.sampleEvery == 0;
+
+                Clock::time_point before;
+                if (timed){
+                    before = Clock::now();
+                }
+
+                if (dice < config.readPercent){
+                    list.contains(key);
+                }
+                else if (dice < config.readPercent + config.insertPercent){
+                    list.add(key);
+                }
+                else {
+                    list.remove(key);
+                }
+
+                if (timed){
+                    histogram.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - before).count()));
+                }
+                done++;
+            }
+            counter.stop();
+            operations[t] = done;
+            instructions[t] = counter.count();
+        });
+    }
+
+    while (ready.load() < threads){
+        std::this_thread::yield();
+    }
+    RetryStats prefillRetries;
+    if constexpr (hasRetryStats<List>::value){
+        prefillRetries = list.retryStats();
+    }
+    InstrumentationReport prefillInstrumentation;
+    if constexpr (hasInstrumentation<List>::value){
+        prefillInstrumentation = list.instrumentation();
+    }
+    Clock::time_point begin = Clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::duration<double>(config.seconds));
+    stop.store(true);
+    for (std::thread& worker : workers){
+        worker.join();
+    }
+    Clock::time_point end = Clock::now();
+
+    BenchmarkResult result;
+    result.list = name;
+    result.threads = threads;
+    result.nodeBytes = List::nodeSize();
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    for (int t = 0; t < threads; t++){
+        result.operations += operations[t];
+        result.instructions += instructions[t];
+        result.latency.merge(histograms[t]);
+    }
+    if constexpr (hasRetryStats<List>::value){
+        RetryStats stats = list.retryStats();
+        result.retries.operations = stats.operations - prefillRetries.operations;
+        result.retries.retries = stats.retries - prefillRetries.retries;
+        result.retries.restarts = stats.restarts - prefillRetries.restarts;
+        result.retries.lockWaits = stats.lockWaits - prefillRetries.lockWaits;
+        result.retries.lockWaitNanos = stats.lockWaitNanos - prefillRetries.lockWaitNanos;
+    }
+    if constexpr (hasInstrumentation<List>::value){
+        result.instrumentation = list.instrumentation();
+        result.instrumentation.subtract(prefillInstrumentation);
+    }
+    return result;
+}
+
+/**
+ * Write results as CSV, one row per (list, thread count).
+ */
+inline void writeCsv(std::ostream& out, const BenchmarkConfig& config, const std::vector<BenchmarkResult>& results){
+    out << "list,threads,key_range,prefill,read_pct,insert_pct,delete_pct,operations,seconds,ops_per_sec,p50_ns,p99_ns,p999_ns,node_bytes,retries_per_update,lock_waits,lock_wait_ns,traversed_p50,traversed_p99,lock_hold_p50_ns,lock_hold_p99_ns,allocations,frees,instructions_per_op\n";
+    for (const BenchmarkResult& result : results){
+        out << result.list << ',' << result.threads << ','
+            << config.keyRange << ',' << config.prefill << ','
+            << config.readPercent << ',' << config.insertPercent << ',' << config.deletePercent << ','
+            << result.operations << ',' << result.seconds << ',' << static_cast<std::uint64_t>(result.opsPerSecond()) << ','
+            << result.latency.valueAt(50) << ',' << result.latency.valueAt(99) << ',' << result.latency.valueAt(99.9) << ','
+            << result.nodeBytes << ',' << result.retries.retriesPerOperation() << ','
+            << result.retries.lockWaits << ',' << result.retries.lockWaitNanos << ',';
+        const InstrumentationReport& numbers = result.instrumentation;
+        LatencyHistogram traversed = numbers.traversedByAll();
+        out << traversed.valueAt(50) << ',' << traversed.valueAt(99) << ','
+            << numbers.lockHold.valueAt(50) << ',' << numbers.lockHold.valueAt(99) << ','
+            << numbers.allocations << ',' << numbers.frees << ','
+            << result.instructionsPerOperation() << '\n';
+    }
+}
+
+/**
+ * Write results as a JSON document with the config and one entry per run.
+ */
+inline void writeJson(std::ostream& out, const BenchmarkConfig& config, const std::vector<BenchmarkResult>& results){
+    out << "{\n"
+        << "  \"config\": {\"key_range\": " << config.keyRange << ", \"prefill\": " << config.prefill
+        << ", \"read_pct\": " << config.readPercent << ", \"insert_pct\": " << config.insertPercent
+        << ", \"delete_pct\": " << config.deletePercent << ", \"seconds\": " << config.seconds << "},\n"
+        << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++){
+        const BenchmarkResult& result = results[i];
+        const InstrumentationReport& numbers = result.instrumentation;
+        LatencyHistogram traversed = numbers.traversedByAll();
+        out << "    {\"list\": \"" << result.list << "\", \"threads\": " << result.threads
+            << ", \"operations\": " << result.operations << ", \"seconds\": " << result.seconds
+            << ", \"ops_per_sec\": " << static_cast<std::uint64_t>(result.opsPerSecond())
+            << ", \"p50_ns\": " << result.latency.valueAt(50) << ", \"p99_ns\": " << result.latency.valueAt(99)
+            << ", \"p999_ns\": " << result.latency.valueAt(99.9) << ", \"node_bytes\": " << result.nodeBytes
+            << ", \"retries_per_update\": " << result.retries.retriesPerOperation()
+            << ", \"lock_waits\": " << result.retries.lockWaits << ", \"lock_wait_ns\": " << result.retries.lockWaitNanos
+            << ", \"traversed_p50\": " << traversed.valueAt(50) << ", \"traversed_p99\": " << traversed.valueAt(99)
+            << ", \"lock_hold_p50_ns\": " << numbers.lockHold.valueAt(50) << ", \"lock_hold_p99_ns\": " << numbers.lockHold.valueAt(99)
+            << ", \"allocations\": " << numbers.allocations << ", \"frees\": " << numbers.frees
+            << ", \"instructions_per_op\": " << result.instructionsPerOperation() << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+#endif
@@ -1,3 +1,5 @@
+#include <iostream>
+
 #include "CoarseList.hpp"
 
 
@@ -6,11 +8,11 @@ int main()
     CoarseList<int>* list = new CoarseList<int>;
     list->add(1);
     bool a = list->contains(1);
-    cout << a << "\n";
+    std::cout << a << "\n";
     bool remove = list->remove(1);
-    cout << remove << "\n";
+    std::cout << remove << "\n";
     a = list->contains(1);
-    cout << a << "\n";
+    std::cout << a << "\n";
 
     delete list;
 
@@ -5,18 +5,46 @@
 // Used for hashing
 #include <functional>
 //
-// Used for printing
-#include <iostream>
-//
-// Used for locks
+// Used for locks and the element count
+#include <atomic>
 #include <mutex>
-
-using namespace std;
+#include <shared_mutex>
+#include <type_traits>
+#include "SpinLock.hpp"
+#include "RWLock.hpp"
+#include "QueueLock.hpp"
+//
+// Used for batches
+#include <vector>
+#include "Batch.hpp"
+//
+// Item order
+#include "Order.hpp"
+//
+// Node allocation, and reporting when it fails
+#include <new>
+#include <utility>
+#include "AddStatus.hpp"
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Opt-in latency, traversal, lock and allocation numbers
+#include "Instrumentation.hpp"
 
 /**
  * Generic template for a Linked List.
+ *
+ * Allocator creates and destroys the nodes, HeapAllocator or PoolAllocator.
+ * Order sorts the items, HashOrder or DirectOrder.
+ * Lock is the list lock: std::mutex, AdaptiveMutex, SpinLock, BackoffSpinLock,
+ * MCSLock or CLHLock. Every operation walks the list under it, so one that parks
+ * (std::mutex, AdaptiveMutex) keeps waiters from burning their cores. A reader-writer
+ * lock (std::shared_mutex, WriterPreferringRWLock) lets contains(), containsAll()
+ * and forEach() run side by side under its shared mode.
+ * Instrumentation is NoInstrumentation, or Instrumented to record add(), remove()
+ * and contains(); see instrumentation().
  */
-template<typename T> class CoarseList {
+template<typename T, typename Allocator = HeapAllocator, typename Order = HashOrder<T>, typename Lock = std::mutex, typename Instrumentation = NoInstrumentation> class CoarseList {
     private: 
         /**
          * Inner nested node class.
@@ -28,7 +56,7 @@ template<typename T> class CoarseList {
                 T item; 
 
                 //
-                // Hash of the item.
+                // Order's key for the item
                 size_t key;
 
                 //
@@ -60,11 +88,54 @@ template<typename T> class CoarseList {
 
         //
         // Lock for the coarse grained implementation.
-        std::mutex lock;
+        Lock lock;
+
+        //
+        // Number of elements. Only written under the lock, so one counter is enough,
+        // and read without it.
+        std::atomic<std::size_t> count{0};
 
         //
-        // The std hashing object, so we don't need to initate it multiple times.
-        hash<T> hasher;
+        // Per-thread numbers, if Instrumentation records any.
+        Instrumentation instruments;
+
+        using Probe = typename Instrumentation::Probe;
+
+        /**
+         * Does node come before (key, item)? The tail comes after everything.
+         */
+        bool before(const Node* node, size_t key, const T& item) const {
+            return node != &tail && precedes<Order>(node->key, node->item, key, item);
+        }
+
+        /**
+         * Does node hold item? Only asked once before() is false.
+         */
+        bool holds(const Node* node, size_t key, const T& item) const {
+            return node != &tail && node->key == key && !Order::less(item, node->item);
+        }
+
+        //
+        // Guards for read-only operations, shared if Lock has a shared mode.
+        using ReadGuard = std::conditional_t<isSharedLockable<Lock>::value, std::shared_lock<Lock>, std::unique_lock<Lock>>;
+        using ProbedReadGuard = std::conditional_t<isSharedLockable<Lock>::value, ProbedSharedLock<Probe, Lock>, ProbedLock<Probe, Lock>>;
+
+        /**
+         * Walk to the first node not before (key, item). The lock is held.
+         * @return the window (prev, curr)
+         */
+        std::pair<Node*, Node*> seek(size_t key, const T& item, Probe& probe){
+            Node* prev = &head;
+            Node* curr = prev->next;
+            std::size_t traversed = 0;
+            while (before(curr, key, item)){
+                prev = curr;
+                curr = curr->next;
+                traversed++;
+            }
+            probe.traversed(traversed);
+            return {prev, curr};
+        }
 
     public: 
         /**
@@ -75,31 +146,19 @@ template<typename T> class CoarseList {
         }
 
         /**
-         * The destructor for the FineList. It clears all dynamically allocated memory.
+         * The destructor for the CoarseList. It clears all dynamically allocated memory.
          * What happens if this is called while other threads are doing work?
          */
         ~CoarseList(){
-            Node* curr;
-            Node* temp;
-
             //
             // Acquire the only lock. No one can do anything now..
-            lock.lock();
+            std::lock_guard<Lock> guard(lock);
 
-            try{
-                curr = head.next;
-
-                while (curr != &tail){
-                    temp = curr;
-                    curr = curr->next;
-                    delete temp;
-                }
-
-                lock.unlock();
-            }
-            catch (...) {
-                lock.unlock();
-                cout << "Something went wrong during destruction of CoarseList object \n";
+            Node* curr = head.next;
+            while (curr != &tail){
+                Node* temp = curr;
+                curr = curr->next;
+                Allocator::destroy(temp);
             }
         }
 
@@ -107,49 +166,53 @@ template<typename T> class CoarseList {
          * Add an element.
          * @param item element to add
          * @return true iff element was not there already
+         * @throws std::bad_alloc if there is no memory for the node, the list is unchanged
          */
         bool add(T item) {
+            AddStatus status = tryAdd(item);
+            if (status == AddStatus::OUT_OF_MEMORY){
+                throw std::bad_alloc();
+            }
+            return status == AddStatus::ADDED;
+        }
+
+        /**
+         * Add an element without throwing.
+         * @param item element to add
+         * @return ADDED, PRESENT if it was there already, or OUT_OF_MEMORY
+         */
+        AddStatus tryAdd(T item) noexcept {
             //
-            // Get the hash of the item we are trying to insert.
-            size_t key = hasher(item);
-            Node* prev;
-            Node* curr;
-            
+            // Get the key of the item we are trying to insert.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::ADD);
+
             //
             // Acquire the only lock. No one can do anything now..
-            lock.lock();
-            try {
-                //
-                // Find the spot we need to add this item to.
-                prev = &head;
-                curr = prev->next;
-                while (curr->key < key){
-                    prev = curr;
-                    curr = curr->next;
-                }
+            ProbedLock<Probe, Lock> guard(probe, lock);
 
-                //
-                // If the item already exists in the list, return false.
-                if (key == curr->key){
-                    lock.unlock();
-                    return false;
-                }
-                
-                //
-                // Insert the node.
-                Node* newNode = new Node(item, key);
-
-                newNode->next = curr;
-                prev->next = newNode;
-
-                lock.unlock();
-                return true;
-                
-            } catch (...) {
-                lock.unlock();
-                cout << "Something went wrong during add(). \n";
-                return false;
+            //
+            // Find the spot we need to add this item to.
+            auto [prev, curr] = seek(key, item, probe);
+
+            //
+            // If the item already exists in the list, there is nothing to do.
+            if (holds(curr, key, item)){
+                return AddStatus::PRESENT;
             }
+
+            //
+            // Insert the node.
+            Node* newNode = Allocator::template tryCreate<Node>(item, key);
+            if (newNode == nullptr){
+                return AddStatus::OUT_OF_MEMORY;
+            }
+            probe.allocated();
+
+            newNode->next = curr;
+            prev->next = newNode;
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            return AddStatus::ADDED;
         }
 
         /**
@@ -159,45 +222,31 @@ template<typename T> class CoarseList {
          */
         bool remove(T item) {
             //
-            // Get the hash of the item we are trying to insert.
-            size_t key = hasher(item);
-            Node* prev;
-            Node* curr;
-            
+            // Get the key of the item we are trying to remove.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::REMOVE);
 
             //
             // Acquire the only lock. No one can do anything now..
-            lock.lock();
-            try {
-                //
-                // Find the spot we need to add this item to.
-                prev = &head;
-                curr = prev->next;
-                while (curr->key < key){
-                    prev = curr;
-                    curr = curr->next;
-                }
+            ProbedLock<Probe, Lock> guard(probe, lock);
 
-                //
-                // If the item does not exist in the list, return false.
-                if (key != curr->key){
-                    lock.unlock();
-                    return false;
-                }
+            //
+            // Find the spot we need to remove the item from.
+            auto [prev, curr] = seek(key, item, probe);
 
-                //
-                // Remove the node
-                prev->next = curr->next;
-                delete curr;
-
-                lock.unlock();
-                return true;
-                
-            } catch (...) {
-                lock.unlock();
-                cout << "Something went wrong during remove(). \n";
+            //
+            // If the item does not exist in the list, return false.
+            if (!holds(curr, key, item)){
                 return false;
             }
+
+            //
+            // Remove the node
+            prev->next = curr->next;
+            Allocator::destroy(curr);
+            probe.freed();
+            count.store(count.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+            return true;
         }
 
         /**
@@ -207,44 +256,215 @@ template<typename T> class CoarseList {
          */
         bool contains(T item) {
             //
-            // Get the hash of the item we are trying to find.
-            size_t key = hasher(item);
-            Node* prev;
-            Node* curr;
-            
+            // Get the key of the item we are trying to find.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::CONTAINS);
+
+            //
+            // Acquire the lock for reading. Only writers are kept out.
+            ProbedReadGuard guard(probe, lock);
+
+            Node* curr = seek(key, item, probe).second;
+            return holds(curr, key, item);
+        }
+
+        /**
+         * Add every element of a batch, taking the lock once and walking the list once.
+         * The whole batch is atomic.
+         * @param items elements to add, in any order
+         * @param results if not null, results[i] is what add(items[i]) would have returned
+         * @return how many elements were added
+         * @throws std::bad_alloc if there is no memory for a node, the elements added
+         *         before it stay in the list
+         */
+        std::size_t addAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            std::size_t added = 0;
+            bool outOfMemory = false;
+            {
+                //
+                // Acquire the only lock. No one can do anything now..
+                std::lock_guard<Lock> guard(lock);
+
+                Node* prev = &head;
+                Node* curr = prev->next;
+                for (const BatchEntry& entry : batch){
+                    //
+                    // Pick up where the last key left off.
+                    while (before(curr, entry.key, items[entry.index])){
+                        prev = curr;
+                        curr = curr->next;
+                    }
+
+                    //
+                    // If the item already exists in the list, skip it.
+                    if (holds(curr, entry.key, items[entry.index])){
+                        continue;
+                    }
+
+                    //
+                    // Insert the node, and keep going from it.
+                    Node* newNode = Allocator::template tryCreate<Node>(items[entry.index], entry.key);
+                    if (newNode == nullptr){
+                        outOfMemory = true;
+                        break;
+                    }
+                    newNode->next = curr;
+                    prev->next = newNode;
+                    curr = newNode;
+
+                    added++;
+                    if (results != nullptr){
+                        (*results)[entry.index] = true;
+                    }
+                }
+                count.store(count.load(std::memory_order_relaxed) + added, std::memory_order_release);
+            }
+            if (outOfMemory){
+                throw std::bad_alloc();
+            }
+            return added;
+        }
+
+        /**
+         * Remove every element of a batch, taking the lock once and walking the list once.
+         * The whole batch is atomic.
+         * @param items elements to remove, in any order
+         * @param results if not null, results[i] is what remove(items[i]) would have returned
+         * @return how many elements were removed
+         */
+        std::size_t removeAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            std::size_t removed = 0;
 
             //
             // Acquire the only lock. No one can do anything now..
-            lock.lock();
-            try {
+            std::lock_guard<Lock> guard(lock);
+
+            Node* prev = &head;
+            Node* curr = prev->next;
+            for (const BatchEntry& entry : batch){
                 //
-                // Find the spot we need to add this item to.
-                prev = &head;
-                curr = prev->next;
-                while (curr->key < key){
+                // Pick up where the last key left off.
+                while (before(curr, entry.key, items[entry.index])){
                     prev = curr;
                     curr = curr->next;
                 }
 
                 //
-                // If the item  exists in the list, return true.
-                if (key == curr->key){
-                    lock.unlock();
-                    return true;
+                // If the item does not exist in the list, skip it.
+                if (!holds(curr, entry.key, items[entry.index])){
+                    continue;
                 }
-                else {
-                    lock.unlock();
-                    return false;
+
+                //
+                // Remove the node
+                prev->next = curr->next;
+                Allocator::destroy(curr);
+                curr = prev->next;
+
+                removed++;
+                if (results != nullptr){
+                    (*results)[entry.index] = true;
                 }
+            }
+            count.store(count.load(std::memory_order_relaxed) - removed, std::memory_order_release);
+            return removed;
+        }
 
-            } catch (...) {
-                lock.unlock();
-                cout << "Something went wrong during contains(). \n";
-                return false;
+        /**
+         * Test a whole batch, taking the lock once and walking the list once.
+         * The whole batch is atomic.
+         * @param items elements to test, in any order
+         * @param results if not null, results[i] is what contains(items[i]) would have returned
+         * @return true iff every element is present
+         */
+        bool containsAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
             }
+            bool all = true;
+
+            //
+            // Acquire the lock for reading. Only writers are kept out.
+            ReadGuard guard(lock);
+
+            Node* curr = head.next;
+            for (const BatchEntry& entry : batch){
+                while (before(curr, entry.key, items[entry.index])){
+                    curr = curr->next;
+                }
+
+                bool found = holds(curr, entry.key, items[entry.index]);
+                all = all && found;
+                if (results != nullptr){
+                    (*results)[entry.index] = found;
+                }
+            }
+            return all;
+        }
+
+        /**
+         * Call f on every element, in list order, holding the lock for reading.
+         * The lock is released if f throws.
+         * @param f called with each item
+         */
+        template<typename F> void forEach(F f) {
+            //
+            // Acquire the lock for reading. Only writers are kept out.
+            ReadGuard guard(lock);
+
+            for (Node* curr = head.next; curr != &tail; curr = curr->next){
+                f(curr->item);
+            }
+        }
+
+        /**
+         * Number of elements, without taking the lock. Every update changes it in the
+         * same critical section as the list, so it is exact.
+         * @return the element count
+         */
+        std::size_t size() const {
+            return count.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Same as size(), kept so every list has it.
+         * @return the element count
+         */
+        std::size_t exactSize() const {
+            return size();
+        }
+
+        /**
+         * @return bytes per element, for the benchmark's memory column
+         */
+        static constexpr std::size_t nodeSize(){
+            return sizeof(Node);
+        }
+
+        /**
+         * What add(), remove() and contains() recorded, empty unless Instrumentation
+         * is Instrumented. Batches are not recorded.
+         * @return the numbers so far, merged over threads
+         */
+        InstrumentationReport instrumentation() const {
+            return instruments.report();
         }
 };
 
+/**
+ * CoarseList with a reader-writer lock: lookups share it, updates take it alone.
+ */
+template<typename T, typename Allocator = HeapAllocator, typename Order = HashOrder<T>> using CoarseRWList = CoarseList<T, Allocator, Order, std::shared_mutex>;
+
 
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,221 @@
+#ifndef EPOCH_RECLAIMER_HPP
+#define EPOCH_RECLAIMER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "ThreadRegistry.hpp"
+
+/**
+ * Safe memory reclamation with epochs (K. Fraser).
+ *
+ * An operation announces the global epoch when it starts and clears it when it is
+ * done. The epoch only moves forward once every running operation has seen the
+ * current one, so a node retired during epoch e can't be reached by anybody once
+ * the global epoch is two past it.
+ *
+ * Traversals are plain loads, and entering costs one store and one fence per
+ * operation. The downside is that a thread stalled inside an operation holds
+ * back all reclamation.
+ */
+class EpochReclaimer {
+    public:
+        //
+        // Kept for symmetry with HazardPointerReclaimer, epochs need no slots.
+        static constexpr int SLOTS = 5;
+
+        //
+        // Nothing retired after an operation started is freed before it ends.
+        static constexpr bool validatesTraversal = false;
+
+    private:
+        /**
+         * A node waiting to be freed, and the epoch it becomes safe in.
+         */
+        class Retired {
+            public:
+                void* pointer;
+                void (*deleter)(void*);
+                std::uint64_t safeEpoch;
+        };
+
+        /**
+         * Per-thread announced epoch and retired list.
+         */
+        class alignas(CACHE_LINE_SIZE) Record {
+            public:
+                std::atomic<bool> inUse{false};
+                Record* nextRecord = nullptr;
+
+                //
+                // Epoch the current operation started in, 0 while idle.
+                std::atomic<std::uint64_t> localEpoch{0};
+
+                std::vector<Retired> retired;
+        };
+
+        //
+        // Retire this many nodes before trying to move the epoch and free a batch.
+        static constexpr std::size_t BATCH_SIZE = 64;
+
+        //
+        // Starts at 1, 0 means "not in an operation".
+        std::atomic<std::uint64_t> globalEpoch{1};
+
+        ThreadRegistry<Record> registry;
+
+        /**
+         * Move the global epoch forward if every running operation has seen it.
+         */
+        void tryAdvance(){
+            std::uint64_t epoch = globalEpoch.load(std::memory_order_acquire);
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (Record* curr = registry.first(); curr != nullptr; curr = curr->nextRecord){
+                std::uint64_t local = curr->localEpoch.load(std::memory_order_acquire);
+                if (local != 0 && local != epoch){
+                    return;
+                }
+            }
+            globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+        }
+
+        /**
+         * Free every node of record whose safe epoch has been reached.
+         */
+        void collect(Record* record){
+            tryAdvance();
+            std::uint64_t epoch = globalEpoch.load(std::memory_order_acquire);
+
+            std::size_t kept = 0;
+            for (Retired& node : record->retired){
+                if (node.safeEpoch > epoch){
+                    record->retired[kept++] = node;
+                }
+                else {
+                    node.deleter(node.pointer);
+                }
+            }
+            record->retired.resize(kept);
+        }
+
+    public:
+        /**
+         * RAII handle for one operation: pins the epoch while it is alive.
+         */
+        class Guard {
+            private:
+                EpochReclaimer& domain;
+                Record* record;
+
+                /**
+                 * Announce the global epoch.
+                 */
+                void enter(){
+                    record->localEpoch.store(domain.globalEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                }
+
+            public:
+                explicit Guard(EpochReclaimer& domain) : domain(domain), record(domain.registry.acquire()) {
+                    enter();
+                }
+
+                /**
+                 * Without throwing: if the thread needed a record and there is no
+                 * memory for one, the guard is empty and must not be used.
+                 */
+                Guard(EpochReclaimer& domain, const std::nothrow_t&) noexcept : domain(domain), record(domain.registry.tryAcquire()) {
+                    if (record != nullptr){
+                        enter();
+                    }
+                }
+
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+
+                /**
+                 * Leave the epoch and hand the record back.
+                 */
+                ~Guard(){
+                    if (record != nullptr){
+                        record->localEpoch.store(0, std::memory_order_release);
+                        domain.registry.release(record);
+                    }
+                }
+
+                /**
+                 * @return false for an empty guard
+                 */
+                explicit operator bool() const {
+                    return record != nullptr;
+                }
+
+                /**
+                 * Nothing to publish, a plain load is already safe.
+                 * @param load reads the shared pointer
+                 * @return the pointer
+                 */
+                template<typename Load> auto protect(int, Load load) -> decltype(load()) {
+                    return load();
+                }
+
+                /**
+                 * Make room to retire count more nodes, so the retire() calls that
+                 * follow cannot throw. Call it before the change they retire for.
+                 * @return false if there is no memory for the room
+                 */
+                bool reserve(std::size_t count) noexcept {
+                    std::vector<Retired>& retired = record->retired;
+                    std::size_t needed = retired.size() + count;
+                    if (needed <= retired.capacity()){
+                        return true;
+                    }
+                    try {
+                        retired.reserve(std::max(needed, 2 * retired.capacity()));
+                    }
+                    catch (const std::bad_alloc&){
+                        return false;
+                    }
+                    return true;
+                }
+
+                /**
+                 * Hand over a node that is no longer reachable from the list.
+                 * @param pointer the unlinked node
+                 * @param deleter frees it once nobody can be looking at it
+                 * @throws std::bad_alloc if the retired list has to grow, never after reserve()
+                 */
+                void retire(void* pointer, void (*deleter)(void*)){
+                    //
+                    // Any reader of this node started at most one epoch away from us,
+                    // so three epochs past ours nobody can still hold it.
+                    std::uint64_t local = record->localEpoch.load(std::memory_order_relaxed);
+                    record->retired.push_back(Retired{pointer, deleter, local + 3});
+
+                    if (record->retired.size() % BATCH_SIZE == 0){
+                        domain.collect(record);
+                    }
+                }
+        };
+
+        EpochReclaimer() = default;
+        EpochReclaimer(const EpochReclaimer&) = delete;
+        EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+        /**
+         * Destructor, frees everything still retired. No operation may be running.
+         */
+        ~EpochReclaimer(){
+            for (Record* curr = registry.first(); curr != nullptr; curr = curr->nextRecord){
+                for (Retired& node : curr->retired){
+                    node.deleter(node.pointer);
+                }
+                curr->retired.clear();
+            }
+        }
+};
+
+#endif
@@ -6,31 +6,62 @@
 // Used for hashing
 #include <functional>
 //
-// Used for printing
-#include <iostream>
-//
 // Used for locks
 #include <mutex>
+#include "SpinLock.hpp"
+#include "QueueLock.hpp"
+//
+// Used for batches
+#include <vector>
+#include "Batch.hpp"
+//
+// Item order
+#include "Order.hpp"
+//
+// Element count
+#include "StripedCounter.hpp"
+#include "UpdateTracker.hpp"
+//
+// Per-thread fingers, and the pins that keep their nodes alive
 #include <atomic>
-
-using namespace std;
+#include <cstdint>
+#include "ThreadRegistry.hpp"
+//
+// Node allocation, and reporting when it fails
+#include <new>
+#include "AddStatus.hpp"
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Opt-in latency, traversal, lock and allocation numbers
+#include "Instrumentation.hpp"
 
 /**
  * Generic template for a Linked List.
+ *
+ * Allocator creates and destroys the nodes, HeapAllocator or PoolAllocator.
+ * Order sorts the items, HashOrder or DirectOrder.
+ * Lock is the node lock: SpinLock, BackoffSpinLock, MCSLock, CLHLock or std::mutex.
+ * Instrumentation is NoInstrumentation, or Instrumented to record add(), remove()
+ * and contains(); see instrumentation().
+ *
+ * add(), remove() and contains() start from a finger, the node the calling thread's
+ * last operation ended at, if it is still in the list and comes before the item, and
+ * from the head otherwise. A thread working through ascending keys locks the head
+ * once and then only the nodes around each item. A Cursor is the same thing held by
+ * the caller, for add(item, cursor) and the others.
  */
-template<typename T> class FineList {
+template<typename T, typename Allocator = HeapAllocator, typename Order = HashOrder<T>, typename Lock = SpinLock, typename Instrumentation = NoInstrumentation> class FineList {
     private: 
         /**
-         * Inner nested node class.
+         * Inner nested node class. What every traversal reads, key and next, comes
+         * first, and the lock after them, a single byte with SpinLock. The pin count
+         * fits in the padding after it for most locks.
          */
         class Node{
             public:
                 //
-                // Item being stored
-                T item; 
-
-                //
-                // Hash of the item
+                // Order's key for the item
                 size_t key;
 
                 //
@@ -39,10 +70,17 @@ template<typename T> class FineList {
 
                 //
                 // Lock for a node.
-                std::mutex mutex;
-                // #TODO use recirsive mutex instead
-                // https://en.cppreference.com/w/cpp/thread/recursive_mutex
-                std::atomic<bool> isLocked{false};
+                Lock mutex;
+
+                //
+                // REMOVED once the node is unlinked and UNLOCKED once its remover is
+                // done with it, plus PIN for every finger and Cursor on it. The last of
+                // the remover and the pins frees it.
+                std::atomic<std::uint32_t> state{0};
+
+                //
+                // Item being stored
+                T item; 
 
                 /**
                  * Regular Node constructor 
@@ -63,21 +101,16 @@ template<typename T> class FineList {
 
                 /**
                  * Lock the node
-                 * #TODO use recirsive mutex instead
-                 * https://en.cppreference.com/w/cpp/thread/recursive_mutex
                  */
                 void lock(){
                     mutex.lock();
-                    isLocked.store(true);
                 }
 
                 /**
-                 * Unlock the node if locked.
+                 * Unlock the node
                  */
                 void unlock(){
-                    if (isLocked.exchange(false)) {
-                        mutex.unlock();
-                    }
+                    mutex.unlock();
                 }
         };
 
@@ -87,10 +120,434 @@ template<typename T> class FineList {
         Node tail;
 
         //
-        // The std hashing object, so we don't need to initate it multiple times.
-        hash<T> hasher;
+        // Brackets every insert and removal, so exactSize() can tell whether it raced one.
+        UpdateTracker updates;
+
+        //
+        // Successful adds and removes, counted inside the brackets.
+        StripedSize count;
+
+        //
+        // Per-thread numbers, if Instrumentation records any.
+        Instrumentation instruments;
+
+        using Probe = typename Instrumentation::Probe;
+
+        //
+        // Node state bits: the node is unlinked, its remover has unlocked it, and one pin.
+        static constexpr std::uint32_t REMOVED = 1;
+        static constexpr std::uint32_t UNLOCKED = 2;
+        static constexpr std::uint32_t PIN = 4;
+
+        /**
+         * Where a thread's last operation ended, kept between its operations.
+         */
+        class FingerRecord {
+            public:
+                std::atomic<bool> inUse{false};
+                FingerRecord* nextRecord = nullptr;
+
+                //
+                // A pinned node, or null for the head.
+                Node* node = nullptr;
+        };
+
+        ThreadRegistry<FingerRecord> fingers;
+
+        /**
+         * Does node come before (key, item)? The tail comes after everything.
+         */
+        bool before(const Node* node, size_t key, const T& item) const {
+            return node != &tail && precedes<Order>(node->key, node->item, key, item);
+        }
+
+        /**
+         * Does node hold item? Only asked once before() is false.
+         */
+        bool holds(const Node* node, size_t key, const T& item) const {
+            return node != &tail && node->key == key && !Order::less(item, node->item);
+        }
+
+        /**
+         * Has node been unlinked? Set under its lock, so a locked node that is not
+         * removed is still in the list.
+         */
+        static bool removed(const Node* node){
+            return (node->state.load(std::memory_order_relaxed) & REMOVED) != 0;
+        }
+
+        /**
+         * Pin a node, only while holding its lock and it is not removed.
+         */
+        static void pin(Node* node){
+            node->state.fetch_add(PIN, std::memory_order_relaxed);
+        }
+
+        /**
+         * Drop a pin, and free the node if it was removed and this was the last one.
+         * Never while holding its lock.
+         */
+        static void unpin(Node* node){
+            if (node->state.fetch_sub(PIN, std::memory_order_acq_rel) == (PIN | REMOVED | UNLOCKED)){
+                Allocator::destroy(node);
+            }
+        }
+
+        /**
+         * Mark a node unlinked, under its lock.
+         */
+        static void markRemoved(Node* node){
+            node->state.fetch_or(REMOVED, std::memory_order_relaxed);
+        }
+
+        /**
+         * The remover is done with a node it has unlocked.
+         * @return true iff nothing pins it, so the remover frees it
+         */
+        static bool letGo(Node* node){
+            return node->state.fetch_or(UNLOCKED, std::memory_order_acq_rel) == REMOVED;
+        }
+
+        /**
+         * The two nodes a hand over hand walk holds locked, prev and curr after it.
+         * Whatever it still holds is unlocked when it goes out of scope, however the
+         * operation leaves.
+         */
+        class Coupling {
+            public:
+                Node* prev;
+                Node* curr;
+
+                /**
+                 * Lock start and the node after it.
+                 */
+                explicit Coupling(Node* start) : prev(start) {
+                    prev->lock();
+                    curr = prev->next;
+                    curr->lock();
+                }
+
+                /**
+                 * The same, with the waits recorded.
+                 */
+                Coupling(Node* start, Probe& probe) : prev(start) {
+                    probe.take(prev->mutex);
+                    curr = prev->next;
+                    probe.take(curr->mutex);
+                }
+
+                /**
+                 * Start from a node the caller has locked already.
+                 */
+                Coupling(Node* start, Probe& probe, std::adopt_lock_t) : prev(start) {
+                    curr = prev->next;
+                    probe.take(curr->mutex);
+                }
+
+                ~Coupling(){
+                    prev->unlock();
+                    if (curr != nullptr){
+                        curr->unlock();
+                    }
+                }
+
+                Coupling(const Coupling&) = delete;
+                Coupling& operator=(const Coupling&) = delete;
+
+                /**
+                 * Move one node down: let go of prev, and lock the node after curr.
+                 */
+                void advance(){
+                    prev->unlock();
+                    prev = curr;
+                    curr = curr->next;
+                    curr->lock();
+                }
+
+                void advance(Probe& probe){
+                    prev->unlock();
+                    prev = curr;
+                    curr = curr->next;
+                    probe.take(curr->mutex);
+                }
+
+                /**
+                 * Unlock curr and stop holding it, before it is freed. A queue lock
+                 * gets its node back on unlock.
+                 * @return curr
+                 */
+                Node* release(){
+                    Node* node = curr;
+                    curr->unlock();
+                    curr = nullptr;
+                    return node;
+                }
+        };
+
+        /**
+         * Walk hand over hand from where window is to the first node not before
+         * (key, item). Every node lock's wait is recorded, and the hold clock starts
+         * once the window the operation decides in is locked.
+         */
+        void seek(Coupling& window, size_t key, const T& item, Probe& probe){
+            std::size_t traversed = 0;
+            while (before(window.curr, key, item)){
+                window.advance(probe);
+                traversed++;
+            }
+            probe.traversed(traversed);
+            probe.holding();
+        }
+
+        /**
+         * One operation's hold on a finger, the calling thread's record or a Cursor's
+         * node. The node it moves off is unpinned when it goes out of scope, after the
+         * operation's locks are gone.
+         */
+        class Finger {
+            private:
+                FineList& list;
+                FingerRecord* record;
+                Node*& node;
+                Node* dropped = nullptr;
+
+            public:
+                /**
+                 * The calling thread's finger.
+                 */
+                explicit Finger(FineList& list) : Finger(list, list.fingers.acquire()) {}
+
+                /**
+                 * The finger in a record the caller has acquired, released with the Finger.
+                 */
+                Finger(FineList& list, FingerRecord* record) : list(list), record(record), node(record->node) {}
+
+                /**
+                 * A Cursor's.
+                 */
+                Finger(FineList& list, Node*& node) : list(list), record(nullptr), node(node) {}
+
+                ~Finger(){
+                    if (dropped != nullptr){
+                        unpin(dropped);
+                    }
+                    if (record != nullptr){
+                        list.fingers.release(record);
+                    }
+                }
+
+                Finger(const Finger&) = delete;
+                Finger& operator=(const Finger&) = delete;
+
+                /**
+                 * @return the pinned node, or null for the head
+                 */
+                Node* get() const {
+                    return node;
+                }
+
+                /**
+                 * Let go of a node that has been removed, holding no locks.
+                 */
+                void drop(){
+                    unpin(node);
+                    node = nullptr;
+                }
+
+                /**
+                 * Move to where the operation ended, once per operation: a node it holds
+                 * locked, the head, or a new node before it is linked.
+                 */
+                void moveTo(Node* next){
+                    if (next == &list.head){
+                        next = nullptr;
+                    }
+                    if (next == node){
+                        return;
+                    }
+                    if (next != nullptr){
+                        pin(next);
+                    }
+                    dropped = node;
+                    node = next;
+                }
+        };
+
+        /**
+         * Lock the node a walk to (key, item) starts from: the finger if it is still in
+         * the list and before (key, item), the head otherwise. A removed finger is let go.
+         * @return the start, locked
+         */
+        Node* lockStart(Finger& finger, size_t key, const T& item, Probe& probe){
+            Node* node = finger.get();
+            if (node != nullptr){
+                probe.take(node->mutex);
+                bool gone = removed(node);
+                if (!gone && before(node, key, item)){
+                    return node;
+                }
+                node->unlock();
+                if (gone){
+                    finger.drop();
+                }
+            }
+            probe.take(head.mutex);
+            return &head;
+        }
+
+        /**
+         * Add an element, starting from finger and leaving it on the element.
+         * @return ADDED, PRESENT if it was there already, or OUT_OF_MEMORY
+         */
+        AddStatus insert(T item, size_t key, Finger& finger, Probe& probe) noexcept {
+            //
+            // Lock where to start and the node after it, and find the spot we need to
+            // add this item to.
+            Coupling window(lockStart(finger, key, item, probe), probe, std::adopt_lock);
+            seek(window, key, item, probe);
+
+            //
+            // If the item already exists in the list, there is nothing to do.
+            if (holds(window.curr, key, item)){
+                finger.moveTo(window.curr);
+                probe.released();
+                return AddStatus::PRESENT;
+            }
+
+            //
+            // Insert the node, pinned before anybody else can see it.
+            Node* newNode = Allocator::template tryCreate<Node>(item, key);
+            if (newNode == nullptr){
+                finger.moveTo(window.prev);
+                probe.released();
+                return AddStatus::OUT_OF_MEMORY;
+            }
+            probe.allocated();
+            finger.moveTo(newNode);
+
+            newNode->next = window.curr;
+            updates.begin();
+            window.prev->next = newNode;
+            count.added();
+            updates.end();
+
+            probe.released();
+            return AddStatus::ADDED;
+        }
+
+        /**
+         * Remove an element, starting from finger and leaving it on the node before.
+         * @return true if element was present
+         */
+        bool erase(const T& item, size_t key, Finger& finger, Probe& probe){
+            //
+            // Lock where to start and the node after it, and find the spot we need to
+            // remove the item from.
+            Coupling window(lockStart(finger, key, item, probe), probe, std::adopt_lock);
+            seek(window, key, item, probe);
+            finger.moveTo(window.prev);
+
+            //
+            // If the item does not exist in the list, return false.
+            if (!holds(window.curr, key, item)){
+                probe.released();
+                return false;
+            }
+
+            //
+            // Remove the node. A finger on it keeps it alive until it lets go.
+            updates.begin();
+            window.prev->next = window.curr->next;
+            markRemoved(window.curr);
+            count.removed();
+            updates.end();
+
+            probe.released();
+            Node* node = window.release();
+            if (letGo(node)){
+                Allocator::destroy(node);
+            }
+            probe.freed();
+            return true;
+        }
+
+        /**
+         * Test whether element is present, starting from finger and leaving it on the
+         * element, or the node before where it would be.
+         * @return true iff element is present
+         */
+        bool find(const T& item, size_t key, Finger& finger, Probe& probe){
+            //
+            // Lock where to start and the node after it, and find the spot the item would be in.
+            Coupling window(lockStart(finger, key, item, probe), probe, std::adopt_lock);
+            seek(window, key, item, probe);
+
+            bool found = holds(window.curr, key, item);
+            finger.moveTo(found ? window.curr : window.prev);
+            probe.released();
+            return found;
+        }
 
     public: 
+        /**
+         * A position in the list kept by the caller, for add(item, cursor) and the
+         * others: each starts from it when it can and leaves it where it ended. It pins
+         * a node, so destroy it before the list. One thread at a time.
+         */
+        class Cursor {
+            private:
+                friend class FineList;
+
+                FineList* list = nullptr;
+                Node* node = nullptr;
+
+                /**
+                 * @return the node to use as owner's finger, let go of first if this
+                 *         cursor was last used on another list
+                 */
+                Node*& on(FineList* owner){
+                    if (list != owner){
+                        reset();
+                        list = owner;
+                    }
+                    return node;
+                }
+
+            public:
+                Cursor() = default;
+
+                Cursor(Cursor&& other) noexcept : list(other.list), node(other.node) {
+                    other.node = nullptr;
+                }
+
+                Cursor& operator=(Cursor&& other) noexcept {
+                    if (this != &other){
+                        reset();
+                        list = other.list;
+                        node = other.node;
+                        other.node = nullptr;
+                    }
+                    return *this;
+                }
+
+                Cursor(const Cursor&) = delete;
+                Cursor& operator=(const Cursor&) = delete;
+
+                ~Cursor(){
+                    reset();
+                }
+
+                /**
+                 * Go back to the head.
+                 */
+                void reset(){
+                    if (node != nullptr){
+                        unpin(node);
+                        node = nullptr;
+                    }
+                }
+        };
+
         /**
          * The constructor for the FineList. It initiates the head and tail.
          */
@@ -103,20 +560,20 @@ template<typename T> class FineList {
          * What happens if this is called while other threads are doing work?
          */
         ~FineList(){
-            Node* curr;
-            Node* temp;
-            
-            try{
-                curr = head.next;
-                while (curr != &tail){
-                    curr->lock();
-                    temp = curr;
-                    curr = curr->next;
-                    delete temp;
+            //
+            // Let go of the threads' fingers. The removed nodes only they kept are freed
+            // here, the rest with the list.
+            for (FingerRecord* record = fingers.first(); record != nullptr; record = record->nextRecord){
+                if (record->node != nullptr && removed(record->node)){
+                    unpin(record->node);
                 }
             }
-            catch (...) {
-                cout << "Something went wrong during destruction of CoarseList object...\n";
+
+            Node* curr = head.next;
+            while (curr != &tail){
+                Node* temp = curr;
+                curr = curr->next;
+                Allocator::destroy(temp);
             }
         }
 
@@ -124,59 +581,56 @@ template<typename T> class FineList {
          * Add an element.
          * @param item element to add
          * @return true iff element was not there already
+         * @throws std::bad_alloc if there is no memory for the node, the list is unchanged
          */
         bool add(T item) {
-            //
-            // Get the hash of the item we are trying to insert.
-            size_t key = hasher(item) + 1;
-            //
-            // Lock the head, and set it as prev.
-            Node* prev;
-            Node* curr;
+            AddStatus status = tryAdd(item);
+            if (status == AddStatus::OUT_OF_MEMORY){
+                throw std::bad_alloc();
+            }
+            return status == AddStatus::ADDED;
+        }
 
-            head.lock();
-            prev = &head;
+        /**
+         * add(), starting from cursor and leaving it on the element.
+         */
+        bool add(T item, Cursor& cursor) {
+            AddStatus status = tryAdd(item, cursor);
+            if (status == AddStatus::OUT_OF_MEMORY){
+                throw std::bad_alloc();
+            }
+            return status == AddStatus::ADDED;
+        }
 
-            try {
-                //
-                // Find the spot we need to add this item to.
-                curr = prev->next;
-                curr->lock();
+        /**
+         * Add an element without throwing. A thread's first operation on the list
+         * registers its finger; no memory for that comes back as OUT_OF_MEMORY too.
+         * @param item element to add
+         * @return ADDED, PRESENT if it was there already, or OUT_OF_MEMORY
+         */
+        AddStatus tryAdd(T item) noexcept {
+            //
+            // Get the key of the item we are trying to insert.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::ADD);
+            FingerRecord* record = fingers.tryAcquire();
+            if (record == nullptr){
+                return AddStatus::OUT_OF_MEMORY;
+            }
+            Finger finger(*this, record);
 
-                while (curr->key < key){
-                    prev->unlock();
-                    prev = curr;
-                    curr = curr->next;
-                    curr->lock();
-                }
+            return insert(item, key, finger, probe);
+        }
 
-                //
-                // If the item already exists in the list, return false.
-                if (key == curr->key){
-                    prev->unlock();
-                    curr->unlock();
-                    return false;
-                }
-                
-                //
-                // Insert the node.
-                Node* newNode = new Node(item, key);
-
-                newNode->next = curr;
-                prev->next = newNode;
-
-                prev->unlock();
-                curr->unlock();
-                return true;
-                
-            } catch (...) {
-                prev->unlock();
-                curr->unlock();
-                
-                cout << "Something went wrong during add(). \n";
-                
-                return false;
-            }
+        /**
+         * tryAdd(), starting from cursor and leaving it on the element.
+         */
+        AddStatus tryAdd(T item, Cursor& cursor) noexcept {
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::ADD);
+            Finger finger(*this, cursor.on(this));
+
+            return insert(item, key, finger, probe);
         }
 
         /**
@@ -186,111 +640,248 @@ template<typename T> class FineList {
          */
         bool remove(T item) {
             //
-            // Get the hash of the item we are trying to insert.
-            size_t key = hasher(item) + 1;
+            // Get the key of the item we are trying to remove.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::REMOVE);
+            Finger finger(*this);
+
+            return erase(item, key, finger, probe);
+        }
+
+        /**
+         * remove(), starting from cursor and leaving it on the node before the element.
+         */
+        bool remove(T item, Cursor& cursor) {
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::REMOVE);
+            Finger finger(*this, cursor.on(this));
 
+            return erase(item, key, finger, probe);
+        }
+
+        /**
+         * Test whether element is present
+         * @param item element to test
+         * @return true iff element is present
+         */
+        bool contains(T item) {
             //
-            // Lock the head, and set it as prev.
-            Node* prev;
-            Node* curr;
+            // Get the key of the item we are trying to find.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::CONTAINS);
+            Finger finger(*this);
 
-            head.lock();
-            prev = &head;
+            return find(item, key, finger, probe);
+        }
+
+        /**
+         * contains(), starting from cursor and leaving it on the element, or the node
+         * before where it would be.
+         */
+        bool contains(T item, Cursor& cursor) {
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::CONTAINS);
+            Finger finger(*this, cursor.on(this));
+
+            return find(item, key, finger, probe);
+        }
 
-            try {
+        /**
+         * Add every element of a batch in one hand over hand walk. Each element is
+         * added atomically, the batch as a whole is not.
+         * @param items elements to add, in any order
+         * @param results if not null, results[i] is what add(items[i]) would have returned
+         * @return how many elements were added
+         * @throws std::bad_alloc if there is no memory for a node, the elements added
+         *         before it stay in the list
+         */
+        std::size_t addAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            std::size_t added = 0;
+
+            //
+            // Lock the head and the node after it.
+            Coupling window(&head);
+
+            for (const BatchEntry& entry : batch){
                 //
-                // Find the spot we need to remove the item from
-                curr = prev->next;
-                curr->lock();
+                // Pick up where the last key left off.
+                while (before(window.curr, entry.key, items[entry.index])){
+                    window.advance();
+                }
 
-                while (curr->key < key){
-                    prev->unlock();
-                    prev = curr;
-                    curr = curr->next;
-                    curr->lock();
+                //
+                // If the item already exists in the list, skip it.
+                if (holds(window.curr, entry.key, items[entry.index])){
+                    continue;
                 }
 
                 //
-                // If the item does not exist in the list, return false.
-                if (key != curr->key){
-                    prev->unlock();
-                    curr->unlock();
-                    return false;
+                // Insert the node. Nobody can reach it past prev, so locking it is free,
+                // and it becomes curr so a repeated key finds it.
+                Node* newNode = Allocator::template tryCreate<Node>(items[entry.index], entry.key);
+                if (newNode == nullptr){
+                    throw std::bad_alloc();
+                }
+                newNode->next = window.curr;
+                updates.begin();
+                window.prev->next = newNode;
+                count.added();
+                updates.end();
+                newNode->lock();
+                window.curr->unlock();
+                window.curr = newNode;
+
+                added++;
+                if (results != nullptr){
+                    (*results)[entry.index] = true;
                 }
-                
+            }
+            return added;
+        }
+
+        /**
+         * Remove every element of a batch in one hand over hand walk. Each element is
+         * removed atomically, the batch as a whole is not.
+         * @param items elements to remove, in any order
+         * @param results if not null, results[i] is what remove(items[i]) would have returned
+         * @return how many elements were removed
+         */
+        std::size_t removeAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            std::size_t removed = 0;
+
+            //
+            // Lock the head and the node after it.
+            Coupling window(&head);
+
+            for (const BatchEntry& entry : batch){
                 //
-                // Remove the node
-                prev->next = curr->next;
+                // Pick up where the last key left off.
+                while (before(window.curr, entry.key, items[entry.index])){
+                    window.advance();
+                }
 
-                delete curr;
                 //
-                // What happens if the a thread crashes right here???
-                curr = nullptr;
+                // If the item does not exist in the list, skip it.
+                if (!holds(window.curr, entry.key, items[entry.index])){
+                    continue;
+                }
 
-                prev->unlock();
-                return true;
-                
-            } catch (...) {
-                prev->unlock();
-                if (curr != nullptr) curr->unlock();
+                //
+                // Remove the node. Only a finger on it can still reach it, and the pin
+                // keeps it alive until the finger lets go.
+                updates.begin();
+                window.prev->next = window.curr->next;
+                markRemoved(window.curr);
+                count.removed();
+                updates.end();
+                Node* node = window.release();
+                if (letGo(node)){
+                    Allocator::destroy(node);
+                }
+                window.curr = window.prev->next;
+                window.curr->lock();
 
-                cout << "Something went wrong during remove(). \n";
-                return false;
+                removed++;
+                if (results != nullptr){
+                    (*results)[entry.index] = true;
+                }
             }
+            return removed;
         }
 
         /**
-         * Test whether element is present
-         * @param item element to test
-         * @return true iff element is present
+         * Test a whole batch in one hand over hand walk. Each element is tested
+         * atomically, the batch as a whole is not.
+         * @param items elements to test, in any order
+         * @param results if not null, results[i] is what contains(items[i]) would have returned
+         * @return true iff every element is present
          */
-        bool contains(T item) {
-            //
-            // Get the hash of the item we are trying to find.
-            size_t key = hasher(item) + 1;
+        bool containsAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            bool all = true;
 
             //
-            // Lock the head, and set it as prev.
-            Node* prev;
-            Node* curr;
-
-            head.lock();
-            prev = &head;
+            // Lock the head and the node after it.
+            Coupling window(&head);
 
-            try {
-                //
-                // Find the spot we need to add this item to.
-                curr = prev->next;
-                curr->lock();
-
-                while (curr->key < key){
-                    prev->unlock();
-                    prev = curr;
-                    curr = curr->next;
-                    curr->lock();
+            for (const BatchEntry& entry : batch){
+                while (before(window.curr, entry.key, items[entry.index])){
+                    window.advance();
                 }
 
-                //
-                // If the item already exists in the list, return false.
-                if (key == curr->key){
-                    prev->unlock();
-                    curr->unlock();
-                    return true;
+                bool found = holds(window.curr, entry.key, items[entry.index]);
+                all = all && found;
+                if (results != nullptr){
+                    (*results)[entry.index] = found;
                 }
-                else {
-                    prev->unlock();
-                    curr->unlock();
-                    return false;
-                }
-                
-            } catch (...) {
-                prev->unlock();
-                curr->unlock();
-                
-                cout << "Something went wrong during contain(). \n";
-                
-                return false;
             }
+            return all;
+        }
+
+        /**
+         * Call f on every element, in list order. Hand over hand like everything
+         * else, so f only ever sees items that are in the list. The locks are
+         * released if f throws.
+         * @param f called with each item
+         */
+        template<typename F> void forEach(F f) {
+            //
+            // Lock the head and the node after it.
+            Coupling window(&head);
+
+            while (window.curr != &tail){
+                f(window.curr->item);
+                window.advance();
+            }
+        }
+
+        /**
+         * Number of elements, O(threads). Exact while no update is running, close
+         * to it while some are.
+         * @return the element count
+         */
+        std::size_t size() const {
+            return count.get();
+        }
+
+        /**
+         * Number of elements as of one moment. O(threads) too, unless updates keep
+         * racing it, then they wait for it.
+         * @return the element count
+         */
+        std::size_t exactSize() {
+            std::size_t elements = 0;
+            updates.snapshot([&]{
+                elements = count.get();
+            });
+            return elements;
+        }
+
+        /**
+         * @return bytes per element, for the benchmark's memory column
+         */
+        static constexpr std::size_t nodeSize(){
+            return sizeof(Node);
+        }
+
+        /**
+         * What add(), remove() and contains() recorded, empty unless Instrumentation
+         * is Instrumented. Batches are not recorded.
+         * @return the numbers so far, merged over threads
+         */
+        InstrumentationReport instrumentation() const {
+            return instruments.report();
         }
 };
 
@@ -0,0 +1,19 @@
+#include <iostream>
+
+#include "FlatCombiningList.hpp"
+
+int main()
+{
+    FlatCombiningList<int>* list = new FlatCombiningList<int>;
+    list->add(1);
+    bool a = list->contains(1);
+    std::cout << a << "\n";
+    bool remove = list->remove(1);
+    std::cout << remove << "\n";
+    a = list->contains(1);
+    std::cout << a << "\n";
+
+    delete list;
+
+    return 0;
+}
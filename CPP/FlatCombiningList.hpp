@@ -0,0 +1,386 @@
+#ifndef FLAT_COMBINING_LIST_HPP
+#define FLAT_COMBINING_LIST_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for the publication records
+#include <atomic>
+#include <algorithm>
+#include <vector>
+#include "ThreadRegistry.hpp"
+//
+// Used for the combiner lock
+#include <mutex>
+#include "SpinLock.hpp"
+//
+// Used for allocation failure
+#include <new>
+//
+// The list underneath
+#include "CoarseList.hpp"
+//
+// Item order
+#include "Order.hpp"
+
+/**
+ * Generic template for a flat combining Linked List.
+ *
+ * Threads do not walk the list themselves. Each one publishes its request in a
+ * per-thread record and spins on it; whoever gets the combiner lock collects every
+ * pending request, sorts them, and applies the lot with at most one containsAll(),
+ * one removeAll() and one addAll() on the List underneath, CoarseList by default.
+ * Under contention one walk serves many threads and the list's lock and nodes stay
+ * in one core's cache.
+ *
+ * Requests for the same item are settled among themselves first. An add and a remove
+ * of the same item cancel out: both succeed and the list is not touched, since
+ * whether the item was there or not, some order of the two leaves it as it was and
+ * makes both return true. A contains with an add of the same item pending is true,
+ * with only removes pending it is false, again without a lookup.
+ *
+ * A batch that runs out of memory partway keeps what it did, and the requests it did
+ * not settle are applied one at a time. Only a request that fails on its own throws
+ * std::bad_alloc, in the thread that made it.
+ *
+ * Order must be the order List sorts by, it groups the requests.
+ */
+template<typename T, typename List = CoarseList<T>, typename Order = HashOrder<T>> class FlatCombiningList {
+    private:
+        /**
+         * What a request asks for.
+         */
+        enum class Operation { ADD, REMOVE, CONTAINS };
+
+        //
+        // Request states. A record is IDLE between requests, PENDING once its request
+        // is published and DONE once a combiner has filled in the result.
+        static constexpr int IDLE = 0;
+        static constexpr int PENDING = 1;
+        static constexpr int DONE = 2;
+
+        /**
+         * Inner nested publication record. One per thread, on its own cache line.
+         */
+        class alignas(CACHE_LINE_SIZE) Record{
+            public:
+                //
+                // Claimed by a thread for the length of one request.
+                std::atomic<bool> inUse{false};
+
+                //
+                // Next record in the registry.
+                Record* nextRecord = nullptr;
+
+                //
+                // IDLE, PENDING or DONE.
+                std::atomic<int> state{IDLE};
+
+                //
+                // The request, written before state goes PENDING.
+                Operation operation = Operation::CONTAINS;
+                T item;
+
+                //
+                // The answer, written before state goes DONE. failed means there was no
+                // memory for the request and the list is as it was.
+                bool result = false;
+                bool failed = false;
+        };
+
+        //
+        // The list itself. Only the combiner changes it.
+        List list;
+
+        //
+        // Every thread's publication record.
+        ThreadRegistry<Record> records;
+
+        //
+        // Held by the thread combining right now.
+        SpinLock combiner;
+
+        //
+        // Scratch space for the combiner, kept between rounds so a round allocates
+        // nothing once the vectors have grown.
+        std::vector<Record*> pending;
+        std::vector<T> lookups;
+        std::vector<T> adds;
+        std::vector<T> removes;
+        std::vector<Record*> lookupRecords;
+        std::vector<Record*> addRecords;
+        std::vector<Record*> removeRecords;
+        std::vector<bool> results;
+
+        /**
+         * Do two records ask about the same item? Both keys already match.
+         */
+        static bool same(const Record* a, const Record* b){
+            return !Order::less(a->item, b->item) && !Order::less(b->item, a->item);
+        }
+
+        /**
+         * Run one batch on the list and answer the records that asked. If it runs out
+         * of memory partway, results[i] is true for what it already did and stands; the
+         * other items go one at a time, which gives the same answers since nobody else
+         * changes the list. An item that fails on its own has its record marked failed.
+         * @param items the batch
+         * @param owners the record of each item
+         * @param batch runs the batch into results
+         * @param single runs one item, returns its answer
+         */
+        template<typename Batch, typename Single> void apply(const std::vector<T>& items, const std::vector<Record*>& owners, Batch batch, Single single){
+            if (items.empty()){
+                return;
+            }
+            results.clear();
+            bool complete = false;
+            try {
+                batch();
+                complete = true;
+            }
+            catch (const std::bad_alloc&){
+            }
+
+            for (std::size_t i = 0; i < owners.size(); i++){
+                bool done = i < results.size() && results[i];
+                if (complete || done){
+                    owners[i]->result = done;
+                    continue;
+                }
+                try {
+                    owners[i]->result = single(items[i]);
+                }
+                catch (const std::bad_alloc&){
+                    owners[i]->failed = true;
+                }
+            }
+        }
+
+        /**
+         * Make room for a round of every record there is, so gathering one cannot run
+         * out of memory.
+         * @return false if there is no memory for it
+         */
+        bool reserve(){
+            std::size_t capacity = records.size();
+            try {
+                for (std::vector<Record*>* scratch : {&pending, &lookupRecords, &addRecords, &removeRecords}){
+                    scratch->reserve(capacity);
+                }
+                for (std::vector<T>* scratch : {&lookups, &adds, &removes}){
+                    scratch->reserve(capacity);
+                }
+                results.reserve(capacity);
+            }
+            catch (const std::bad_alloc&){
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Serve every pending request. Combiner lock held. If there is no memory to
+         * gather the requests, only own fails; the rest wait for the next round.
+         * @param own the combiner's own record
+         */
+        void combine(Record* own){
+            if (!reserve()){
+                own->failed = true;
+                own->state.store(DONE, std::memory_order_release);
+                return;
+            }
+
+            //
+            // A record registered since reserve() waits for the next round.
+            pending.clear();
+            for (Record* curr = records.first(); curr != nullptr && pending.size() < pending.capacity(); curr = curr->nextRecord){
+                if (curr->state.load(std::memory_order_acquire) == PENDING){
+                    pending.push_back(curr);
+                }
+            }
+
+            //
+            // Sort so requests for one item sit together.
+            std::sort(pending.begin(), pending.end(), [](const Record* a, const Record* b){
+                return precedes<Order>(Order::key(a->item), a->item, Order::key(b->item), b->item);
+            });
+
+            lookups.clear();
+            adds.clear();
+            removes.clear();
+            lookupRecords.clear();
+            addRecords.clear();
+            removeRecords.clear();
+
+            std::size_t first = 0;
+            while (first < pending.size()){
+                //
+                // Find the requests for this item and count its updates.
+                std::size_t last = first;
+                std::size_t addCount = 0;
+                std::size_t removeCount = 0;
+                while (last < pending.size() && Order::key(pending[last]->item) == Order::key(pending[first]->item) && same(pending[last], pending[first])){
+                    addCount += pending[last]->operation == Operation::ADD;
+                    removeCount += pending[last]->operation == Operation::REMOVE;
+                    last++;
+                }
+
+                //
+                // Pair adds off against removes, the rest go to the list. A run of
+                // leftover adds, or removes, gets what one add(), or remove(), after
+                // another would: the first one decides, the others fail.
+                std::size_t pairs = std::min(addCount, removeCount);
+                std::size_t addsPaired = 0;
+                std::size_t removesPaired = 0;
+                for (std::size_t i = first; i < last; i++){
+                    Record* record = pending[i];
+                    switch (record->operation){
+                        case Operation::ADD:
+                            if (addsPaired < pairs){
+                                addsPaired++;
+                                record->result = true;
+                            }
+                            else {
+                                adds.push_back(record->item);
+                                addRecords.push_back(record);
+                            }
+                            break;
+                        case Operation::REMOVE:
+                            if (removesPaired < pairs){
+                                removesPaired++;
+                                record->result = true;
+                            }
+                            else {
+                                removes.push_back(record->item);
+                                removeRecords.push_back(record);
+                            }
+                            break;
+                        case Operation::CONTAINS:
+                            //
+                            // Ordered right after an add, or a remove, of the same item.
+                            if (addCount > 0 || removeCount > 0){
+                                record->result = addCount > 0;
+                            }
+                            else {
+                                lookups.push_back(record->item);
+                                lookupRecords.push_back(record);
+                            }
+                            break;
+                    }
+                }
+                first = last;
+            }
+
+            //
+            // Each item is in at most one of the batches, so their order does not matter.
+            apply(lookups, lookupRecords, [&]{ list.containsAll(lookups, &results); }, [&](const T& item){ return list.contains(item); });
+            apply(removes, removeRecords, [&]{ list.removeAll(removes, &results); }, [&](const T& item){ return list.remove(item); });
+            apply(adds, addRecords, [&]{ list.addAll(adds, &results); }, [&](const T& item){ return list.add(item); });
+
+            //
+            // Hand the answers back. A record may be reused as soon as it is DONE.
+            for (Record* record : pending){
+                record->state.store(DONE, std::memory_order_release);
+            }
+        }
+
+        /**
+         * Publish a request and wait until some combiner, possibly us, serves it.
+         * @throws std::bad_alloc if there was no memory for it, the list is unchanged
+         */
+        bool request(Operation operation, const T& item){
+            Record* record = records.acquire();
+            record->operation = operation;
+            record->item = item;
+            record->state.store(PENDING, std::memory_order_release);
+
+            SpinWait wait;
+            while (record->state.load(std::memory_order_acquire) != DONE){
+                if (combiner.try_lock()){
+                    std::lock_guard<SpinLock> hold(combiner, std::adopt_lock);
+                    combine(record);
+                }
+                else {
+                    wait.pause();
+                }
+            }
+
+            bool result = record->result;
+            bool failed = record->failed;
+            record->failed = false;
+            record->state.store(IDLE, std::memory_order_relaxed);
+            records.release(record);
+            if (failed){
+                throw std::bad_alloc();
+            }
+            return result;
+        }
+
+    public:
+        /**
+         * Add an element.
+         * @param item element to add
+         * @return true iff element was not there already
+         * @throws std::bad_alloc if there is no memory for the node, the list is unchanged
+         */
+        bool add(T item) {
+            return request(Operation::ADD, item);
+        }
+
+        /**
+         * Remove an element.
+         * @param item element to remove
+         * @return true if element was present
+         * @throws std::bad_alloc if the list underneath needed memory and had none, the
+         *         list is unchanged
+         */
+        bool remove(T item) {
+            return request(Operation::REMOVE, item);
+        }
+
+        /**
+         * Test whether element is present
+         * @param item element to test
+         * @return true iff element is present
+         * @throws std::bad_alloc if the list underneath needed memory and had none
+         */
+        bool contains(T item) {
+            return request(Operation::CONTAINS, item);
+        }
+
+        /**
+         * Call f on every element, in list order, under the list's own lock.
+         * @param f called with each item
+         */
+        template<typename F> void forEach(F f) {
+            list.forEach(f);
+        }
+
+        /**
+         * @return the element count, as the list underneath reports it
+         */
+        std::size_t size() const {
+            return list.size();
+        }
+
+        /**
+         * @return the element count, linearizable if the list's exactSize() is
+         */
+        std::size_t exactSize() {
+            return list.exactSize();
+        }
+
+        /**
+         * @return bytes per element, for the benchmark's memory column
+         */
+        static constexpr std::size_t nodeSize(){
+            return List::nodeSize();
+        }
+};
+
+
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef HAZARD_POINTER_RECLAIMER_HPP
+#define HAZARD_POINTER_RECLAIMER_HPP
+
+//
+// Used for sorting the hazard snapshot
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "ThreadRegistry.hpp"
+
+/**
+ * Safe memory reclamation with M. Michael's hazard pointers.
+ *
+ * A thread publishes every node it is about to dereference in one of its hazard
+ * slots. Removed nodes are retired to a per-thread list, and once the list is long
+ * enough it is scanned: everything that no thread has published gets freed.
+ *
+ * Memory use is bounded even if a thread stalls, but every protected hop costs a
+ * store and a full fence, and the list must check that what it protected was still
+ * reachable (validatesTraversal).
+ */
+class HazardPointerReclaimer {
+    public:
+        //
+        // Hazard slots per operation. Three for a rotating (prev, curr, next) window,
+        // two more for a second walk while the window is still held.
+        static constexpr int SLOTS = 5;
+
+        //
+        // A protected node may already have been unlinked, the list has to check.
+        static constexpr bool validatesTraversal = true;
+
+    private:
+        /**
+         * A node waiting to be freed.
+         */
+        class Retired {
+            public:
+                void* pointer;
+                void (*deleter)(void*);
+        };
+
+        /**
+         * Per-thread hazard slots and retired list.
+         */
+        class alignas(CACHE_LINE_SIZE) Record {
+            public:
+                std::atomic<bool> inUse{false};
+                Record* nextRecord = nullptr;
+                std::atomic<void*> hazards[SLOTS];
+                std::vector<Retired> retired;
+
+                Record(){
+                    for (int i = 0; i < SLOTS; i++){
+                        hazards[i].store(nullptr, std::memory_order_relaxed);
+                    }
+                }
+        };
+
+        //
+        // Retired lists shorter than this are not worth a scan.
+        static constexpr std::size_t MIN_SCAN_THRESHOLD = 64;
+
+        ThreadRegistry<Record> registry;
+
+        /**
+         * Free every retired node of record that no hazard slot points to.
+         */
+        void scan(Record* record){
+            //
+            // Without memory for the snapshot, or with more threads than it has room
+            // for, scanning waits for the next retire().
+            std::vector<void*> hazards;
+            try {
+                hazards.reserve(registry.size() * SLOTS);
+            }
+            catch (const std::bad_alloc&){
+                return;
+            }
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (Record* curr = registry.first(); curr != nullptr; curr = curr->nextRecord){
+                for (int i = 0; i < SLOTS; i++){
+                    void* pointer = curr->hazards[i].load(std::memory_order_acquire);
+                    if (pointer != nullptr){
+                        if (hazards.size() == hazards.capacity()){
+                            return;
+                        }
+                        hazards.push_back(pointer);
+                    }
+                }
+            }
+            std::sort(hazards.begin(), hazards.end());
+
+            std::size_t kept = 0;
+            for (Retired& node : record->retired){
+                if (std::binary_search(hazards.begin(), hazards.end(), node.pointer)){
+                    record->retired[kept++] = node;
+                }
+                else {
+                    node.deleter(node.pointer);
+                }
+            }
+            record->retired.resize(kept);
+        }
+
+    public:
+        /**
+         * RAII handle for one operation: owns a record and its hazard slots.
+         */
+        class Guard {
+            private:
+                HazardPointerReclaimer& domain;
+                Record* record;
+
+            public:
+                explicit Guard(HazardPointerReclaimer& domain) : domain(domain), record(domain.registry.acquire()) {}
+
+                /**
+                 * Without throwing: if the thread needed a record and there is no
+                 * memory for one, the guard is empty and must not be used.
+                 */
+                Guard(HazardPointerReclaimer& domain, const std::nothrow_t&) noexcept : domain(domain), record(domain.registry.tryAcquire()) {}
+
+                Guard(const Guard&) = delete;
+                Guard& operator=(const Guard&) = delete;
+
+                /**
+                 * Clear the slots and hand the record back.
+                 */
+                ~Guard(){
+                    if (record == nullptr){
+                        return;
+                    }
+                    for (int i = 0; i < SLOTS; i++){
+                        record->hazards[i].store(nullptr, std::memory_order_release);
+                    }
+                    domain.registry.release(record);
+                }
+
+                /**
+                 * @return false for an empty guard
+                 */
+                explicit operator bool() const {
+                    return record != nullptr;
+                }
+
+                /**
+                 * Read a pointer and publish it in a slot, until the two agree.
+                 * @param slot hazard slot to use
+                 * @param load reads the shared pointer, e.g. [&]{ return prev->next.load(); }
+                 * @return the protected pointer
+                 */
+                template<typename Load> auto protect(int slot, Load load) -> decltype(load()) {
+                    auto pointer = load();
+                    while (true){
+                        record->hazards[slot].store(pointer, std::memory_order_relaxed);
+                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                        auto again = load();
+                        if (again == pointer){
+                            return pointer;
+                        }
+                        pointer = again;
+                    }
+                }
+
+                /**
+                 * Make room to retire count more nodes, so the retire() calls that
+                 * follow cannot throw. Call it before the change they retire for.
+                 * @return false if there is no memory for the room
+                 */
+                bool reserve(std::size_t count) noexcept {
+                    std::vector<Retired>& retired = record->retired;
+                    std::size_t needed = retired.size() + count;
+                    if (needed <= retired.capacity()){
+                        return true;
+                    }
+                    try {
+                        retired.reserve(std::max(needed, 2 * retired.capacity()));
+                    }
+                    catch (const std::bad_alloc&){
+                        return false;
+                    }
+                    return true;
+                }
+
+                /**
+                 * Hand over a node that is no longer reachable from the list.
+                 * @param pointer the unlinked node
+                 * @param deleter frees it once nobody can be looking at it
+                 * @throws std::bad_alloc if the retired list has to grow, never after reserve()
+                 */
+                void retire(void* pointer, void (*deleter)(void*)){
+                    record->retired.push_back(Retired{pointer, deleter});
+
+                    std::size_t threshold = std::max(MIN_SCAN_THRESHOLD, 2 * SLOTS * domain.registry.size());
+                    if (record->retired.size() >= threshold){
+                        domain.scan(record);
+                    }
+                }
+        };
+
+        HazardPointerReclaimer() = default;
+        HazardPointerReclaimer(const HazardPointerReclaimer&) = delete;
+        HazardPointerReclaimer& operator=(const HazardPointerReclaimer&) = delete;
+
+        /**
+         * Destructor, frees everything still retired. No operation may be running.
+         */
+        ~HazardPointerReclaimer(){
+            for (Record* curr = registry.first(); curr != nullptr; curr = curr->nextRecord){
+                for (Retired& node : curr->retired){
+                    node.deleter(node.pointer);
+                }
+                curr->retired.clear();
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef HEAP_ALLOCATOR_HPP
+#define HEAP_ALLOCATOR_HPP
+
+#include <new>
+#include <utility>
+
+/**
+ * Node allocator that simply uses new and delete.
+ *
+ * Node allocators are stateless: nodes can be created on one thread and destroyed
+ * on another (a reclaimer frees them wherever it runs).
+ */
+class HeapAllocator {
+    public:
+        /**
+         * Allocate and construct a node.
+         */
+        template<typename Node, typename... Args> static Node* create(Args&&... args){
+            return new Node(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Allocate and construct a node, or return null if there is no memory.
+         * Node's constructor must not throw.
+         */
+        template<typename Node, typename... Args> static Node* tryCreate(Args&&... args) noexcept {
+            return new (std::nothrow) Node(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Destroy and free a node made by create() or tryCreate().
+         */
+        template<typename Node> static void destroy(Node* node){
+            delete node;
+        }
+};
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef INSTRUCTION_COUNTER_HPP
+#define INSTRUCTION_COUNTER_HPP
+
+//
+// Used for the count
+#include <cstdint>
+#include <cstring>
+//
+// Used for the hardware counter, Linux only
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Counts the user space instructions the calling thread retires between start()
+ * and stop(), with a perf_event_open() hardware counter.
+ *
+ * Where there is no such counter (not Linux, a virtual machine without a PMU, or
+ * perf_event_paranoid set too high) available() is false and the count stays 0.
+ */
+class InstructionCounter {
+    private:
+        int fd = -1;
+
+    public:
+        InstructionCounter(){
+#if defined(__linux__)
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            //
+            // This thread, on whatever cpu it runs.
+            fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+        }
+
+        ~InstructionCounter(){
+#if defined(__linux__)
+            if (fd >= 0){
+                close(fd);
+            }
+#endif
+        }
+
+        InstructionCounter(const InstructionCounter&) = delete;
+        InstructionCounter& operator=(const InstructionCounter&) = delete;
+
+        bool available() const {
+            return fd >= 0;
+        }
+
+        void start(){
+#if defined(__linux__)
+            if (fd >= 0){
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+
+        void stop(){
+#if defined(__linux__)
+            if (fd >= 0){
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+#endif
+        }
+
+        /**
+         * @return instructions counted between start() and stop(), 0 without a counter
+         */
+        std::uint64_t count() const {
+            std::uint64_t instructions = 0;
+#if defined(__linux__)
+            if (fd >= 0 && read(fd, &instructions, sizeof(instructions)) != static_cast<ssize_t>(sizeof(instructions))){
+                instructions = 0;
+            }
+#endif
+            return instructions;
+        }
+};
+
+#endif
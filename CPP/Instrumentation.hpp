@@ -0,0 +1,397 @@
+#ifndef INSTRUMENTATION_HPP
+#define INSTRUMENTATION_HPP
+
+//
+// Used for timing
+#include <chrono>
+//
+// Used for the per-thread records
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "ThreadRegistry.hpp"
+//
+// Used for the histograms
+#include "LatencyHistogram.hpp"
+//
+// Used for detecting try_lock and instrumentation()
+#include <type_traits>
+#include <utility>
+#include "SpinLock.hpp"
+
+/**
+ * The operations a list instruments, each with its own histograms.
+ */
+enum class ListOperation { ADD = 0, REMOVE = 1, CONTAINS = 2 };
+
+/**
+ * Everything an instrumented list recorded since it was made, merged over threads.
+ */
+class InstrumentationReport {
+    public:
+        //
+        // False with NoInstrumentation, nothing was recorded.
+        bool enabled = false;
+
+        //
+        // Latency of add(), remove() and contains() in nanoseconds, by ListOperation.
+        LatencyHistogram latency[3];
+
+        //
+        // Nodes each of them stepped over.
+        LatencyHistogram traversed[3];
+
+        //
+        // Nanoseconds waited for a lock that was taken, and held the lock (or the
+        // locked window) that the change was made under.
+        LatencyHistogram lockWait;
+        LatencyHistogram lockHold;
+
+        //
+        // Nodes created, and nodes destroyed or handed to the reclaimer.
+        std::uint64_t allocations = 0;
+        std::uint64_t frees = 0;
+
+        /**
+         * @return the histogram for op
+         */
+        const LatencyHistogram& latencyOf(ListOperation op) const {
+            return latency[static_cast<int>(op)];
+        }
+
+        const LatencyHistogram& traversedOf(ListOperation op) const {
+            return traversed[static_cast<int>(op)];
+        }
+
+        /**
+         * @return every operation's traversal lengths in one histogram
+         */
+        LatencyHistogram traversedByAll() const {
+            LatencyHistogram all;
+            for (const LatencyHistogram& histogram : traversed){
+                all.merge(histogram);
+            }
+            return all;
+        }
+
+        /**
+         * Take back an earlier report of the same list, leaving what was recorded since.
+         */
+        void subtract(const InstrumentationReport& earlier){
+            for (int i = 0; i < 3; i++){
+                latency[i].subtract(earlier.latency[i]);
+                traversed[i].subtract(earlier.traversed[i]);
+            }
+            lockWait.subtract(earlier.lockWait);
+            lockHold.subtract(earlier.lockHold);
+            allocations -= earlier.allocations;
+            frees -= earlier.frees;
+        }
+};
+
+/**
+ * The default: nothing is recorded. Every call is an empty inline function and a
+ * Probe is an empty object, so an uninstrumented list compiles to what it was.
+ */
+class NoInstrumentation {
+    public:
+        static constexpr bool enabled = false;
+
+        /**
+         * One operation's view of the instrumentation. Does nothing.
+         */
+        class Probe {
+            public:
+                Probe(NoInstrumentation&, ListOperation) {}
+
+                void traversed(std::size_t) {}
+                void waited(std::uint64_t) {}
+                void holding() {}
+                void released() {}
+                void allocated() {}
+                void freed() {}
+
+                template<typename Lock> void take(Lock& lock){
+                    lock.lock();
+                }
+
+                template<typename Lock> void lock(Lock& lock){
+                    lock.lock();
+                }
+
+                template<typename Lock> void unlock(Lock& lock){
+                    lock.unlock();
+                }
+
+                template<typename Lock> void lockShared(Lock& lock){
+                    lock.lock_shared();
+                }
+
+                template<typename Lock> void unlockShared(Lock& lock){
+                    lock.unlock_shared();
+                }
+        };
+
+        /**
+         * @return an empty report
+         */
+        InstrumentationReport report() const {
+            return InstrumentationReport();
+        }
+};
+
+/**
+ * Records latency, traversal length, lock wait and hold times and allocations.
+ *
+ * Every thread writes to a record of its own, claimed from a ThreadRegistry for
+ * the length of one operation, so recording never contends: a couple of clock reads
+ * per operation, and a relaxed store per value. report() merges the records, while
+ * the list is running if need be. Lock waits are only timed once try_lock() fails,
+ * so an uncontended lock costs nothing more than with NoInstrumentation.
+ */
+class Instrumented {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * Inner nested record class, one thread's share of the numbers.
+         */
+        class Record {
+            public:
+                std::atomic<bool> inUse{false};
+                Record* nextRecord = nullptr;
+
+                ConcurrentHistogram latency[3];
+                ConcurrentHistogram traversed[3];
+                ConcurrentHistogram lockWait;
+                ConcurrentHistogram lockHold;
+
+                //
+                // Only written by the record's owner.
+                std::atomic<std::uint64_t> allocations{0};
+                std::atomic<std::uint64_t> frees{0};
+        };
+
+        ThreadRegistry<Record> records;
+
+        /**
+         * @return nanoseconds on a monotonic clock
+         */
+        static std::uint64_t now(){
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+        }
+
+        /**
+         * Owner only increment of a record counter.
+         */
+        static void bump(std::atomic<std::uint64_t>& counter){
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+    public:
+        static constexpr bool enabled = true;
+
+        /**
+         * One operation's view of the instrumentation. Made at the start of the
+         * operation, it claims the thread's record and starts the clock; destroyed
+         * at the end, it records the latency and traversal and hands the record back.
+         * It never throws: if the thread needs a record and there is no memory for
+         * one, the operation goes unrecorded.
+         */
+        class Probe {
+            private:
+                Instrumented& owner;
+                Record* record;
+                int op;
+                std::uint64_t begin;
+
+                //
+                // Nodes stepped over so far, over every retry.
+                std::size_t steps = 0;
+
+                //
+                // When the lock the change is made under was taken.
+                std::uint64_t lockedAt = 0;
+
+            public:
+                Probe(Instrumented& owner, ListOperation op) noexcept : owner(owner), record(owner.records.tryAcquire()), op(static_cast<int>(op)), begin(now()) {}
+
+                ~Probe(){
+                    if (record == nullptr){
+                        return;
+                    }
+                    record->latency[op].record(now() - begin);
+                    record->traversed[op].record(steps);
+                    owner.records.release(record);
+                }
+
+                Probe(const Probe&) = delete;
+                Probe& operator=(const Probe&) = delete;
+
+                /**
+                 * The operation stepped over this many more nodes. A retry adds its
+                 * search to the first one's, the operation records the total.
+                 */
+                void traversed(std::size_t nodes){
+                    steps += nodes;
+                }
+
+                /**
+                 * A lock was taken, and the operation waited this long for it.
+                 */
+                void waited(std::uint64_t nanos){
+                    if (record != nullptr){
+                        record->lockWait.record(nanos);
+                    }
+                }
+
+                /**
+                 * The lock, or the window of locks, the change is made under is held now.
+                 */
+                void holding(){
+                    lockedAt = now();
+                }
+
+                /**
+                 * ... and released now.
+                 */
+                void released(){
+                    if (record != nullptr){
+                        record->lockHold.record(now() - lockedAt);
+                    }
+                }
+
+                void allocated(){
+                    if (record != nullptr){
+                        bump(record->allocations);
+                    }
+                }
+
+                void freed(){
+                    if (record != nullptr){
+                        bump(record->frees);
+                    }
+                }
+
+                /**
+                 * Take lock, timing the wait if somebody holds it. A lock without
+                 * try_lock() is timed every time.
+                 */
+                template<typename Lock> void take(Lock& lock){
+                    if constexpr (isTryLockable<Lock>::value){
+                        if (lock.try_lock()){
+                            return;
+                        }
+                    }
+                    std::uint64_t start = now();
+                    lock.lock();
+                    waited(now() - start);
+                }
+
+                /**
+                 * take() the lock the change is made under, and start the hold clock.
+                 */
+                template<typename Lock> void lock(Lock& lock){
+                    take(lock);
+                    holding();
+                }
+
+                /**
+                 * Release lock taken with lock() and record how long it was held.
+                 */
+                template<typename Lock> void unlock(Lock& lock){
+                    released();
+                    lock.unlock();
+                }
+
+                /**
+                 * The same for a reader-writer lock's shared mode.
+                 */
+                template<typename Lock> void lockShared(Lock& lock){
+                    if (lock.try_lock_shared()){
+                        holding();
+                        return;
+                    }
+                    std::uint64_t start = now();
+                    lock.lock_shared();
+                    holding();
+                    waited(lockedAt - start);
+                }
+
+                template<typename Lock> void unlockShared(Lock& lock){
+                    released();
+                    lock.unlock_shared();
+                }
+        };
+
+        /**
+         * Merge every thread's record.
+         * @return the numbers so far, a snapshot if threads are still running
+         */
+        InstrumentationReport report() const {
+            InstrumentationReport merged;
+            merged.enabled = true;
+            for (const Record* curr = records.first(); curr != nullptr; curr = curr->nextRecord){
+                for (int i = 0; i < 3; i++){
+                    curr->latency[i].addTo(merged.latency[i]);
+                    curr->traversed[i].addTo(merged.traversed[i]);
+                }
+                curr->lockWait.addTo(merged.lockWait);
+                curr->lockHold.addTo(merged.lockHold);
+                merged.allocations += curr->allocations.load(std::memory_order_relaxed);
+                merged.frees += curr->frees.load(std::memory_order_relaxed);
+            }
+            return merged;
+        }
+};
+
+/**
+ * Holds a lock taken through probe.lock() until it goes out of scope.
+ */
+template<typename Probe, typename Lock> class ProbedLock {
+    private:
+        Probe& probe;
+        Lock& lock;
+
+    public:
+        ProbedLock(Probe& probe, Lock& lock) : probe(probe), lock(lock) {
+            probe.lock(lock);
+        }
+
+        ~ProbedLock(){
+            probe.unlock(lock);
+        }
+
+        ProbedLock(const ProbedLock&) = delete;
+        ProbedLock& operator=(const ProbedLock&) = delete;
+};
+
+/**
+ * The same in a reader-writer lock's shared mode.
+ */
+template<typename Probe, typename Lock> class ProbedSharedLock {
+    private:
+        Probe& probe;
+        Lock& lock;
+
+    public:
+        ProbedSharedLock(Probe& probe, Lock& lock) : probe(probe), lock(lock) {
+            probe.lockShared(lock);
+        }
+
+        ~ProbedSharedLock(){
+            probe.unlockShared(lock);
+        }
+
+        ProbedSharedLock(const ProbedSharedLock&) = delete;
+        ProbedSharedLock& operator=(const ProbedSharedLock&) = delete;
+};
+
+/**
+ * Does List have instrumentation()?
+ */
+template<typename List, typename = void> class hasInstrumentation : public std::false_type {};
+
+template<typename List> class hasInstrumentation<List, std::void_t<decltype(std::declval<const List&>().instrumentation())>> : public std::true_type {};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+//
+// Used for the buckets
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Log-linear latency histogram, in the spirit of HdrHistogram.
+ *
+ * Every power of two is split into 16 linear sub-buckets, so a recorded value is
+ * off by at most 1/16 (about 6%). Recording is a couple of shifts and an increment.
+ */
+class LatencyHistogram {
+    public:
+        static constexpr int SUB_BUCKET_BITS = 4;
+        static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static constexpr int BUCKETS = 64 * SUB_BUCKETS;
+
+        /**
+         * @return the bucket a value falls in
+         */
+        static int bucketOf(std::uint64_t value){
+            if (value < SUB_BUCKETS){
+                return static_cast<int>(value);
+            }
+            int msb = 63 - __builtin_clzll(value);
+            int shift = msb - SUB_BUCKET_BITS;
+            int sub = static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+            return (shift + 1) * SUB_BUCKETS + sub;
+        }
+
+        /**
+         * @return the largest value that falls in a bucket
+         */
+        static std::uint64_t highestValueOf(int bucket){
+            if (bucket < SUB_BUCKETS){
+                return static_cast<std::uint64_t>(bucket);
+            }
+            int shift = bucket / SUB_BUCKETS - 1;
+            std::uint64_t sub = static_cast<std::uint64_t>(bucket % SUB_BUCKETS) | SUB_BUCKETS;
+            return ((sub + 1) << shift) - 1;
+        }
+
+    private:
+        std::vector<std::uint64_t> counts;
+        std::uint64_t total = 0;
+
+    public:
+        LatencyHistogram() : counts(BUCKETS, 0) {}
+
+        /**
+         * Record one value.
+         */
+        void record(std::uint64_t value){
+            counts[bucketOf(value)]++;
+            total++;
+        }
+
+        /**
+         * Add count values that fell in bucket.
+         */
+        void add(int bucket, std::uint64_t count){
+            counts[bucket] += count;
+            total += count;
+        }
+
+        /**
+         * Add another histogram's values to this one.
+         */
+        void merge(const LatencyHistogram& other){
+            for (int i = 0; i < BUCKETS; i++){
+                counts[i] += other.counts[i];
+            }
+            total += other.total;
+        }
+
+        /**
+         * Take back another histogram's values, ones that were merged into this one.
+         */
+        void subtract(const LatencyHistogram& other){
+            for (int i = 0; i < BUCKETS; i++){
+                counts[i] -= other.counts[i];
+            }
+            total -= other.total;
+        }
+
+        /**
+         * @return how many values were recorded
+         */
+        std::uint64_t count() const {
+            return total;
+        }
+
+        /**
+         * @param percentile between 0 and 100
+         * @return upper bound of the value at that percentile
+         */
+        std::uint64_t valueAt(double percentile) const {
+            if (total == 0){
+                return 0;
+            }
+            std::uint64_t rank = static_cast<std::uint64_t>(percentile / 100.0 * static_cast<double>(total));
+            if (rank >= total){
+                rank = total - 1;
+            }
+            std::uint64_t seen = 0;
+            for (int i = 0; i < BUCKETS; i++){
+                seen += counts[i];
+                if (seen > rank){
+                    return highestValueOf(i);
+                }
+            }
+            return highestValueOf(BUCKETS - 1);
+        }
+};
+
+/**
+ * LatencyHistogram that one thread records into while others read it.
+ *
+ * Only the owner writes, so a bucket is bumped with a plain load and store, no
+ * read-modify-write. Readers copy it into a LatencyHistogram whenever they like and
+ * see every value recorded before, and maybe some recorded during, the copy.
+ */
+class ConcurrentHistogram {
+    private:
+        std::atomic<std::uint64_t> counts[LatencyHistogram::BUCKETS] = {};
+
+    public:
+        /**
+         * Record one value. Owner only.
+         */
+        void record(std::uint64_t value){
+            std::atomic<std::uint64_t>& count = counts[LatencyHistogram::bucketOf(value)];
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        /**
+         * Add every recorded value to into. Any thread.
+         */
+        void addTo(LatencyHistogram& into) const {
+            for (int i = 0; i < LatencyHistogram::BUCKETS; i++){
+                std::uint64_t count = counts[i].load(std::memory_order_relaxed);
+                if (count != 0){
+                    into.add(i, count);
+                }
+            }
+        }
+};
+
+#endif
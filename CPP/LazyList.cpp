@@ -1,3 +1,5 @@
+#include <iostream>
+
 #include "LazyList.hpp"
 
 int main()
@@ -5,11 +7,11 @@ int main()
     LazyList<int>* list = new LazyList<int>;
     list->add(1);
     bool a = list->contains(1);
-    cout << a << "\n";
+    std::cout << a << "\n";
     bool remove = list->remove(1);
-    cout << remove << "\n";
+    std::cout << remove << "\n";
     a = list->contains(1);
-    cout << a << "\n";
+    std::cout << a << "\n";
 
     delete list;
 
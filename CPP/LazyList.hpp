@@ -1,304 +1,225 @@
 #ifndef LAZY_LIST_HPP
 #define LAZY_LIST_HPP
 
-
-//
-// Used for hashing
-#include <functional>
-//
-// Used for printing
-#include <iostream>
 //
-// Used for locks
-#include <mutex>
-#include <atomic>
+// The shared locking core
+#include "OptimisticList.hpp"
 //
-// Smart pointers!
+// Used for iterators and snapshots
+#include <iterator>
 #include <memory>
-
-using namespace std;
+#include <vector>
 
 /**
  * Generic template for a Linked List.
+ *
+ * OptimisticList with iterators and snapshots. Since validation moved to node
+ * versions and contains() to the mark, the two lists add, remove and test the same
+ * way, so this one inherits all of that and only adds the walks below. The template
+ * parameters are OptimisticList's.
+ *
+ * Iterators are weakly consistent: they never lock and skip marked nodes, every
+ * item comes up at most once and in order, and an item there for the whole walk
+ * always comes up. snapshot() and rangeScan() are linearizable: remove() marks a
+ * node inside the update brackets, so a walk no update raced saw one moment.
  */
-template<typename T> class LazyList {
-    private: 
-        /**
-         * Inner nested node class.
-         */
-        class Node{
-            public:
-                //
-                // Item being stored
-                T item; 
-
-                //
-                // Hash of the item
-                size_t key;
-
-                //
-                // Next node in the chain
-                // Node *next;
-                // #TODO Try to use the atomic pointer.
-                // HazartPointer ? 
-                std::shared_ptr<Node> next;
-
-                //
-                // Lock for a node.
-                std::mutex mutex;
-                std::atomic<bool> isLocked{false};
-
-                //
-                // Is this node logically removed? Not sure
-                // if this variable has to be atomic... 
-                // #TODO ask Dr. Mendes.
-                std::atomic<bool> isMarked{false};
-
-                /**
-                 * Regular Node constructor 
-                 */
-                Node(T item, size_t key) {
-                    this->item = item;
-                    this->key = key;
-                    this->next = nullptr;
-                }
-
-                /**
-                 * Constructor for sentinal nodes
-                 */
-                Node(size_t key){
-                    this->key = key;
-                    this->next = nullptr;
-                }
-
-                /**
-                 * Lock the node
-                 */
-                void lock(){
-                    mutex.lock();
-                    isLocked.store(true);
-                }
-
-                /**
-                 * Unlock the node if locked.
-                 */
-                void unlock(){
-                    if (isLocked.exchange(false)) {
-                        mutex.unlock();
-                    }
-                }
-        };
-
-        //
-        // The head and tail of the singly linked list implementation of LazyList.
-        // Node head;
-        std::shared_ptr<Node> head = std::make_shared<Node>(0);
+template<typename T, typename Reclaimer = EpochReclaimer, typename Allocator = HeapAllocator, typename Order = HashOrder<T>, typename Lock = SpinLock, typename Backoff = ExponentialBackoff, typename Instrumentation = NoInstrumentation> class LazyList : public OptimisticList<T, Reclaimer, Allocator, Order, Lock, Backoff, Instrumentation> {
+    private:
+        using Base = OptimisticList<T, Reclaimer, Allocator, Order, Lock, Backoff, Instrumentation>;
+        using typename Base::Node;
+        using typename Base::Window;
+        using typename Base::Guard;
+        using Base::head;
+        using Base::tail;
+        using Base::reclaimer;
+        using Base::updates;
+        using Base::find;
+        using Base::before;
+        using Base::holds;
 
         //
-        // The std hashing object, so we don't need to initate it multiple times.
-        hash<T> hasher;
+        // Hazard slots an iterator keeps its nodes in, find() uses the first three.
+        static constexpr int ITERATOR_SLOT = 3;
 
-    public: 
         /**
-         * The constructor for the LazyList. It initiates the head and tail.
+         * The first node not before (key, item), protected in slot. It may be marked
+         * by the time the caller looks at it.
          */
-        LazyList() {
-            std::shared_ptr<Node> tail = std::make_shared<Node>(std::numeric_limits<std::size_t>::max());
-            head->next = tail;
+        Node* seek(Guard& guard, size_t key, const T& item, int slot){
+            std::size_t traversed = 0;
+            Window window = find(guard, key, item, &head, 0, traversed);
+            return guard.protect(slot, [&]{ return window.curr; });
         }
 
         /**
-         * The destructor for the LazyList. It clears all dynamically allocated memory.
-         * What happens if this is called while other threads are doing work?
+         * Copy out the items in [lo, hi) in one weakly consistent walk.
+         * @param lo first item to copy, or null to start at the beginning
+         * @param hi first item past the range, or null to go to the end
          */
-        ~LazyList(){
-            //
-            // This should be enough in theory, since head is the only saved reference.
-            head.reset();
-        }
-
-        /**
-         * Check that prev and curr are still in list and adjacent
-         * @param pred predecessor node
-         * @param curr current node
-         * @return whther predecessor and current have changed
-         */
-        bool validate(std::shared_ptr<Node> prev, std::shared_ptr<Node> curr){
-            return !std::atomic_load(&prev->isMarked) && !std::atomic_load(&curr->isMarked) && prev->next == curr;
+        std::vector<T> collect(const T* lo, const T* hi){
+            std::vector<T> items;
+            for (Iterator it(this, lo); it != end(); ++it){
+                if (hi != nullptr && !before(it.curr, Order::key(*hi), *hi)){
+                    break;
+                }
+                items.push_back(*it);
+            }
+            return items;
         }
 
+    public:
         /**
-         * Add an element.
-         * @param item element to add
-         * @return true iff element was not there already
+         * Weakly consistent forward iterator. While it is not at the end it holds a
+         * reclamation guard, with EpochReclaimer that holds back every free, so walk
+         * and drop it. Move only.
          */
-        bool add(T item) {
-            //
-            // Get the hash of the item we are trying to insert.
-            size_t key = hasher(item);
+        class Iterator {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const T*;
+                using reference = const T&;
 
-            //
-            // Lock the head, and set it as prev.
-            std::shared_ptr<Node> prev;
-            std::shared_ptr<Node> curr;
+            private:
+                friend class LazyList;
 
-            prev = head;
+                LazyList* list = nullptr;
+                std::unique_ptr<Guard> guard;
 
-            //
-            // Until validation is true (optimistically, this loop will only execute once)
-            while (true){
                 //
-                // Find the insertion spot without locking.
-                curr = prev->next;
-                while (curr->key < key){
-                    prev = curr;
-                    curr = curr->next;
-                }
+                // The node whose item is up, null at the end. Protected in currSlot.
+                Node* curr = nullptr;
+                int currSlot = ITERATOR_SLOT;
 
-                prev->lock();
-                curr->lock();
+                /**
+                 * Move to curr's successor, live or not.
+                 */
+                void step(){
+                    while (true){
+                        int nextSlot = 2 * ITERATOR_SLOT + 1 - currSlot;
+                        bool marked = false;
+                        Node* next = guard->protect(nextSlot, [&]{ return curr->next.get(marked); });
+                        if (!Reclaimer::validatesTraversal || !marked){
+                            currSlot = nextSlot;
+                            curr = next;
+                            return;
+                        }
 
-                try{
-                    if (validate(prev, curr)){
                         //
-                        // If the item already exists in the list, return false.
-                        if (key == curr->key){
-                            prev->unlock();
-                            curr->unlock();
-                            return false;
+                        // curr may already be snipped, and next retired. Search for what
+                        // comes after curr instead.
+                        size_t key = curr->key;
+                        T item = curr->item;
+                        curr = list->seek(*guard, key, item, nextSlot);
+                        currSlot = nextSlot;
+                        if (!list->holds(curr, key, item)){
+                            return;
                         }
-
                         //
-                        // Insert the node.
-                        std::shared_ptr<Node> newNode = std::make_shared<Node>(item, key);
+                        // The item was added back behind us. It came up already, go past it too.
+                    }
+                }
 
-                        newNode->next = curr;
-                        prev->next = newNode;
+                /**
+                 * Stay on curr if it is live, else move on to the first live node.
+                 */
+                void settle(){
+                    while (curr != &list->tail && curr->next.isMarked()){
+                        step();
+                    }
+                    if (curr == &list->tail){
+                        curr = nullptr;
+                        guard.reset();
+                    }
+                }
 
-                        prev->unlock();
-                        curr->unlock();
+            public:
+                /**
+                 * The end iterator.
+                 */
+                Iterator() = default;
 
-                        return true;
+                /**
+                 * Iterator at the first item not before from, or the first item if from is null.
+                 */
+                Iterator(LazyList* list, const T* from) : list(list), guard(new Guard(list->reclaimer)) {
+                    if (from == nullptr){
+                        curr = guard->protect(currSlot, [&]{ return list->head.next.getReference(); });
                     }
                     else {
-                        //
-                        // If validation did not work, we start over again.
-                        continue;
+                        curr = list->seek(*guard, Order::key(*from), *from, currSlot);
                     }
+                    settle();
                 }
-                catch (...) {
-                    cout << "Something went wrong during add(). \n";
-                    prev->unlock();
-                    curr->unlock();
-                    prev = head;
-                }
-            }
-        }
-
-        /**
-         * Remove an element.
-         * 
-         * #TODO Nodes are removed instantly, and since we don't get a lock
-         * to traverse the list, it is possible to have a thread try to reference a node
-         * that has been deleted. I think smart pointers are the solution... 
-         * 
-         * 
-         * Also, C++20 has atomic smart pointers, but that is kind of cheating?
-         * 
-         * I'll try using std::shared_ptr instead of regular pointers for nodes. Ask Dr. Mendes about this issue.
-         * 
-         * @param item element to remove
-         * @return true if element was present
-         */
-        bool remove(T item) {
-            //
-            // Get the hash of the item we are trying to remove.
-            size_t key = hasher(item);
-
-            //
-            // Lock the head, and set it as prev.
-            std::shared_ptr<Node> prev;
-            std::shared_ptr<Node> curr;
 
-            prev = head;
+                const T& operator*() const {
+                    return curr->item;
+                }
 
-            //
-            // Until validation is true (optimistically, this loop will only execute once)
-            while (true){
-                //
-                // Find the remove spot without locking.
-                curr = prev->next;
-                while (curr->key < key){
-                    prev = curr;
-                    curr = curr->next;
+                const T* operator->() const {
+                    return &curr->item;
                 }
 
-                prev->lock();
-                curr->lock();
+                Iterator& operator++(){
+                    step();
+                    settle();
+                    return *this;
+                }
 
-                try{
-                    if (validate(prev, curr)){
-                        //
-                        // If the item does not exist in the list, return false.
-                        if (key != curr->key){
-                            prev->unlock();
-                            curr->unlock();
-                            return false;
-                        }
+                bool operator==(const Iterator& other) const {
+                    return curr == other.curr;
+                }
 
-                        //
-                        // Remove the node, the smart pointer should dereference it in theory.
-                        prev->next = curr->next;
+                bool operator!=(const Iterator& other) const {
+                    return curr != other.curr;
+                }
+        };
 
-                        curr->isMarked.store(true); 
+        Iterator begin() {
+            return Iterator(this, nullptr);
+        }
 
-                        curr->unlock();
-                        prev->unlock();
-                        return true;
-                    }
-                    else {
-                        //
-                        // If validation did not work, we start over again.
-                        continue;
-                    }
-                }
-                catch (...) {
-                    prev->unlock();
-                    curr->unlock();
+        Iterator end() {
+            return Iterator();
+        }
 
-                    cout << "Something went wrong during remove(). \n";
-                    
-                    prev = head;
-                    return false;
-                }
+        /**
+         * Call f on every element, in list order. Weakly consistent, like the iterators.
+         * @param f called with each item
+         */
+        template<typename F> void forEach(F f) {
+            for (Iterator it = begin(); it != end(); ++it){
+                f(*it);
             }
         }
 
         /**
-         * Test whether element is present
-         * @param item element to test
-         * @return true iff element is present
+         * Copy out every element, as of one moment. Lock-free unless updates keep
+         * racing it, then updates wait for one walk.
+         * @return the elements, in list order
          */
-        bool contains(T item) {
-            //
-            // Get the hash of the item we are trying to find.
-            size_t key = hasher(item);
+        std::vector<T> snapshot() {
+            std::vector<T> items;
+            updates.snapshot([&]{
+                items = collect(nullptr, nullptr);
+            });
+            return items;
+        }
 
-            //
-            // Try to find the item...
-            std::shared_ptr<Node> curr = head;
-            while (curr->key < key){
-                curr = curr->next;
-            }
-            
-            //
-            // If we find it, and it is not marked for deletion.
-            return !std::atomic_load(&curr->isMarked) && key == curr->key;
+        /**
+         * Copy out the elements in [lo, hi), as of one moment. Only for an Order that
+         * sorts the items themselves, like DirectOrder.
+         * @return the elements, in order
+         */
+        std::vector<T> rangeScan(const T& lo, const T& hi) {
+            static_assert(Order::ordersItems, "rangeScan() needs an Order that sorts the items, like DirectOrder");
+            std::vector<T> items;
+            updates.snapshot([&]{
+                items = collect(&lo, &hi);
+            });
+            return items;
         }
 };
 
-
-
-
-
-#endif 
\ No newline at end of file
+#endif
@@ -0,0 +1,428 @@
+#ifndef LAZY_LIST_MAP_HPP
+#define LAZY_LIST_MAP_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for locks
+#include <atomic>
+#include "SpinLock.hpp"
+#include "QueueLock.hpp"
+//
+// Next pointer with the logical removal mark.
+#include "AtomicMarkableReference.hpp"
+//
+// Used for the sentinel keys
+#include <limits>
+//
+// Used for values that may be missing
+#include <optional>
+//
+// Safe memory reclamation, traversal is unlocked.
+#include "EpochReclaimer.hpp"
+#include "HazardPointerReclaimer.hpp"
+//
+// Node allocation
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Key order
+#include "Order.hpp"
+
+/**
+ * Generic template for a Linked List Map.
+ *
+ * LazyList with a value in every node. Traversal is unlocked, and every update
+ * happens with pred and curr locked and validated, so a read-modify-write such as
+ * compute() is atomic with respect to every other operation on the key. get()
+ * locks only the node it copies the value out of.
+ *
+ * Reclaimer decides when removed nodes are freed, EpochReclaimer or HazardPointerReclaimer.
+ * Allocator creates and destroys the nodes, HeapAllocator or PoolAllocator.
+ * Order sorts the keys, HashOrder or DirectOrder.
+ * Lock is the node lock: SpinLock, BackoffSpinLock, MCSLock, CLHLock or std::mutex.
+ */
+template<typename K, typename V, typename Reclaimer = EpochReclaimer, typename Allocator = HeapAllocator, typename Order = HashOrder<K>, typename Lock = SpinLock> class LazyListMap {
+    private:
+        /**
+         * Inner nested node class, laid out like LazyList's: key and next first, the
+         * mark in next's low bit, then the lock.
+         */
+        class Node{
+            public:
+                //
+                // Order's key for it
+                size_t key;
+
+                //
+                // Next node in the chain, written under the lock and read without it.
+                // The mark means this node is logically removed.
+                AtomicMarkableReference<Node> next;
+
+                //
+                // Lock for a node.
+                Lock mutex;
+
+                //
+                // Key being stored
+                K item;
+
+                //
+                // The key's value. Only read or written under the lock.
+                V value;
+
+                /**
+                 * Regular Node constructor
+                 */
+                Node(K item, size_t key, V value) : value(std::move(value)) {
+                    this->item = item;
+                    this->key = key;
+                }
+
+                /**
+                 * Constructor for sentinal nodes
+                 */
+                Node(size_t key) : value() {
+                    this->key = key;
+                }
+
+                /**
+                 * Lock the node
+                 */
+                void lock(){
+                    mutex.lock();
+                }
+
+                /**
+                 * Unlock the node
+                 */
+                void unlock(){
+                    mutex.unlock();
+                }
+
+                /**
+                 * Is this node logically removed?
+                 */
+                bool isMarked() const {
+                    return next.isMarked();
+                }
+        };
+
+        /**
+         * Inner nested Window class.
+         */
+        class Window {
+            public:
+                //
+                // The nodes of the window.
+                Node* pred;
+                Node* curr;
+
+                /**
+                 * Window constructor
+                 */
+                Window(Node* pred, Node* curr) {
+                    this->curr = curr;
+                    this->pred = pred;
+                }
+        };
+
+        using Guard = typename Reclaimer::Guard;
+
+        //
+        // The head and tail of the singly linked list implementation of LazyListMap.
+        Node head;
+        Node tail;
+
+        //
+        // Frees removed nodes once no traversal can be standing on them.
+        Reclaimer reclaimer;
+
+        /**
+         * Does node come before (key, item)? The tail comes after everything.
+         */
+        bool before(const Node* node, size_t key, const K& item) const {
+            return node != &tail && precedes<Order>(node->key, node->item, key, item);
+        }
+
+        /**
+         * Does node hold item? Only asked once before() is false.
+         */
+        bool holds(const Node* node, size_t key, const K& item) const {
+            return node != &tail && node->key == key && !Order::less(item, node->item);
+        }
+
+        /**
+         * Deleter handed to the reclaimer.
+         */
+        static void destroyNode(void* node){
+            Allocator::destroy(static_cast<Node*>(node));
+        }
+
+        /**
+         * Find the window for a key without locking. pred and curr are protected in the guard.
+         * @param guard the operation's reclamation guard
+         * @param key key to search for
+         * @param item item to search for
+         * @return the window (pred, curr), pred before (key, item) and curr not
+         */
+        Window find(Guard& guard, size_t key, const K& item){
+            while (true){
+                //
+                // Rotating hazard slots, a pointer never moves between slots.
+                int predSlot = 0, currSlot = 1, nextSlot = 2;
+
+                Node* pred = &head;
+                Node* curr = guard.protect(currSlot, [&]{ return pred->next.getReference(); });
+
+                bool restart = false;
+                while (before(curr, key, item)){
+                    bool marked = false;
+                    Node* next = guard.protect(nextSlot, [&]{ return curr->next.get(marked); });
+
+                    //
+                    // A marked node may already be unlinked, so next may already be retired.
+                    if (Reclaimer::validatesTraversal && marked){
+                        restart = true;
+                        break;
+                    }
+
+                    int freeSlot = predSlot;
+                    predSlot = currSlot;
+                    currSlot = nextSlot;
+                    nextSlot = freeSlot;
+
+                    pred = curr;
+                    curr = next;
+                }
+
+                if (!restart){
+                    return Window(pred, curr);
+                }
+            }
+        }
+
+        /**
+         * Check that prev and curr are still in list and adjacent
+         * @param prev predecessor node
+         * @param curr current node
+         * @return whther predecessor and current have changed
+         */
+        static bool validate(Node* prev, Node* curr){
+            return !prev->isMarked() && !curr->isMarked() && prev->next.getReference() == curr;
+        }
+
+        /**
+         * pred and curr locked for one attempt, unlocked when it goes out of scope.
+         */
+        class LockedWindow {
+            private:
+                Node* prev;
+                Node* curr;
+
+            public:
+                LockedWindow(Node* prev, Node* curr) : prev(prev), curr(curr) {
+                    prev->lock();
+                    curr->lock();
+                }
+
+                ~LockedWindow(){
+                    curr->unlock();
+                    prev->unlock();
+                }
+
+                LockedWindow(const LockedWindow&) = delete;
+                LockedWindow& operator=(const LockedWindow&) = delete;
+        };
+
+        /**
+         * The one update every public write is made of. With the window locked and
+         * validated, f sees the current value (null if the key is absent) and returns
+         * the new one, or nothing to remove the key (or leave it absent).
+         * @param item key to update
+         * @param f called exactly once, with both locks held
+         * @return the value before the update, if there was one
+         * @throws whatever f, V or the allocation throws, before anything changed
+         */
+        template<typename F> std::optional<V> modify(K item, F f){
+            //
+            // Get the order key of the key we are trying to update.
+            size_t key = Order::key(item);
+            Guard guard(reclaimer);
+
+            //
+            // Until validation is true (optimistically, this loop will only execute once)
+            while (true){
+                Window window = find(guard, key, item);
+                Node* prev = window.pred;
+                Node* curr = window.curr;
+
+                std::optional<V> previous;
+                {
+                    LockedWindow locked(prev, curr);
+                    if (!validate(prev, curr)){
+                        //
+                        // If validation did not work, we start over again.
+                        continue;
+                    }
+
+                    if (!holds(curr, key, item)){
+                        //
+                        // Absent: insert, if f wants a value.
+                        std::optional<V> next = f(static_cast<const V*>(nullptr));
+                        if (next){
+                            Node* newNode = Allocator::template create<Node>(item, key, std::move(*next));
+                            newNode->next.set(curr, false);
+                            prev->next.set(newNode, false);
+                        }
+                        return std::nullopt;
+                    }
+
+                    //
+                    // Present: update in place, or logically remove then unlink.
+                    previous = curr->value;
+                    std::optional<V> next = f(static_cast<const V*>(&curr->value));
+                    if (next){
+                        curr->value = std::move(*next);
+                        return previous;
+                    }
+                    curr->next.set(curr->next.getReference(), true);
+                    prev->next.set(curr->next.getReference(), false);
+                }
+
+                //
+                // The locks are gone, retire the removed node.
+                guard.retire(curr, &destroyNode);
+                return previous;
+            }
+        }
+
+    public:
+        /**
+         * The constructor for the LazyListMap. It initiates the head and tail.
+         */
+        LazyListMap() : head(std::numeric_limits<std::size_t>::min()), tail(std::numeric_limits<std::size_t>::max()){
+            head.next.set(&tail, false);
+        }
+
+        /**
+         * The destructor for the LazyListMap. It clears all dynamically allocated memory.
+         * Removed nodes are freed by the reclaimer's destructor.
+         * What happens if this is called while other threads are doing work?
+         */
+        ~LazyListMap(){
+            Node* curr = head.next.getReference();
+            while (curr != &tail){
+                Node* temp = curr;
+                curr = curr->next.getReference();
+                Allocator::destroy(temp);
+            }
+        }
+
+        /**
+         * Look up a key. Locks only the node holding it.
+         * @param item key to look up
+         * @return its value, or nothing if the key is absent
+         */
+        std::optional<V> get(K item) {
+            size_t key = Order::key(item);
+            Guard guard(reclaimer);
+
+            Window window = find(guard, key, item);
+            Node* curr = window.curr;
+            if (!holds(curr, key, item)){
+                return std::nullopt;
+            }
+
+            //
+            // The value can only be copied under the lock, a writer may be changing it.
+            curr->lock();
+            std::optional<V> value;
+            if (!curr->isMarked()){
+                value = curr->value;
+            }
+            curr->unlock();
+            return value;
+        }
+
+        /**
+         * Test whether a key is present. Takes no locks.
+         * @param item key to test
+         * @return true iff the key is present
+         */
+        bool containsKey(K item) {
+            size_t key = Order::key(item);
+            Guard guard(reclaimer);
+
+            Window window = find(guard, key, item);
+            Node* curr = window.curr;
+            return !curr->isMarked() && holds(curr, key, item);
+        }
+
+        /**
+         * Set a key's value, adding the key if needed.
+         * @return the previous value, if there was one
+         */
+        std::optional<V> put(K item, V value) {
+            return modify(item, [&](const V*){ return std::optional<V>(value); });
+        }
+
+        /**
+         * Add a key with a value, unless it is already there.
+         * @return the value already there, or nothing if this one was added
+         */
+        std::optional<V> putIfAbsent(K item, V value) {
+            return modify(item, [&](const V* current){ return std::optional<V>(current != nullptr ? *current : value); });
+        }
+
+        /**
+         * Set the value of a key that is already there.
+         * @return the previous value, or nothing if the key was absent and nothing changed
+         */
+        std::optional<V> replace(K item, V value) {
+            return modify(item, [&](const V* current){ return current != nullptr ? std::optional<V>(value) : std::nullopt; });
+        }
+
+        /**
+         * Remove a key.
+         * @return the value it had, or nothing if it was absent
+         */
+        std::optional<V> remove(K item) {
+            return modify(item, [](const V*){ return std::optional<V>(); });
+        }
+
+        /**
+         * Atomically compute a key's new value from its current one.
+         * @param f given the current value (or nothing), returns the new value, or nothing to remove the key
+         * @return the new value
+         */
+        template<typename F> std::optional<V> compute(K item, F f) {
+            std::optional<V> result;
+            modify(item, [&](const V* current){
+                result = f(current != nullptr ? std::optional<V>(*current) : std::optional<V>());
+                return result;
+            });
+            return result;
+        }
+
+        /**
+         * Atomically compute a present key's new value from its current one.
+         * @param f given the current value, returns the new value, or nothing to remove the key
+         * @return the new value, or nothing if the key was absent or removed
+         */
+        template<typename F> std::optional<V> computeIfPresent(K item, F f) {
+            std::optional<V> result;
+            modify(item, [&](const V* current){
+                result = current != nullptr ? f(*current) : std::optional<V>();
+                return result;
+            });
+            return result;
+        }
+};
+
+
+
+
+#endif
@@ -0,0 +1,441 @@
+#ifndef LAZY_SKIP_LIST_HPP
+#define LAZY_SKIP_LIST_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for locks
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+//
+// Used for the sentinel keys
+#include <limits>
+//
+// Safe memory reclamation, traversal is unlocked.
+#include "EpochReclaimer.hpp"
+//
+// Node allocation, a node and its tower in one block
+#include <new>
+#include "SkipListTower.hpp"
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Item order
+#include "Order.hpp"
+
+/**
+ * Generic template for a lazy Skip List.
+ *
+ * Same protocol as LazyList, once per level: traverse without locks, lock the
+ * predecessors, validate, then link or unlink. A node is in the set once it is
+ * fullyLinked and until it is marked.
+ *
+ * Nodes are reclaimed with EpochReclaimer. Hazard pointers would need two slots per
+ * level held at once, which defeats their purpose.
+ * Allocator creates and destroys the nodes, HeapAllocator or PoolAllocator.
+ * Order sorts the items, HashOrder or DirectOrder.
+ */
+template<typename T, typename Allocator = HeapAllocator, typename Order = HashOrder<T>> class LazySkipList {
+    private:
+        //
+        // Number of levels. 2^32 elements before the top level fills up.
+        static constexpr int MAX_LEVEL = 32;
+
+        /**
+         * Inner nested node class.
+         */
+        class Node{
+            public:
+                //
+                // Item being stored
+                T item;
+
+                //
+                // Order's key for the item
+                size_t key;
+
+                //
+                // Highest level this node is on.
+                int topLevel;
+
+                //
+                // Lock for a node.
+                std::mutex mutex;
+
+                //
+                // Is this node logically removed? Read without the lock.
+                std::atomic<bool> isMarked{false};
+
+                //
+                // Is this node linked on every level yet? Read without the lock.
+                std::atomic<bool> fullyLinked{false};
+
+                /**
+                 * Regular Node constructor
+                 */
+                Node(T item, size_t key, int topLevel) {
+                    this->item = item;
+                    this->key = key;
+                    this->topLevel = topLevel;
+                }
+
+                /**
+                 * Constructor for sentinal nodes
+                 */
+                Node(size_t key){
+                    this->key = key;
+                    this->topLevel = MAX_LEVEL - 1;
+                    this->fullyLinked = true;
+                }
+
+                /**
+                 * Next node on every level, the tower behind the node. Written under the lock, read without it.
+                 */
+                std::atomic<Node*>* next(){
+                    return Tower::links(this);
+                }
+
+                /**
+                 * Lock the node
+                 */
+                void lock(){
+                    mutex.lock();
+                }
+
+                /**
+                 * Unlock the node.
+                 */
+                void unlock(){
+                    mutex.unlock();
+                }
+        };
+
+        using Guard = EpochReclaimer::Guard;
+
+        //
+        // Where the nodes and their towers come from.
+        using Tower = SkipListTower<Node, std::atomic<Node*>, Allocator, MAX_LEVEL>;
+
+        //
+        // The head and tail of the skip list, both as tall as it gets.
+        Node* head;
+        Node* tail;
+
+        //
+        // Frees removed nodes once no traversal can be standing on them.
+        EpochReclaimer reclaimer;
+
+        /**
+         * Does node come before (key, item)? The tail comes after everything.
+         */
+        bool before(const Node* node, size_t key, const T& item) const {
+            return node != tail && precedes<Order>(node->key, node->item, key, item);
+        }
+
+        /**
+         * Does node hold item? Only asked once before() is false.
+         */
+        bool holds(const Node* node, size_t key, const T& item) const {
+            return node != tail && node->key == key && !Order::less(item, node->item);
+        }
+
+        /**
+         * Deleter handed to the reclaimer.
+         */
+        static void destroyNode(void* node){
+            Tower::destroy(static_cast<Node*>(node));
+        }
+
+        /**
+         * Pick a level for a new node, level l with probability 2^-(l+1).
+         */
+        static int randomLevel(){
+            thread_local std::uint64_t state = 0x9E3779B97F4A7C15ULL ^ reinterpret_cast<std::uintptr_t>(&state);
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            int level = __builtin_ctzll(state | (std::uint64_t(1) << (MAX_LEVEL - 1)));
+            return level;
+        }
+
+        /**
+         * Fill preds and succs with the window on every level, without locking.
+         * @param key key to search for
+         * @param item item to search for
+         * @return the highest level the key was found on, or -1
+         */
+        int find(size_t key, const T& item, Node** preds, Node** succs){
+            int found = -1;
+            Node* pred = head;
+            for (int level = MAX_LEVEL - 1; level >= 0; level--){
+                Node* curr = pred->next()[level].load(std::memory_order_acquire);
+                while (before(curr, key, item)){
+                    pred = curr;
+                    curr = pred->next()[level].load(std::memory_order_acquire);
+                }
+                if (found == -1 && holds(curr, key, item)){
+                    found = level;
+                }
+                preds[level] = pred;
+                succs[level] = curr;
+            }
+            return found;
+        }
+
+        /**
+         * One attempt's locks on the predecessors, taken bottom up and released when
+         * it goes out of scope. A node is pred on a run of levels, but is only locked once.
+         */
+        class LockedPreds {
+            private:
+                Node** preds;
+                int highestLocked = -1;
+
+            public:
+                explicit LockedPreds(Node** preds) : preds(preds) {}
+
+                ~LockedPreds(){
+                    for (int level = 0; level <= highestLocked; level++){
+                        if (level == 0 || preds[level] != preds[level - 1]){
+                            preds[level]->unlock();
+                        }
+                    }
+                }
+
+                LockedPreds(const LockedPreds&) = delete;
+                LockedPreds& operator=(const LockedPreds&) = delete;
+
+                /**
+                 * Lock the pred on level, every level below is locked already.
+                 * @return the pred
+                 */
+                Node* lock(int level){
+                    Node* pred = preds[level];
+                    if (level == 0 || pred != preds[level - 1]){
+                        pred->lock();
+                    }
+                    highestLocked = level;
+                    return pred;
+                }
+        };
+
+    public:
+        /**
+         * The constructor for the LazySkipList. It initiates the head and tail.
+         * @throws std::bad_alloc if there is no memory for them
+         */
+        LazySkipList() : head(Tower::create(MAX_LEVEL, std::numeric_limits<std::size_t>::min())), tail(Tower::tryCreate(MAX_LEVEL, std::numeric_limits<std::size_t>::max())){
+            if (tail == nullptr){
+                Tower::destroy(head);
+                throw std::bad_alloc();
+            }
+            for (int level = 0; level < MAX_LEVEL; level++){
+                head->next()[level] = tail;
+            }
+        }
+
+        /**
+         * The destructor for the LazySkipList. It clears all dynamically allocated memory.
+         * Removed nodes are freed by the reclaimer's destructor.
+         * What happens if this is called while other threads are doing work?
+         */
+        ~LazySkipList(){
+            //
+            // Every node is unlinked from all levels at once, so the bottom level has them all.
+            Node* curr = head->next()[0].load();
+            while (curr != tail){
+                Node* temp = curr;
+                curr = curr->next()[0].load();
+                Tower::destroy(temp);
+            }
+            Tower::destroy(head);
+            Tower::destroy(tail);
+        }
+
+        /**
+         * Add an element.
+         * @param item element to add
+         * @return true iff element was not there already
+         * @throws std::bad_alloc if there is no memory for the node, the list is unchanged
+         */
+        bool add(T item) {
+            //
+            // Get the key of the item we are trying to insert.
+            size_t key = Order::key(item);
+            int topLevel = randomLevel();
+            Node* preds[MAX_LEVEL];
+            Node* succs[MAX_LEVEL];
+            Guard guard(reclaimer);
+
+            //
+            // Made once the item turns out to be absent, before any lock is taken, and
+            // kept across retries.
+            Node* newNode = nullptr;
+
+            //
+            // Until validation is true (optimistically, this loop will only execute once)
+            while (true){
+                int found = find(key, item, preds, succs);
+
+                //
+                // If the item already exists in the list, return false. Wait for it to be
+                // fully linked first, so nobody can still miss it after we said it is there.
+                if (found != -1){
+                    Node* nodeFound = succs[found];
+                    if (!nodeFound->isMarked.load()){
+                        while (!nodeFound->fullyLinked.load()){
+                        }
+                        if (newNode != nullptr){
+                            Tower::destroy(newNode);
+                        }
+                        return false;
+                    }
+                    //
+                    // It is being removed, try again.
+                    continue;
+                }
+
+                if (newNode == nullptr){
+                    newNode = Tower::create(topLevel + 1, item, key, topLevel);
+                }
+
+                //
+                // Lock every predecessor bottom up, checking the window is still intact.
+                // If validation did not work, the locks go and we start over again.
+                LockedPreds locked(preds);
+                bool valid = true;
+                for (int level = 0; valid && level <= topLevel; level++){
+                    Node* pred = locked.lock(level);
+                    Node* succ = succs[level];
+                    valid = !pred->isMarked.load() && !succ->isMarked.load() && pred->next()[level].load() == succ;
+                }
+                if (!valid){
+                    continue;
+                }
+
+                //
+                // Insert the node, bottom up. It counts once fully linked.
+                for (int level = 0; level <= topLevel; level++){
+                    newNode->next()[level].store(succs[level], std::memory_order_relaxed);
+                }
+                for (int level = 0; level <= topLevel; level++){
+                    preds[level]->next()[level].store(newNode, std::memory_order_release);
+                }
+                newNode->fullyLinked.store(true);
+                return true;
+            }
+        }
+
+        /**
+         * Remove an element.
+         *
+         * The victim is marked under its own lock first, then unlinked from every level
+         * under its predecessors' locks. The reclaimer frees it once no traversal can reach it.
+         *
+         * @param item element to remove
+         * @return true if element was present
+         */
+        bool remove(T item) {
+            //
+            // Get the key of the item we are trying to remove.
+            size_t key = Order::key(item);
+            Node* preds[MAX_LEVEL];
+            Node* succs[MAX_LEVEL];
+            Guard guard(reclaimer);
+
+            Node* victim = nullptr;
+            bool isMarked = false;
+            int topLevel = -1;
+
+            //
+            // Until validation is true (optimistically, this loop will only execute once)
+            while (true){
+                int found = find(key, item, preds, succs);
+                if (found != -1){
+                    victim = succs[found];
+                }
+
+                //
+                // Only a fully linked, unmarked node found on its top level can be removed.
+                if (!isMarked && (found == -1 || !victim->fullyLinked.load() || victim->topLevel != found || victim->isMarked.load())){
+                    return false;
+                }
+
+                //
+                // Logically remove it. Only one thread gets to mark it.
+                if (!isMarked){
+                    topLevel = victim->topLevel;
+                    victim->lock();
+                    if (victim->isMarked.load()){
+                        victim->unlock();
+                        return false;
+                    }
+                    victim->isMarked.store(true);
+                    isMarked = true;
+                }
+
+                {
+                    //
+                    // Lock every predecessor bottom up, checking they still point at the victim.
+                    // If validation did not work, we start over again. The victim stays marked and locked.
+                    LockedPreds locked(preds);
+                    bool valid = true;
+                    for (int level = 0; valid && level <= topLevel; level++){
+                        Node* pred = locked.lock(level);
+                        valid = !pred->isMarked.load() && pred->next()[level].load() == victim;
+                    }
+                    if (!valid){
+                        continue;
+                    }
+
+                    //
+                    // Unlink it top down.
+                    for (int level = topLevel; level >= 0; level--){
+                        preds[level]->next()[level].store(victim->next()[level].load(std::memory_order_relaxed), std::memory_order_release);
+                    }
+                    victim->unlock();
+                }
+
+                guard.retire(victim, &destroyNode);
+                return true;
+            }
+        }
+
+        /**
+         * Test whether element is present. Wait-free, it never locks or retries.
+         * @param item element to test
+         * @return true iff element is present
+         */
+        bool contains(T item) {
+            //
+            // Get the key of the item we are trying to find.
+            size_t key = Order::key(item);
+            Node* preds[MAX_LEVEL];
+            Node* succs[MAX_LEVEL];
+            Guard guard(reclaimer);
+
+            //
+            // Try to find the item...
+            int found = find(key, item, preds, succs);
+
+            //
+            // If we find it, it is fully linked, and it is not marked for deletion.
+            return found != -1 && succs[found]->fullyLinked.load() && !succs[found]->isMarked.load();
+        }
+
+        /**
+         * @return bytes per element, for the benchmark's memory column: a node with a
+         * tower of two links, the average height.
+         */
+        static constexpr std::size_t nodeSize(){
+            return Tower::size(2);
+        }
+};
+
+
+
+
+#endif
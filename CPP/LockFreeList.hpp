@@ -0,0 +1,817 @@
+#ifndef LOCK_FREE_LIST_HPP
+#define LOCK_FREE_LIST_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for compare and swap
+#include <atomic>
+//
+// Used for the sentinel keys
+#include <limits>
+#include <utility>
+//
+// Used for batches
+#include <vector>
+#include "Batch.hpp"
+//
+// Used for iterators and snapshots
+#include <iterator>
+#include <memory>
+#include "UpdateTracker.hpp"
+//
+// Retry counters and the element count
+#include "StripedCounter.hpp"
+//
+// Paces retries after a lost CAS
+#include "Backoff.hpp"
+//
+// Item order
+#include "Order.hpp"
+//
+// Next pointer with the logical removal mark.
+#include "AtomicMarkableReference.hpp"
+//
+// Safe memory reclamation for snipped nodes.
+#include "EpochReclaimer.hpp"
+#include "HazardPointerReclaimer.hpp"
+//
+// Node allocation
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Opt-in latency, traversal and allocation numbers
+#include "Instrumentation.hpp"
+
+/**
+ * Generic template for a Linked List.
+ *
+ * Lock-free list based on M. Michael's algorithm. A node is logically removed by
+ * marking its next reference, and physically removed (snipped) by whichever thread
+ * gets to swing its predecessor past it first.
+ *
+ * Reclaimer decides when snipped nodes are freed, EpochReclaimer or HazardPointerReclaimer.
+ * Allocator creates and destroys the nodes, HeapAllocator or PoolAllocator.
+ * Order sorts the items, HashOrder or DirectOrder.
+ * Backoff paces the retries after a lost CAS: ExponentialBackoff, RandomizedBackoff,
+ * YieldBackoff<N> or NoBackoff.
+ * Instrumentation is NoInstrumentation, or Instrumented to record add(), remove()
+ * and contains(), batches included; see instrumentation().
+ *
+ * Iterators are weakly consistent: they never lock and skip marked nodes, every
+ * item comes up at most once and in order, and an item there for the whole walk
+ * always comes up. snapshot() and rangeScan() are linearizable.
+ */
+template<typename T, typename Reclaimer = EpochReclaimer, typename Allocator = HeapAllocator, typename Order = HashOrder<T>, typename Backoff = ExponentialBackoff, typename Instrumentation = NoInstrumentation> class LockFreeList {
+    private:
+        //
+        // Hazard slots an iterator keeps its nodes in, find() uses the first three.
+        static constexpr int ITERATOR_SLOT = 3;
+
+        /**
+         * Inner nested node class.
+         */
+        class Node{
+            public:
+                //
+                // Item being stored
+                T item;
+
+                //
+                // Order's key for the item
+                size_t key;
+
+                //
+                // Next node in the chain, the mark means this node is logically removed.
+                AtomicMarkableReference<Node> next;
+
+                /**
+                 * Regular Node constructor
+                 */
+                Node(T item, size_t key) {
+                    this->item = item;
+                    this->key = key;
+                }
+
+                /**
+                 * Constructor for sentinal nodes
+                 */
+                Node(size_t key){
+                    this->key = key;
+                }
+        };
+
+        /**
+         * Inner nested Window class.
+         */
+        class Window {
+            public:
+                //
+                // The nodes of the window.
+                Node* pred;
+                Node* curr;
+
+                //
+                // The hazard slot holding pred.
+                int predSlot;
+
+                /**
+                 * Window constructor
+                 */
+                Window(Node* pred, Node* curr, int predSlot) {
+                    this->curr = curr;
+                    this->pred = pred;
+                    this->predSlot = predSlot;
+                }
+        };
+
+        using Guard = typename Reclaimer::Guard;
+
+        //
+        // The head and tail of the singly linked list implementation of LockFreeList.
+        Node head;
+        Node tail;
+
+        //
+        // Frees snipped nodes once no traversal can be standing on them.
+        Reclaimer reclaimer;
+
+        //
+        // Updates, lost CASes, and searches that had to go back to head.
+        StripedCounter operations;
+        StripedCounter retries;
+        StripedCounter restarts;
+
+        //
+        // Brackets every insert and mark, so snapshots can tell whether they raced one.
+        UpdateTracker updates;
+
+        //
+        // Successful adds and removes, counted inside the brackets.
+        StripedSize count;
+
+        //
+        // Per-thread numbers, if Instrumentation records any.
+        Instrumentation instruments;
+
+        using Probe = typename Instrumentation::Probe;
+
+        /**
+         * Does node come before (key, item)? The tail comes after everything.
+         */
+        bool before(const Node* node, size_t key, const T& item) const {
+            return node != &tail && precedes<Order>(node->key, node->item, key, item);
+        }
+
+        /**
+         * Does node hold item? Only asked once before() is false.
+         */
+        bool holds(const Node* node, size_t key, const T& item) const {
+            return node != &tail && node->key == key && !Order::less(item, node->item);
+        }
+
+        /**
+         * Deleter handed to the reclaimer.
+         */
+        static void destroyNode(void* node){
+            Allocator::destroy(static_cast<Node*>(node));
+        }
+
+        /**
+         * If element is present, returns node and predecessor. If absent, returns
+         * node with least larger key. Marked nodes met on the way are snipped.
+         * pred and curr are protected in the guard.
+         * @param guard the operation's reclamation guard
+         * @param key key to search for
+         * @param item item to search for
+         * @param start where to start, head or a node with a smaller key. If it turns
+         *        out to be marked the snip below fails and the search goes back to head.
+         * @param startSlot the hazard slot start is protected in
+         * @param traversed has the number of nodes stepped over added to it
+         * @param snipped has the number of nodes this search snipped and retired added to it
+         * @return the window (pred, curr), pred before (key, item) and curr not
+         */
+        Window find(Guard& guard, size_t key, const T& item, Node* start, int startSlot, std::size_t& traversed, std::size_t& snipped){
+            while (true){
+                //
+                // Rotating hazard slots, a pointer never moves between slots.
+                int predSlot = startSlot, currSlot = (startSlot + 1) % 3, succSlot = (startSlot + 2) % 3;
+
+                Node* pred = start;
+                bool startMarked = false;
+                Node* curr = guard.protect(currSlot, [&]{ return pred->next.get(startMarked); });
+
+                //
+                // A marked start may already be unlinked, and its frozen next already
+                // retired, so do not even look at curr.
+                if (Reclaimer::validatesTraversal && startMarked){
+                    restarts.add();
+                    start = &head;
+                    startSlot = 0;
+                    continue;
+                }
+
+                while (true){
+                    bool marked = false;
+                    Node* succ = guard.protect(succSlot, [&]{ return curr->next.get(marked); });
+
+                    //
+                    // If pred no longer points to curr, curr (and succ) may already be retired.
+                    if (Reclaimer::validatesTraversal){
+                        bool predMarked;
+                        if (pred->next.get(predMarked) != curr || predMarked){
+                            break;
+                        }
+                    }
+
+                    if (marked){
+                        //
+                        // Snip out the marked node. If pred changed under us, start over.
+                        if (!pred->next.compareAndSet(curr, succ, false, false)){
+                            break;
+                        }
+                        guard.retire(curr, &destroyNode);
+                        snipped++;
+
+                        std::swap(currSlot, succSlot);
+                        curr = succ;
+                        continue;
+                    }
+
+                    if (!before(curr, key, item)){
+                        //
+                        // A marked pred would make the caller's CAS fail, but start over
+                        // from head now rather than from it again.
+                        if (pred->next.isMarked()){
+                            break;
+                        }
+                        return Window(pred, curr, predSlot);
+                    }
+
+                    int freeSlot = predSlot;
+                    predSlot = currSlot;
+                    currSlot = succSlot;
+                    succSlot = freeSlot;
+
+                    pred = curr;
+                    curr = succ;
+                    traversed++;
+                }
+
+                restarts.add();
+                start = &head;
+                startSlot = 0;
+            }
+        }
+
+        /**
+         * The first node not before (key, item), protected in slot. It may be marked
+         * by the time the caller looks at it.
+         */
+        Node* seek(Guard& guard, size_t key, const T& item, int slot){
+            std::size_t traversed = 0, snipped = 0;
+            Window window = find(guard, key, item, &head, 0, traversed, snipped);
+            return guard.protect(slot, [&]{ return window.curr; });
+        }
+
+        /**
+         * find() for an instrumented operation, the search's numbers go to probe.
+         */
+        Window findFor(Guard& guard, size_t key, const T& item, Node* start, int startSlot, Probe& probe){
+            std::size_t traversed = 0, snipped = 0;
+            Window window = find(guard, key, item, start, startSlot, traversed, snipped);
+            probe.traversed(traversed);
+            for (; snipped > 0; snipped--){
+                probe.freed();
+            }
+            return window;
+        }
+
+        /**
+         * Copy out the items in [lo, hi) in one weakly consistent walk.
+         * @param lo first item to copy, or null to start at the beginning
+         * @param hi first item past the range, or null to go to the end
+         */
+        std::vector<T> collect(const T* lo, const T* hi){
+            std::vector<T> items;
+            for (Iterator it(this, lo); it != end(); ++it){
+                if (hi != nullptr && !before(it.curr, Order::key(*hi), *hi)){
+                    break;
+                }
+                items.push_back(*it);
+            }
+            return items;
+        }
+
+        /**
+         * Add an element, searching from start. Shared by add() and addAll().
+         * @param guard the operation's reclamation guard
+         * @param item element to add
+         * @param key its key
+         * @param start where to search from, left at the window's pred for the next search
+         * @param startSlot the hazard slot start is protected in, moves with it
+         * @param probe the element's instrumentation
+         * @return true iff element was not there already
+         */
+        bool insert(Guard& guard, T item, size_t key, Node*& start, int& startSlot, Probe& probe){
+            operations.add();
+            Backoff backoff;
+            Node* newNode = nullptr;
+
+            while (true){
+                Window window = findFor(guard, key, item, start, startSlot, probe);
+                Node* pred = window.pred;
+                Node* curr = window.curr;
+                start = pred;
+                startSlot = window.predSlot;
+
+                //
+                // If the item already exists in the list, return false.
+                if (holds(curr, key, item)){
+                    if (newNode != nullptr){
+                        Allocator::destroy(newNode);
+                        probe.freed();
+                    }
+                    return false;
+                }
+
+                //
+                // Splice in the new node, if pred still points to curr and is not marked.
+                if (newNode == nullptr){
+                    newNode = Allocator::template create<Node>(item, key);
+                    probe.allocated();
+                }
+                newNode->next.set(curr, false);
+                updates.begin();
+                bool spliced = pred->next.compareAndSet(curr, newNode, false, false);
+                if (spliced){
+                    count.added();
+                }
+                updates.end();
+                if (spliced){
+                    return true;
+                }
+                retries.add();
+                backoff.pause();
+            }
+        }
+
+        /**
+         * Remove an element, searching from start. Shared by remove() and removeAll().
+         * @param guard the operation's reclamation guard
+         * @param item element to remove
+         * @param key its key
+         * @param start where to search from, left at the window's pred for the next search
+         * @param startSlot the hazard slot start is protected in, moves with it
+         * @param probe the element's instrumentation
+         * @return true if element was present
+         */
+        bool erase(Guard& guard, const T& item, size_t key, Node*& start, int& startSlot, Probe& probe){
+            operations.add();
+            Backoff backoff;
+
+            while (true){
+                Window window = findFor(guard, key, item, start, startSlot, probe);
+                Node* pred = window.pred;
+                Node* curr = window.curr;
+                start = pred;
+                startSlot = window.predSlot;
+
+                //
+                // If the item does not exist in the list, return false.
+                if (!holds(curr, key, item)){
+                    return false;
+                }
+
+                //
+                // Logically remove the node by marking it. This is the linearization point.
+                Node* succ = curr->next.getReference();
+                updates.begin();
+                bool marked = curr->next.compareAndSet(succ, succ, false, true);
+                if (marked){
+                    count.removed();
+                }
+                updates.end();
+                if (!marked){
+                    retries.add();
+                    backoff.pause();
+                    continue;
+                }
+
+                //
+                // Try to snip it once. If it fails, someone else's find() will do it.
+                if (pred->next.compareAndSet(curr, succ, false, false)){
+                    guard.retire(curr, &destroyNode);
+                    probe.freed();
+                }
+                return true;
+            }
+        }
+
+    public:
+        /**
+         * The constructor for the LockFreeList. It initiates the head and tail.
+         */
+        LockFreeList() : head(std::numeric_limits<std::size_t>::min()), tail(std::numeric_limits<std::size_t>::max()){
+            head.next.set(&tail, false);
+        }
+
+        /**
+         * The destructor for the LockFreeList. It clears all dynamically allocated memory.
+         * Snipped nodes are freed by the reclaimer's destructor.
+         * What happens if this is called while other threads are doing work?
+         */
+        ~LockFreeList(){
+            //
+            // Nodes still linked in, marked or not.
+            Node* curr = head.next.getReference();
+            while (curr != &tail){
+                Node* temp = curr;
+                curr = curr->next.getReference();
+                Allocator::destroy(temp);
+            }
+        }
+
+        /**
+         * Add an element.
+         * @param item element to add
+         * @return true iff element was not there already
+         */
+        bool add(T item) {
+            //
+            // Get the key of the item we are trying to insert.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::ADD);
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            return insert(guard, item, key, start, startSlot, probe);
+        }
+
+        /**
+         * Remove an element.
+         * @param item element to remove
+         * @return true if element was present
+         */
+        bool remove(T item) {
+            //
+            // Get the key of the item we are trying to remove.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::REMOVE);
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            return erase(guard, item, key, start, startSlot, probe);
+        }
+
+        /**
+         * Test whether element is present. Wait-free with EpochReclaimer, it never
+         * writes or retries. Hazard pointers have to restart when they land on a
+         * marked node.
+         * @param item element to test
+         * @return true iff element is present
+         */
+        bool contains(T item) {
+            //
+            // Get the key of the item we are trying to find.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::CONTAINS);
+            Guard guard(reclaimer);
+
+            while (true){
+                int currSlot = 0, nextSlot = 1;
+                std::size_t traversed = 0;
+                bool marked = false;
+
+                //
+                // Try to find the item...
+                Node* curr = guard.protect(currSlot, [&]{ return head.next.getReference(); });
+                Node* next = guard.protect(nextSlot, [&]{ return curr->next.get(marked); });
+                while (before(curr, key, item)){
+                    //
+                    // curr may already be unlinked, so next may already be retired.
+                    if (Reclaimer::validatesTraversal && marked){
+                        break;
+                    }
+                    std::swap(currSlot, nextSlot);
+                    curr = next;
+                    next = guard.protect(nextSlot, [&]{ return curr->next.get(marked); });
+                    traversed++;
+                }
+                probe.traversed(traversed);
+
+                if (!before(curr, key, item)){
+                    //
+                    // If we find it, and it is not marked for deletion.
+                    return !marked && holds(curr, key, item);
+                }
+            }
+        }
+
+        /**
+         * Add every element of a batch in one walk: each search starts where the
+         * previous key's window was. Each element is added atomically, the batch as
+         * a whole is not.
+         * @param items elements to add, in any order
+         * @param results if not null, results[i] is what add(items[i]) would have returned
+         * @return how many elements were added
+         */
+        std::size_t addAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            std::size_t added = 0;
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            for (const BatchEntry& entry : batch){
+                Probe probe(instruments, ListOperation::ADD);
+                bool result = insert(guard, items[entry.index], entry.key, start, startSlot, probe);
+                added += result ? 1 : 0;
+                if (results != nullptr){
+                    (*results)[entry.index] = result;
+                }
+            }
+            return added;
+        }
+
+        /**
+         * Remove every element of a batch in one walk: each search starts where the
+         * previous key's window was. Each element is removed atomically, the batch as
+         * a whole is not.
+         * @param items elements to remove, in any order
+         * @param results if not null, results[i] is what remove(items[i]) would have returned
+         * @return how many elements were removed
+         */
+        std::size_t removeAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            std::size_t removed = 0;
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            for (const BatchEntry& entry : batch){
+                Probe probe(instruments, ListOperation::REMOVE);
+                bool result = erase(guard, items[entry.index], entry.key, start, startSlot, probe);
+                removed += result ? 1 : 0;
+                if (results != nullptr){
+                    (*results)[entry.index] = result;
+                }
+            }
+            return removed;
+        }
+
+        /**
+         * Test a whole batch in one walk: each search starts where the previous key's
+         * window was. Each element is tested atomically, the batch as a whole is not.
+         * @param items elements to test, in any order
+         * @param results if not null, results[i] is what contains(items[i]) would have returned
+         * @return true iff every element is present
+         */
+        bool containsAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            bool all = true;
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            for (const BatchEntry& entry : batch){
+                //
+                // find() only returns unmarked nodes, marked ones are snipped on the way.
+                Probe probe(instruments, ListOperation::CONTAINS);
+                Window window = findFor(guard, entry.key, items[entry.index], start, startSlot, probe);
+                start = window.pred;
+                startSlot = window.predSlot;
+
+                bool found = holds(window.curr, entry.key, items[entry.index]);
+                all = all && found;
+                if (results != nullptr){
+                    (*results)[entry.index] = found;
+                }
+            }
+            return all;
+        }
+
+        /**
+         * Weakly consistent forward iterator. While it is not at the end it holds a
+         * reclamation guard, with EpochReclaimer that holds back every free, so walk
+         * and drop it. Move only.
+         */
+        class Iterator {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const T*;
+                using reference = const T&;
+
+            private:
+                friend class LockFreeList;
+
+                LockFreeList* list = nullptr;
+                std::unique_ptr<Guard> guard;
+
+                //
+                // The node whose item is up, null at the end. Protected in currSlot.
+                Node* curr = nullptr;
+                int currSlot = ITERATOR_SLOT;
+
+                /**
+                 * Move to curr's successor, live or not.
+                 */
+                void step(){
+                    while (true){
+                        int nextSlot = 2 * ITERATOR_SLOT + 1 - currSlot;
+                        bool marked = false;
+                        Node* next = guard->protect(nextSlot, [&]{ return curr->next.get(marked); });
+                        if (!Reclaimer::validatesTraversal || !marked){
+                            currSlot = nextSlot;
+                            curr = next;
+                            return;
+                        }
+
+                        //
+                        // curr may already be snipped, and next retired. Search for what
+                        // comes after curr instead.
+                        size_t key = curr->key;
+                        T item = curr->item;
+                        curr = list->seek(*guard, key, item, nextSlot);
+                        currSlot = nextSlot;
+                        if (!list->holds(curr, key, item)){
+                            return;
+                        }
+                        //
+                        // The item was added back behind us. It came up already, go past it too.
+                    }
+                }
+
+                /**
+                 * Stay on curr if it is live, else move on to the first live node.
+                 */
+                void settle(){
+                    while (curr != &list->tail && curr->next.isMarked()){
+                        step();
+                    }
+                    if (curr == &list->tail){
+                        curr = nullptr;
+                        guard.reset();
+                    }
+                }
+
+            public:
+                /**
+                 * The end iterator.
+                 */
+                Iterator() = default;
+
+                /**
+                 * Iterator at the first item not before from, or the first item if from is null.
+                 */
+                Iterator(LockFreeList* list, const T* from) : list(list), guard(new Guard(list->reclaimer)) {
+                    if (from == nullptr){
+                        curr = guard->protect(currSlot, [&]{ return list->head.next.getReference(); });
+                    }
+                    else {
+                        curr = list->seek(*guard, Order::key(*from), *from, currSlot);
+                    }
+                    settle();
+                }
+
+                const T& operator*() const {
+                    return curr->item;
+                }
+
+                const T* operator->() const {
+                    return &curr->item;
+                }
+
+                Iterator& operator++(){
+                    step();
+                    settle();
+                    return *this;
+                }
+
+                bool operator==(const Iterator& other) const {
+                    return curr == other.curr;
+                }
+
+                bool operator!=(const Iterator& other) const {
+                    return curr != other.curr;
+                }
+        };
+
+        Iterator begin() {
+            return Iterator(this, nullptr);
+        }
+
+        Iterator end() {
+            return Iterator();
+        }
+
+        /**
+         * Call f on every element, in list order. Weakly consistent, like the iterators.
+         * @param f called with each item
+         */
+        template<typename F> void forEach(F f) {
+            for (Iterator it = begin(); it != end(); ++it){
+                f(*it);
+            }
+        }
+
+        /**
+         * Copy out every element, as of one moment. Lock-free unless updates keep
+         * racing it, then updates wait for one walk.
+         * @return the elements, in list order
+         */
+        std::vector<T> snapshot() {
+            std::vector<T> items;
+            updates.snapshot([&]{
+                items = collect(nullptr, nullptr);
+            });
+            return items;
+        }
+
+        /**
+         * Copy out the elements in [lo, hi), as of one moment. Only for an Order that
+         * sorts the items themselves, like DirectOrder.
+         * @return the elements, in order
+         */
+        std::vector<T> rangeScan(const T& lo, const T& hi) {
+            static_assert(Order::ordersItems, "rangeScan() needs an Order that sorts the items, like DirectOrder");
+            std::vector<T> items;
+            updates.snapshot([&]{
+                items = collect(&lo, &hi);
+            });
+            return items;
+        }
+
+        /**
+         * How many times add() and remove() lost a CAS, since the list was made.
+         * Nobody waits for a lock here, so lockWaits stays 0.
+         * @return the counters, a snapshot if threads are still running
+         */
+        RetryStats retryStats() const {
+            RetryStats stats;
+            stats.operations = operations.sum();
+            stats.retries = retries.sum();
+            stats.restarts = restarts.sum();
+            return stats;
+        }
+
+        /**
+         * Number of elements, O(threads). Exact while no update is running, close
+         * to it while some are.
+         * @return the element count
+         */
+        std::size_t size() const {
+            return count.get();
+        }
+
+        /**
+         * Number of elements as of one moment. O(threads) too, unless updates keep
+         * racing it, then they wait for it.
+         * @return the element count
+         */
+        std::size_t exactSize() {
+            std::size_t elements = 0;
+            updates.snapshot([&]{
+                elements = count.get();
+            });
+            return elements;
+        }
+
+        /**
+         * @return bytes per element, for the benchmark's memory column
+         */
+        static constexpr std::size_t nodeSize(){
+            return sizeof(Node);
+        }
+
+        /**
+         * What add(), remove() and contains() recorded, empty unless Instrumentation
+         * is Instrumented. A batch counts as one operation per element. There are no
+         * locks, so the lock histograms stay empty. frees counts nodes retired by
+         * whichever operation snipped them, iterators' snips are not counted.
+         * @return the numbers so far, merged over threads
+         */
+        InstrumentationReport instrumentation() const {
+            return instruments.report();
+        }
+};
+
+
+
+
+#endif
@@ -0,0 +1,22 @@
+#include <iostream>
+
+#include "LockFreeListMap.hpp"
+
+int main()
+{
+    LockFreeListMap<int, int>* map = new LockFreeListMap<int, int>;
+    map->put(1, 10);
+    std::cout << map->get(1).value_or(0) << "\n";
+    map->computeIfPresent(1, [](int value){ return std::optional<int>(value + 1); });
+    std::cout << map->get(1).value_or(0) << "\n";
+    bool absent = !map->putIfAbsent(2, 20);
+    std::cout << absent << "\n";
+    bool remove = map->remove(1).has_value();
+    std::cout << remove << "\n";
+    bool a = map->containsKey(1);
+    std::cout << a << "\n";
+
+    delete map;
+
+    return 0;
+}
@@ -0,0 +1,439 @@
+#ifndef LOCK_FREE_LIST_MAP_HPP
+#define LOCK_FREE_LIST_MAP_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for compare and swap
+#include <atomic>
+//
+// Used for the sentinel keys
+#include <limits>
+#include <utility>
+//
+// Used for values that may be missing
+#include <optional>
+//
+// Used for allocation failure
+#include <new>
+//
+// Next pointer with the logical removal mark.
+#include "AtomicMarkableReference.hpp"
+//
+// Safe memory reclamation for snipped nodes and replaced values.
+#include "EpochReclaimer.hpp"
+#include "HazardPointerReclaimer.hpp"
+//
+// Node allocation
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Key order
+#include "Order.hpp"
+
+/**
+ * Generic template for a lock-free Linked List Map.
+ *
+ * LockFreeList with a value in every node. The value lives in an immutable box,
+ * and every update swaps the node's box pointer with a compare and swap, so a
+ * read-modify-write such as compute() is atomic with respect to every other
+ * operation on the key. Removal first swaps the box for null, that is its
+ * linearization point, then marks and snips the node like LockFreeList. An update
+ * that finds a null box helps mark the node and searches again.
+ *
+ * Reclaimer decides when snipped nodes and replaced boxes are freed, EpochReclaimer
+ * or HazardPointerReclaimer. Allocator creates and destroys both. Order sorts the
+ * keys, HashOrder or DirectOrder.
+ */
+template<typename K, typename V, typename Reclaimer = EpochReclaimer, typename Allocator = HeapAllocator, typename Order = HashOrder<K>> class LockFreeListMap {
+    private:
+        //
+        // Hazard slot for the value box, find() uses the first three.
+        static constexpr int BOX_SLOT = 3;
+
+        /**
+         * Immutable value, replaced as a whole.
+         */
+        class Box{
+            public:
+                V value;
+
+                Box(V value) : value(std::move(value)) {}
+        };
+
+        /**
+         * Inner nested node class.
+         */
+        class Node{
+            public:
+                //
+                // Key being stored
+                K item;
+
+                //
+                // Order's key for it
+                size_t key;
+
+                //
+                // The key's value, null once the key is removed.
+                std::atomic<Box*> value;
+
+                //
+                // Next node in the chain, the mark means this node is logically removed.
+                AtomicMarkableReference<Node> next;
+
+                /**
+                 * Regular Node constructor
+                 */
+                Node(K item, size_t key, Box* value) : value(value) {
+                    this->item = item;
+                    this->key = key;
+                }
+
+                /**
+                 * Constructor for sentinal nodes
+                 */
+                Node(size_t key) : value(nullptr) {
+                    this->key = key;
+                }
+
+                /**
+                 * Destructor, frees the box a node still linked in at the end holds.
+                 */
+                ~Node(){
+                    Box* box = value.load(std::memory_order_relaxed);
+                    if (box != nullptr){
+                        Allocator::destroy(box);
+                    }
+                }
+        };
+
+        /**
+         * Inner nested Window class.
+         */
+        class Window {
+            public:
+                //
+                // The nodes of the window.
+                Node* pred;
+                Node* curr;
+
+                /**
+                 * Window constructor
+                 */
+                Window(Node* pred, Node* curr) {
+                    this->curr = curr;
+                    this->pred = pred;
+                }
+        };
+
+        using Guard = typename Reclaimer::Guard;
+
+        //
+        // The head and tail of the singly linked list implementation of LockFreeListMap.
+        Node head;
+        Node tail;
+
+        //
+        // Frees snipped nodes and replaced boxes once no thread can be reading them.
+        Reclaimer reclaimer;
+
+        /**
+         * Does node come before (key, item)? The tail comes after everything.
+         */
+        bool before(const Node* node, size_t key, const K& item) const {
+            return node != &tail && precedes<Order>(node->key, node->item, key, item);
+        }
+
+        /**
+         * Does node hold item? Only asked once before() is false.
+         */
+        bool holds(const Node* node, size_t key, const K& item) const {
+            return node != &tail && node->key == key && !Order::less(item, node->item);
+        }
+
+        /**
+         * Deleters handed to the reclaimer.
+         */
+        static void destroyNode(void* node){
+            Allocator::destroy(static_cast<Node*>(node));
+        }
+        static void destroyBox(void* box){
+            Allocator::destroy(static_cast<Box*>(box));
+        }
+
+        /**
+         * If the key is present, returns its node and predecessor. If absent, returns
+         * the node with least larger key. Marked nodes met on the way are snipped.
+         * pred and curr are protected in the guard.
+         * @param guard the operation's reclamation guard
+         * @param key key to search for
+         * @param item item to search for
+         * @return the window (pred, curr), pred before (key, item) and curr not
+         */
+        Window find(Guard& guard, size_t key, const K& item){
+            while (true){
+                //
+                // Rotating hazard slots, a pointer never moves between slots.
+                int predSlot = 0, currSlot = 1, succSlot = 2;
+
+                Node* pred = &head;
+                Node* curr = guard.protect(currSlot, [&]{ return pred->next.getReference(); });
+
+                while (true){
+                    bool marked = false;
+                    Node* succ = guard.protect(succSlot, [&]{ return curr->next.get(marked); });
+
+                    //
+                    // If pred no longer points to curr, curr (and succ) may already be retired.
+                    if (Reclaimer::validatesTraversal){
+                        bool predMarked;
+                        if (pred->next.get(predMarked) != curr || predMarked){
+                            break;
+                        }
+                    }
+
+                    if (marked){
+                        //
+                        // Snip out the marked node. If pred changed under us, start over.
+                        if (!pred->next.compareAndSet(curr, succ, false, false)){
+                            break;
+                        }
+                        guard.retire(curr, &destroyNode);
+
+                        std::swap(currSlot, succSlot);
+                        curr = succ;
+                        continue;
+                    }
+
+                    if (!before(curr, key, item)){
+                        return Window(pred, curr);
+                    }
+
+                    int freeSlot = predSlot;
+                    predSlot = currSlot;
+                    currSlot = succSlot;
+                    succSlot = freeSlot;
+
+                    pred = curr;
+                    curr = succ;
+                }
+            }
+        }
+
+        /**
+         * Mark a node whose box is already null, so find() will snip it. The remover
+         * does this, anyone who trips over the node first helps.
+         */
+        static void markRemoved(Node* node){
+            while (!node->next.isMarked()){
+                node->next.attemptMark(node->next.getReference(), true);
+            }
+        }
+
+        /**
+         * The one update every public write is made of. f sees the current value
+         * (null if the key is absent) and returns the new one, or nothing to remove the
+         * key (or leave it absent). The result is installed with a compare and swap.
+         * @param item key to update
+         * @param f may be called more than once if the compare and swap loses a race,
+         *        only the last call's result is installed
+         * @return the value before the update, if there was one
+         * @throws whatever f, V or the allocations throw, before anything changed
+         */
+        template<typename F> std::optional<V> modify(K item, F f){
+            //
+            // Get the order key of the key we are trying to update.
+            size_t key = Order::key(item);
+            Guard guard(reclaimer);
+
+            while (true){
+                Window window = find(guard, key, item);
+                Node* pred = window.pred;
+                Node* curr = window.curr;
+
+                if (!holds(curr, key, item)){
+                    //
+                    // Absent: splice in a new node, if f wants a value.
+                    std::optional<V> next = f(static_cast<const V*>(nullptr));
+                    if (!next){
+                        return std::nullopt;
+                    }
+                    Box* newBox = Allocator::template create<Box>(std::move(*next));
+                    Node* newNode = Allocator::template tryCreate<Node>(item, key, newBox);
+                    if (newNode == nullptr){
+                        Allocator::destroy(newBox);
+                        throw std::bad_alloc();
+                    }
+                    newNode->next.set(curr, false);
+                    if (pred->next.compareAndSet(curr, newNode, false, false)){
+                        return std::nullopt;
+                    }
+                    Allocator::destroy(newNode);
+                    continue;
+                }
+
+                //
+                // Present, unless it is being removed.
+                Box* box = guard.protect(BOX_SLOT, [&]{ return curr->value.load(std::memory_order_acquire); });
+                if (box == nullptr){
+                    markRemoved(curr);
+                    continue;
+                }
+
+                std::optional<V> previous(box->value);
+                std::optional<V> next = f(static_cast<const V*>(&box->value));
+                if (next){
+                    Box* newBox = Allocator::template create<Box>(std::move(*next));
+                    if (curr->value.compare_exchange_strong(box, newBox)){
+                        guard.retire(box, &destroyBox);
+                        return previous;
+                    }
+                    Allocator::destroy(newBox);
+                    continue;
+                }
+
+                //
+                // Remove: null the box, that is the linearization point. Then mark and try
+                // to snip it once. If the snip fails, someone else's find() will do it.
+                if (!curr->value.compare_exchange_strong(box, nullptr)){
+                    continue;
+                }
+                guard.retire(box, &destroyBox);
+                markRemoved(curr);
+                if (pred->next.compareAndSet(curr, curr->next.getReference(), false, false)){
+                    guard.retire(curr, &destroyNode);
+                }
+                return previous;
+            }
+        }
+
+    public:
+        /**
+         * The constructor for the LockFreeListMap. It initiates the head and tail.
+         */
+        LockFreeListMap() : head(std::numeric_limits<std::size_t>::min()), tail(std::numeric_limits<std::size_t>::max()){
+            head.next.set(&tail, false);
+        }
+
+        /**
+         * The destructor for the LockFreeListMap. It clears all dynamically allocated memory.
+         * Snipped nodes and replaced boxes are freed by the reclaimer's destructor.
+         * What happens if this is called while other threads are doing work?
+         */
+        ~LockFreeListMap(){
+            //
+            // Nodes still linked in, marked or not.
+            Node* curr = head.next.getReference();
+            while (curr != &tail){
+                Node* temp = curr;
+                curr = curr->next.getReference();
+                Allocator::destroy(temp);
+            }
+        }
+
+        /**
+         * Look up a key. Lock-free, it never writes except to snip.
+         * @param item key to look up
+         * @return its value, or nothing if the key is absent
+         */
+        std::optional<V> get(K item) {
+            size_t key = Order::key(item);
+            Guard guard(reclaimer);
+
+            Window window = find(guard, key, item);
+            Node* curr = window.curr;
+            if (!holds(curr, key, item)){
+                return std::nullopt;
+            }
+
+            Box* box = guard.protect(BOX_SLOT, [&]{ return curr->value.load(std::memory_order_acquire); });
+            if (box == nullptr){
+                return std::nullopt;
+            }
+            return box->value;
+        }
+
+        /**
+         * Test whether a key is present.
+         * @param item key to test
+         * @return true iff the key is present
+         */
+        bool containsKey(K item) {
+            size_t key = Order::key(item);
+            Guard guard(reclaimer);
+
+            Window window = find(guard, key, item);
+            Node* curr = window.curr;
+            return holds(curr, key, item) && curr->value.load(std::memory_order_acquire) != nullptr;
+        }
+
+        /**
+         * Set a key's value, adding the key if needed.
+         * @return the previous value, if there was one
+         */
+        std::optional<V> put(K item, V value) {
+            return modify(item, [&](const V*){ return std::optional<V>(value); });
+        }
+
+        /**
+         * Add a key with a value, unless it is already there.
+         * @return the value already there, or nothing if this one was added
+         */
+        std::optional<V> putIfAbsent(K item, V value) {
+            return modify(item, [&](const V* current){ return std::optional<V>(current != nullptr ? *current : value); });
+        }
+
+        /**
+         * Set the value of a key that is already there.
+         * @return the previous value, or nothing if the key was absent and nothing changed
+         */
+        std::optional<V> replace(K item, V value) {
+            return modify(item, [&](const V* current){ return current != nullptr ? std::optional<V>(value) : std::nullopt; });
+        }
+
+        /**
+         * Remove a key.
+         * @return the value it had, or nothing if it was absent
+         */
+        std::optional<V> remove(K item) {
+            return modify(item, [](const V*){ return std::optional<V>(); });
+        }
+
+        /**
+         * Atomically compute a key's new value from its current one. f may run more
+         * than once under contention, so it should not have side effects.
+         * @param f given the current value (or nothing), returns the new value, or nothing to remove the key
+         * @return the new value
+         */
+        template<typename F> std::optional<V> compute(K item, F f) {
+            std::optional<V> result;
+            modify(item, [&](const V* current){
+                result = f(current != nullptr ? std::optional<V>(*current) : std::optional<V>());
+                return result;
+            });
+            return result;
+        }
+
+        /**
+         * Atomically compute a present key's new value from its current one. f may run
+         * more than once under contention, so it should not have side effects.
+         * @param f given the current value, returns the new value, or nothing to remove the key
+         * @return the new value, or nothing if the key was absent or removed
+         */
+        template<typename F> std::optional<V> computeIfPresent(K item, F f) {
+            std::optional<V> result;
+            modify(item, [&](const V* current){
+                result = current != nullptr ? f(*current) : std::optional<V>();
+                return result;
+            });
+            return result;
+        }
+};
+
+
+
+
+#endif
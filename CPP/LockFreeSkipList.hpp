@@ -0,0 +1,423 @@
+#ifndef LOCK_FREE_SKIP_LIST_HPP
+#define LOCK_FREE_SKIP_LIST_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for compare and swap
+#include <atomic>
+#include <cstdint>
+//
+// Used for the sentinel keys
+#include <limits>
+//
+// Used to collect the nodes in the destructor
+#include <algorithm>
+#include <vector>
+//
+// Next pointers with the logical removal mark.
+#include "AtomicMarkableReference.hpp"
+//
+// Safe memory reclamation for unlinked nodes.
+#include "EpochReclaimer.hpp"
+//
+// Node allocation, a node and its tower in one block
+#include <new>
+#include "SkipListTower.hpp"
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Item order
+#include "Order.hpp"
+
+/**
+ * Generic template for a lock-free Skip List.
+ *
+ * Same node/mark scheme as LockFreeList, once per level: a node is logically removed
+ * when its bottom level reference is marked, and the sorted bottom level list is the
+ * set. The levels above are shortcuts, giving O(log n) expected traversals.
+ *
+ * Nodes are reclaimed with EpochReclaimer. Hazard pointers would need two slots per
+ * level held at once, which defeats their purpose.
+ * Allocator creates and destroys the nodes, HeapAllocator or PoolAllocator.
+ * Order sorts the items, HashOrder or DirectOrder.
+ */
+template<typename T, typename Allocator = HeapAllocator, typename Order = HashOrder<T>> class LockFreeSkipList {
+    private:
+        //
+        // Number of levels. 2^32 elements before the top level fills up.
+        static constexpr int MAX_LEVEL = 32;
+
+        /**
+         * Inner nested node class.
+         */
+        class Node{
+            public:
+                //
+                // Item being stored
+                T item;
+
+                //
+                // Order's key for the item
+                size_t key;
+
+                //
+                // Highest level this node is on.
+                int topLevel;
+
+                //
+                // Levels this node is linked on, plus one while add() may still link it.
+                // Whoever brings it to zero retires the node.
+                std::atomic<int> links;
+
+                /**
+                 * Regular Node constructor
+                 */
+                Node(T item, size_t key, int topLevel) : links(1) {
+                    this->item = item;
+                    this->key = key;
+                    this->topLevel = topLevel;
+                }
+
+                /**
+                 * Constructor for sentinal nodes
+                 */
+                Node(size_t key) : links(1) {
+                    this->key = key;
+                    this->topLevel = MAX_LEVEL - 1;
+                }
+
+                /**
+                 * Next node on every level, the tower behind the node. The mark means this node is logically removed there.
+                 */
+                AtomicMarkableReference<Node>* next(){
+                    return Tower::links(this);
+                }
+        };
+
+        using Guard = EpochReclaimer::Guard;
+
+        //
+        // Where the nodes and their towers come from.
+        using Tower = SkipListTower<Node, AtomicMarkableReference<Node>, Allocator, MAX_LEVEL>;
+
+        //
+        // The head and tail of the skip list, both as tall as it gets.
+        Node* head;
+        Node* tail;
+
+        //
+        // Frees unlinked nodes once no traversal can be standing on them.
+        EpochReclaimer reclaimer;
+
+        /**
+         * Does node come before (key, item)? The tail comes after everything.
+         */
+        bool before(const Node* node, size_t key, const T& item) const {
+            return node != tail && precedes<Order>(node->key, node->item, key, item);
+        }
+
+        /**
+         * Does node hold item? Only asked once before() is false.
+         */
+        bool holds(const Node* node, size_t key, const T& item) const {
+            return node != tail && node->key == key && !Order::less(item, node->item);
+        }
+
+        /**
+         * Deleter handed to the reclaimer.
+         */
+        static void destroyNode(void* node){
+            Tower::destroy(static_cast<Node*>(node));
+        }
+
+        /**
+         * Drop one link reference, retiring the node if it was the last one.
+         */
+        static void release(Guard& guard, Node* node){
+            if (node->links.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                guard.retire(node, &destroyNode);
+            }
+        }
+
+        /**
+         * Pick a level for a new node, level l with probability 2^-(l+1).
+         */
+        static int randomLevel(){
+            thread_local std::uint64_t state = 0x9E3779B97F4A7C15ULL ^ reinterpret_cast<std::uintptr_t>(&state);
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            int level = __builtin_ctzll(state | (std::uint64_t(1) << (MAX_LEVEL - 1)));
+            return level;
+        }
+
+        /**
+         * Fill preds and succs with the window on every level, snipping marked nodes.
+         * @param key key to search for
+         * @param item item to search for
+         * @return true iff an unmarked node with that key is in the list
+         */
+        bool find(Guard& guard, size_t key, const T& item, Node** preds, Node** succs){
+            bool marked = false;
+
+            while (true){
+                bool restart = false;
+                Node* pred = head;
+                Node* curr = nullptr;
+
+                for (int level = MAX_LEVEL - 1; level >= 0 && !restart; level--){
+                    curr = pred->next()[level].getReference();
+                    while (true){
+                        Node* succ = curr->next()[level].get(marked);
+
+                        //
+                        // Snip out every marked node on this level. If pred changed under us, start over.
+                        while (marked){
+                            if (!pred->next()[level].compareAndSet(curr, succ, false, false)){
+                                restart = true;
+                                break;
+                            }
+                            release(guard, curr);
+                            curr = pred->next()[level].getReference();
+                            succ = curr->next()[level].get(marked);
+                        }
+                        if (restart){
+                            break;
+                        }
+
+                        if (before(curr, key, item)){
+                            pred = curr;
+                            curr = succ;
+                        }
+                        else {
+                            break;
+                        }
+                    }
+                    preds[level] = pred;
+                    succs[level] = curr;
+                }
+
+                if (!restart){
+                    return holds(curr, key, item);
+                }
+            }
+        }
+
+    public:
+        /**
+         * The constructor for the LockFreeSkipList. It initiates the head and tail.
+         * @throws std::bad_alloc if there is no memory for them
+         */
+        LockFreeSkipList() : head(Tower::create(MAX_LEVEL, std::numeric_limits<std::size_t>::min())), tail(Tower::tryCreate(MAX_LEVEL, std::numeric_limits<std::size_t>::max())){
+            if (tail == nullptr){
+                Tower::destroy(head);
+                throw std::bad_alloc();
+            }
+            for (int level = 0; level < MAX_LEVEL; level++){
+                head->next()[level].set(tail, false);
+            }
+        }
+
+        /**
+         * The destructor for the LockFreeSkipList. It clears all dynamically allocated memory.
+         * Unlinked nodes are freed by the reclaimer's destructor.
+         * What happens if this is called while other threads are doing work?
+         */
+        ~LockFreeSkipList(){
+            //
+            // A removed node can still be linked on some level above the bottom one.
+            std::vector<Node*> nodes;
+            for (int level = 0; level < MAX_LEVEL; level++){
+                for (Node* curr = head->next()[level].getReference(); curr != tail; curr = curr->next()[level].getReference()){
+                    nodes.push_back(curr);
+                }
+            }
+            std::sort(nodes.begin(), nodes.end());
+            nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+            for (Node* node : nodes){
+                Tower::destroy(node);
+            }
+            Tower::destroy(head);
+            Tower::destroy(tail);
+        }
+
+        /**
+         * Add an element.
+         * @param item element to add
+         * @return true iff element was not there already
+         */
+        bool add(T item) {
+            //
+            // Get the key of the item we are trying to insert.
+            size_t key = Order::key(item);
+            int topLevel = randomLevel();
+            Node* preds[MAX_LEVEL];
+            Node* succs[MAX_LEVEL];
+            Guard guard(reclaimer);
+            Node* newNode = nullptr;
+
+            while (true){
+                //
+                // If the item already exists in the list, return false.
+                if (find(guard, key, item, preds, succs)){
+                    if (newNode != nullptr){
+                        Tower::destroy(newNode);
+                    }
+                    return false;
+                }
+
+                if (newNode == nullptr){
+                    newNode = Tower::create(topLevel + 1, item, key, topLevel);
+                }
+                for (int level = 0; level <= topLevel; level++){
+                    newNode->next()[level].set(succs[level], false);
+                }
+
+                //
+                // Linking the bottom level is the linearization point. The link is
+                // counted before the CAS, so a snip can never see the count short.
+                newNode->links.fetch_add(1, std::memory_order_relaxed);
+                if (!preds[0]->next()[0].compareAndSet(succs[0], newNode, false, false)){
+                    newNode->links.fetch_sub(1, std::memory_order_relaxed);
+                    continue;
+                }
+
+                //
+                // Link the shortcuts, refreshing the window whenever it moved.
+                for (int level = 1; level <= topLevel; level++){
+                    while (true){
+                        bool marked;
+                        Node* succ = newNode->next()[level].get(marked);
+
+                        //
+                        // Someone is already removing it, stop adding shortcuts.
+                        if (marked){
+                            break;
+                        }
+                        if (succ != succs[level] && !newNode->next()[level].compareAndSet(succ, succs[level], false, false)){
+                            continue;
+                        }
+
+                        newNode->links.fetch_add(1, std::memory_order_relaxed);
+                        if (preds[level]->next()[level].compareAndSet(succs[level], newNode, false, false)){
+                            break;
+                        }
+                        newNode->links.fetch_sub(1, std::memory_order_relaxed);
+                        find(guard, key, item, preds, succs);
+                    }
+                    if (newNode->next()[level].isMarked()){
+                        break;
+                    }
+                }
+
+                //
+                // Done linking, from now on only snips touch the count.
+                release(guard, newNode);
+                return true;
+            }
+        }
+
+        /**
+         * Remove an element.
+         * @param item element to remove
+         * @return true if element was present
+         */
+        bool remove(T item) {
+            //
+            // Get the key of the item we are trying to remove.
+            size_t key = Order::key(item);
+            Node* preds[MAX_LEVEL];
+            Node* succs[MAX_LEVEL];
+            Guard guard(reclaimer);
+
+            //
+            // If the item does not exist in the list, return false.
+            if (!find(guard, key, item, preds, succs)){
+                return false;
+            }
+            Node* victim = succs[0];
+
+            //
+            // Mark the shortcuts top down, so traversals stop descending into it.
+            bool marked;
+            for (int level = victim->topLevel; level >= 1; level--){
+                Node* succ = victim->next()[level].get(marked);
+                while (!marked){
+                    victim->next()[level].attemptMark(succ, true);
+                    succ = victim->next()[level].get(marked);
+                }
+            }
+
+            //
+            // Marking the bottom level is the linearization point, only one thread wins it.
+            Node* succ = victim->next()[0].get(marked);
+            while (true){
+                bool iMarkedIt = victim->next()[0].compareAndSet(succ, succ, false, true);
+                succ = victim->next()[0].get(marked);
+                if (iMarkedIt){
+                    //
+                    // Let find() snip it on every level.
+                    find(guard, key, item, preds, succs);
+                    return true;
+                }
+                else if (marked){
+                    return false;
+                }
+            }
+        }
+
+        /**
+         * Test whether element is present. Wait-free, it never writes or retries.
+         * @param item element to test
+         * @return true iff element is present
+         */
+        bool contains(T item) {
+            //
+            // Get the key of the item we are trying to find.
+            size_t key = Order::key(item);
+            Guard guard(reclaimer);
+            bool marked = false;
+
+            Node* pred = head;
+            Node* curr = nullptr;
+            for (int level = MAX_LEVEL - 1; level >= 0; level--){
+                curr = pred->next()[level].getReference();
+                while (true){
+                    //
+                    // Step over marked nodes without snipping them.
+                    Node* succ = curr->next()[level].get(marked);
+                    while (marked){
+                        curr = succ;
+                        succ = curr->next()[level].get(marked);
+                    }
+                    if (before(curr, key, item)){
+                        pred = curr;
+                        curr = succ;
+                    }
+                    else {
+                        break;
+                    }
+                }
+            }
+
+            //
+            // If we find it, and it is not marked for deletion.
+            return holds(curr, key, item);
+        }
+
+        /**
+         * @return bytes per element, for the benchmark's memory column: a node with a
+         * tower of two links, the average height.
+         */
+        static constexpr std::size_t nodeSize(){
+            return Tower::size(2);
+        }
+};
+
+
+
+
+#endif
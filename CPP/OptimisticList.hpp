@@ -6,53 +6,102 @@
 // Used for hashing
 #include <functional>
 //
-// Used for printing
-#include <iostream>
-//
 // Used for locks
-#include <mutex>
 #include <atomic>
+#include <cstdint>
+#include "SpinLock.hpp"
+#include "QueueLock.hpp"
 //
-// Smart pointers!
-#include <memory>
-
-using namespace std;
+// Paces retries after a failed validation
+#include "Backoff.hpp"
+//
+// Next pointer with the logical removal mark.
+#include "AtomicMarkableReference.hpp"
+//
+// Used for batches
+#include <vector>
+#include "Batch.hpp"
+//
+// Item order
+#include "Order.hpp"
+//
+// Used for the sentinel keys
+#include <limits>
+//
+// Safe memory reclamation, traversal is unlocked.
+#include "EpochReclaimer.hpp"
+#include "HazardPointerReclaimer.hpp"
+//
+// Node allocation, and reporting when it fails
+#include <new>
+#include "AddStatus.hpp"
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Retry counters and the element count
+#include <chrono>
+#include "StripedCounter.hpp"
+#include "UpdateTracker.hpp"
+//
+// Opt-in latency, traversal, lock and allocation numbers
+#include "Instrumentation.hpp"
 
 /**
  * Generic template for a Linked List.
+ *
+ * Validation used to walk the list from head again. It now compares pred's version
+ * with the one find() saw, and a failed validation resumes from pred when it can.
+ * contains() takes no locks either, it reads remove()'s mark. That leaves nothing
+ * for LazyList to do differently, so it derives from this class and only adds
+ * iterators and snapshots; the members it needs are protected.
+ *
+ * Reclaimer decides when removed nodes are freed, EpochReclaimer or HazardPointerReclaimer.
+ * Allocator creates and destroys the nodes, HeapAllocator or PoolAllocator.
+ * Order sorts the items, HashOrder or DirectOrder.
+ * Lock is the node lock: SpinLock, BackoffSpinLock, MCSLock, CLHLock or std::mutex.
+ * Backoff paces the retries after a failed validation: ExponentialBackoff,
+ * RandomizedBackoff, YieldBackoff<N> or NoBackoff.
+ * Instrumentation is NoInstrumentation, or Instrumented to record add(), remove()
+ * and contains(), batches included; see instrumentation().
  */
-template<typename T> class OptimisticList {
-    private: 
+template<typename T, typename Reclaimer = EpochReclaimer, typename Allocator = HeapAllocator, typename Order = HashOrder<T>, typename Lock = SpinLock, typename Backoff = ExponentialBackoff, typename Instrumentation = NoInstrumentation> class OptimisticList {
+    protected:
         /**
-         * Inner nested node class.
+         * Inner nested node class. What every traversal reads, key and next, comes
+         * first, and the mark lives in next's low bit, so one load gets both. The lock
+         * comes after them, a single byte with SpinLock.
          */
         class Node{
             public:
                 //
-                // Item being stored
-                T item; 
+                // Order's key for the item
+                size_t key;
 
                 //
-                // Hash of the item
-                size_t key;
+                // Next node in the chain, written under the lock and read without it.
+                // The mark is set under the lock right before the node is unlinked.
+                // Validation, contains() and the reclaimer all rely on it.
+                AtomicMarkableReference<Node> next;
 
                 //
-                // Next node in the chain
-                // Node *next;
-                std::shared_ptr<Node> next;
+                // Bumped under the lock after every change to next or the mark. A pred
+                // whose version still matches what find() saw has not changed at all.
+                std::atomic<std::uint32_t> version{0};
 
                 //
                 // Lock for a node.
-                std::mutex mutex;
-                std::atomic<bool> isLocked{false};
+                Lock mutex;
+
+                //
+                // Item being stored
+                T item;
 
                 /**
-                 * Regular Node constructor 
+                 * Regular Node constructor
                  */
                 Node(T item, size_t key) {
                     this->item = item;
                     this->key = key;
-                    this->next = nullptr;
                 }
 
                 /**
@@ -60,7 +109,6 @@ template<typename T> class OptimisticList {
                  */
                 Node(size_t key){
                     this->key = key;
-                    this->next = nullptr;
                 }
 
                 /**
@@ -68,275 +116,628 @@ template<typename T> class OptimisticList {
                  */
                 void lock(){
                     mutex.lock();
-                    isLocked.store(true);
                 }
 
                 /**
-                 * Unlock the node if locked.
+                 * Lock the node if nobody holds it. Only for a Lock with try_lock().
+                 */
+                bool tryLock(){
+                    return mutex.try_lock();
+                }
+
+                /**
+                 * Unlock the node
                  */
                 void unlock(){
-                    if (isLocked.exchange(false)) {
-                        mutex.unlock();
-                    }
+                    mutex.unlock();
+                }
+
+                /**
+                 * Is this node logically removed?
+                 */
+                bool isMarked() const {
+                    return next.isMarked();
+                }
+
+                /**
+                 * Record a change. Only called with the lock held, after the change.
+                 */
+                void bump(){
+                    version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+                }
+        };
+
+        /**
+         * Inner nested Window class.
+         */
+        class Window {
+            public:
+                //
+                // The nodes of the window.
+                Node* pred;
+                Node* curr;
+
+                //
+                // pred's version when its next was read, and the hazard slot holding pred.
+                std::uint32_t predVersion;
+                int predSlot;
+
+                /**
+                 * Window constructor
+                 */
+                Window(Node* pred, Node* curr, std::uint32_t predVersion, int predSlot) {
+                    this->curr = curr;
+                    this->pred = pred;
+                    this->predVersion = predVersion;
+                    this->predSlot = predSlot;
                 }
         };
 
+        using Guard = typename Reclaimer::Guard;
+
         //
         // The head and tail of the singly linked list implementation of OptimisticList.
-        // Node head;
-        std::shared_ptr<Node> head = std::make_shared<Node>(0);
+        Node head;
+        Node tail;
 
         //
-        // The std hashing object, so we don't need to initate it multiple times.
-        hash<T> hasher;
+        // Frees removed nodes once no traversal can be standing on them.
+        Reclaimer reclaimer;
 
-    public: 
         /**
-         * The constructor for the OptimisticList. It initiates the head and tail.
+         * Does node come before (key, item)? The tail comes after everything.
          */
-        OptimisticList() {
-            std::shared_ptr<Node> tail = std::make_shared<Node>(std::numeric_limits<std::size_t>::max());
-            head->next = tail;
+        bool before(const Node* node, size_t key, const T& item) const {
+            return node != &tail && precedes<Order>(node->key, node->item, key, item);
         }
 
         /**
-         * The destructor for the OptimisticList. It clears all dynamically allocated memory.
-         * What happens if this is called while other threads are doing work?
+         * Does node hold item? Only asked once before() is false.
          */
-        ~OptimisticList(){
-            //
-            // This should be enough in theory, since head is the only saved reference.
-            head.reset();
+        bool holds(const Node* node, size_t key, const T& item) const {
+            return node != &tail && node->key == key && !Order::less(item, node->item);
+        }
+
+        //
+        // Updates, failed validations, and how many of those went back to head.
+        StripedCounter operations;
+        StripedCounter retries;
+        StripedCounter restarts;
+
+        //
+        // Node locks that were taken when asked for, and the time spent waiting for them.
+        StripedCounter lockWaits;
+        StripedCounter lockWaitNanos;
+
+        //
+        // Brackets every insert and mark, so exactSize() and LazyList's snapshots can
+        // tell whether they raced one.
+        UpdateTracker updates;
+
+        //
+        // Successful adds and removes, counted inside the brackets.
+        StripedSize count;
+
+        //
+        // Per-thread numbers, if Instrumentation records any.
+        Instrumentation instruments;
+
+        using Probe = typename Instrumentation::Probe;
+
+        /**
+         * Deleter handed to the reclaimer.
+         */
+        static void destroyNode(void* node){
+            Allocator::destroy(static_cast<Node*>(node));
         }
 
         /**
-         * Check that prev and curr are still in list and adjacent
-         * @param pred predecessor node
-         * @param curr current node
-         * @return whther predecessor and current have changed
+         * Lock a node, counting and timing the wait if somebody holds it. The clock
+         * is only read once try_lock() has failed, an uncontended lock costs nothing.
          */
-        bool validate(std::shared_ptr<Node> prev, std::shared_ptr<Node> curr){
-            std::shared_ptr<Node> node = head;
-            while (node != nullptr && node->key <= prev->key){
-                if (node->key == prev->key){
-                    return prev->next == curr;
+        void lockNode(Node* node, Probe& probe){
+            if constexpr (isTryLockable<Lock>::value){
+                if (node->tryLock()){
+                    return;
                 }
-                node = node->next;
             }
-            return false;
+            auto begin = std::chrono::steady_clock::now();
+            node->lock();
+            std::uint64_t waited = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count());
+            lockWaits.add();
+            lockWaitNanos.add(waited);
+            probe.waited(waited);
         }
 
         /**
-         * Add an element.
-         * @param item element to add
-         * @return true iff element was not there already
+         * Find the insertion spot without locking. pred and curr are protected in the guard.
+         * @param guard the operation's reclamation guard
+         * @param key key to search for
+         * @param item item to search for
+         * @param start where to start, head or a node with a smaller key
+         * @param startSlot the hazard slot start is protected in
+         * @param traversed has the number of nodes stepped over added to it
+         * @return the window (pred, curr), pred before (key, item) and curr not
          */
-        bool add(T item) {
-            //
-            // Get the hash of the item we are trying to insert.
-            size_t key = hasher(item);
+        Window find(Guard& guard, size_t key, const T& item, Node* start, int startSlot, std::size_t& traversed){
+            while (true){
+                //
+                // Rotating hazard slots, a pointer never moves between slots.
+                int predSlot = startSlot, currSlot = (startSlot + 1) % 3, nextSlot = (startSlot + 2) % 3;
 
-            //
-            // Lock the head, and set it as prev.
-            std::shared_ptr<Node> prev;
-            std::shared_ptr<Node> curr;
+                //
+                // Every node's version is read before its next, so a later change to
+                // either one shows up as a new version.
+                Node* pred = start;
+                std::uint32_t predVersion = pred->version.load(std::memory_order_acquire);
+                Node* curr = guard.protect(currSlot, [&]{ return pred->next.getReference(); });
+
+                //
+                // A marked start may already be unlinked, go back to head.
+                bool restart = pred->isMarked();
+                while (!restart && before(curr, key, item)){
+                    std::uint32_t currVersion = curr->version.load(std::memory_order_acquire);
+                    bool marked = false;
+                    Node* next = guard.protect(nextSlot, [&]{ return curr->next.get(marked); });
+
+                    //
+                    // A marked node may already be unlinked, so next may already be retired.
+                    if (Reclaimer::validatesTraversal && marked){
+                        restart = true;
+                        break;
+                    }
+
+                    int freeSlot = predSlot;
+                    predSlot = currSlot;
+                    currSlot = nextSlot;
+                    nextSlot = freeSlot;
 
-            prev = head;
+                    pred = curr;
+                    predVersion = currVersion;
+                    curr = next;
+                    traversed++;
+                }
+
+                if (!restart){
+                    return Window(pred, curr, predVersion, predSlot);
+                }
+                restarts.add();
+                start = &head;
+                startSlot = 0;
+            }
+        }
+
+        /**
+         * The window an update locked, pred and curr. Both are unlocked when it goes
+         * out of scope, however the attempt ends.
+         */
+        class LockedWindow {
+            private:
+                Node* prev;
+                Node* curr;
+
+            public:
+                LockedWindow(OptimisticList& list, Node* prev, Node* curr, Probe& probe) : prev(prev), curr(curr) {
+                    list.lockNode(prev, probe);
+                    list.lockNode(curr, probe);
+                    probe.holding();
+                }
+
+                ~LockedWindow(){
+                    prev->unlock();
+                    curr->unlock();
+                }
+
+                LockedWindow(const LockedWindow&) = delete;
+                LockedWindow& operator=(const LockedWindow&) = delete;
+        };
+
+        /**
+         * Add an element, searching from start. Shared by tryAdd() and addAll().
+         * @param guard the operation's reclamation guard
+         * @param item element to add
+         * @param key its key
+         * @param start where to search from, left at the window's pred for the next search
+         * @param startSlot the hazard slot start is protected in, moves with it
+         * @param probe the element's instrumentation
+         * @return ADDED, PRESENT if it was there already, or OUT_OF_MEMORY
+         */
+        AddStatus insert(Guard& guard, T item, size_t key, Node*& start, int& startSlot, Probe& probe) noexcept {
+            operations.add();
+            Backoff backoff;
 
             //
             // Until validation is true (optimistically, this loop will only execute once)
             while (true){
-                //
-                // Find the insertion spot without locking.
-                curr = prev->next;
-                while (curr->key < key){
-                    prev = curr;
-                    curr = curr->next;
-                }
+                std::size_t traversed = 0;
+                Window window = find(guard, key, item, start, startSlot, traversed);
+                probe.traversed(traversed);
+                Node* prev = window.pred;
+                Node* curr = window.curr;
 
-                prev->lock();
-                curr->lock();
+                //
+                // The next search, whether a retry or the next key of a batch, starts here.
+                start = prev;
+                startSlot = window.predSlot;
 
-                try{
-                    if (validate(prev, curr)){
+                {
+                    LockedWindow locked(*this, prev, curr, probe);
+                    if (validate(prev, window.predVersion)){
                         //
-                        // If the item already exists in the list, return false.
-                        if (key == curr->key){
-                            prev->unlock();
-                            curr->unlock();
-                            return false;
+                        // If the item already exists in the list, there is nothing to do.
+                        if (holds(curr, key, item)){
+                            probe.released();
+                            return AddStatus::PRESENT;
                         }
 
                         //
                         // Insert the node.
-                        std::shared_ptr<Node> newNode = std::make_shared<Node>(item, key);
-
-                        newNode->next = curr;
-                        prev->next = newNode;
+                        Node* newNode = Allocator::template tryCreate<Node>(item, key);
+                        if (newNode == nullptr){
+                            probe.released();
+                            return AddStatus::OUT_OF_MEMORY;
+                        }
+                        probe.allocated();
 
-                        prev->unlock();
-                        curr->unlock();
+                        newNode->next.set(curr, false);
+                        updates.begin();
+                        prev->next.set(newNode, false);
+                        count.added();
+                        updates.end();
+                        prev->bump();
 
-                        return true;
+                        probe.released();
+                        return AddStatus::ADDED;
                     }
-                    else {
-                        //
-                        // If validation did not work, we start over again.
-                        continue;
-                    }
-                }
-                catch (...) {
-                    cout << "Something went wrong during add(). \n";
-                    prev->unlock();
-                    curr->unlock();
-                    prev = head;
                 }
+
+                //
+                // If validation did not work, we look again from prev. Its key is
+                // still below ours, find() goes back to head if it was removed.
+                retries.add();
+                backoff.pause();
             }
         }
 
         /**
-         * Remove an element.
-         * 
-         * #TODO Nodes are removed instantly, and since we don't get a lock
-         * to traverse the list, it is possible to have a thread try to reference a node
-         * that has been deleted. I think smart pointers are the solution... 
-         * 
-         * 
-         * Also, C++20 has atomic smart pointers, but that is kind of cheating?
-         * 
-         * I'll try using std::shared_ptr instead of regular pointers for nodes. Ask Dr. Mendes about this issue.
-         * 
+         * Remove an element, searching from start. Shared by remove() and removeAll().
+         *
+         * Nodes are marked first and then unlinked, so a traversal that is standing
+         * on one can tell. The reclaimer frees them once no traversal can reach them.
+         *
+         * @param guard the operation's reclamation guard
          * @param item element to remove
+         * @param key its key
+         * @param start where to search from, left at the window's pred for the next search
+         * @param startSlot the hazard slot start is protected in, moves with it
+         * @param probe the element's instrumentation
          * @return true if element was present
          */
-        bool remove(T item) {
-            //
-            // Get the hash of the item we are trying to remove.
-            size_t key = hasher(item);
-
-            //
-            // Lock the head, and set it as prev.
-            std::shared_ptr<Node> prev;
-            std::shared_ptr<Node> curr;
-
-            prev = head;
+        bool erase(Guard& guard, const T& item, size_t key, Node*& start, int& startSlot, Probe& probe){
+            operations.add();
+            Backoff backoff;
 
             //
             // Until validation is true (optimistically, this loop will only execute once)
             while (true){
-                //
-                // Find the remove spot without locking.
-                curr = prev->next;
-                while (curr->key < key){
-                    prev = curr;
-                    curr = curr->next;
-                }
-
-                prev->lock();
-                curr->lock();
+                std::size_t traversed = 0;
+                Window window = find(guard, key, item, start, startSlot, traversed);
+                probe.traversed(traversed);
+                Node* prev = window.pred;
+                Node* curr = window.curr;
 
-                try{
-                    if (validate(prev, curr)){
+                //
+                // The next search, whether a retry or the next key of a batch, starts here.
+                start = prev;
+                startSlot = window.predSlot;
+
+                bool validated;
+                {
+                    LockedWindow locked(*this, prev, curr, probe);
+                    validated = validate(prev, window.predVersion);
+                    if (validated){
                         //
                         // If the item does not exist in the list, return false.
-                        if (key != curr->key){
-                            prev->unlock();
-                            curr->unlock();
+                        if (!holds(curr, key, item)){
+                            probe.released();
                             return false;
                         }
 
                         //
-                        // Remove the node, the smart pointer should dereference it in theory.
-                        prev->next = curr->next;
-
-                        curr->unlock();
-                        prev->unlock();
-                        return true;
-                    }
-                    else {
-                        //
-                        // If validation did not work, we start over again.
-                        continue;
+                        // Logically remove, then unlink.
+                        updates.begin();
+                        curr->next.set(curr->next.getReference(), true);
+                        count.removed();
+                        updates.end();
+                        curr->bump();
+                        prev->next.set(curr->next.getReference(), false);
+                        prev->bump();
+
+                        probe.released();
                     }
                 }
-                catch (...) {
-                    prev->unlock();
-                    curr->unlock();
 
-                    cout << "Something went wrong during remove(). \n";
-                    
-                    prev = head;
-                    return false;
+                if (!validated){
+                    //
+                    // If validation did not work, we look again from prev. Its key is
+                    // still below ours, find() goes back to head if it was removed.
+                    retries.add();
+                    backoff.pause();
+                    continue;
                 }
+
+                //
+                // The locks are gone, retire the node.
+                guard.retire(curr, &destroyNode);
+                probe.freed();
+                return true;
+            }
+        }
+
+    public:
+        /**
+         * The constructor for the OptimisticList. It initiates the head and tail.
+         */
+        OptimisticList() : head(std::numeric_limits<std::size_t>::min()), tail(std::numeric_limits<std::size_t>::max()){
+            head.next.set(&tail, false);
+        }
+
+        /**
+         * The destructor for the OptimisticList. It clears all dynamically allocated memory.
+         * Removed nodes are freed by the reclaimer's destructor.
+         * What happens if this is called while other threads are doing work?
+         */
+        ~OptimisticList(){
+            Node* curr = head.next.getReference();
+            while (curr != &tail){
+                Node* temp = curr;
+                curr = curr->next.getReference();
+                Allocator::destroy(temp);
+            }
+        }
+
+        /**
+         * Check that prev and curr are still in list and adjacent, with prev locked.
+         * An unmarked prev is in the list, and if its version has not moved its next is
+         * still curr. curr cannot have been removed either, that would have changed prev.
+         * @param prev predecessor node
+         * @param prevVersion prev's version when find() read its next
+         * @return whther predecessor and current have changed
+         */
+        bool validate(Node* prev, std::uint32_t prevVersion){
+            return !prev->isMarked() && prev->version.load(std::memory_order_acquire) == prevVersion;
+        }
+
+        /**
+         * How many times add() and remove() had to retry, and how long they waited
+         * for node locks, since the list was made.
+         * @return the counters, a snapshot if threads are still running
+         */
+        RetryStats retryStats() const {
+            RetryStats stats;
+            stats.operations = operations.sum();
+            stats.retries = retries.sum();
+            stats.restarts = restarts.sum();
+            stats.lockWaits = lockWaits.sum();
+            stats.lockWaitNanos = lockWaitNanos.sum();
+            return stats;
+        }
+
+        /**
+         * Add an element.
+         * @param item element to add
+         * @return true iff element was not there already
+         * @throws std::bad_alloc if there is no memory for the node, the list is unchanged
+         */
+        bool add(T item) {
+            AddStatus status = tryAdd(item);
+            if (status == AddStatus::OUT_OF_MEMORY){
+                throw std::bad_alloc();
+            }
+            return status == AddStatus::ADDED;
+        }
+
+        /**
+         * Add an element without throwing. A thread's first operation on the list
+         * registers it with the reclaimer; no memory for that comes back as
+         * OUT_OF_MEMORY too.
+         * @param item element to add
+         * @return ADDED, PRESENT if it was there already, or OUT_OF_MEMORY
+         */
+        AddStatus tryAdd(T item) noexcept {
+            //
+            // Get the key of the item we are trying to insert.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::ADD);
+            Guard guard(reclaimer, std::nothrow);
+            if (!guard){
+                return AddStatus::OUT_OF_MEMORY;
             }
+            Node* start = &head;
+            int startSlot = 0;
+
+            return insert(guard, item, key, start, startSlot, probe);
+        }
+
+        /**
+         * Remove an element.
+         * @param item element to remove
+         * @return true if element was present
+         */
+        bool remove(T item) {
+            //
+            // Get the key of the item we are trying to remove.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::REMOVE);
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            return erase(guard, item, key, start, startSlot, probe);
         }
 
         /**
-         * Test whether element is present
+         * Test whether element is present. Takes no locks: remove() marks a node before
+         * unlinking it, so an unmarked node with the key is in the list. Wait-free with
+         * EpochReclaimer, hazard pointers have to restart when they land on a marked node.
          * @param item element to test
          * @return true iff element is present
          */
         bool contains(T item) {
             //
-            // Get the hash of the item we are trying to find.
-            size_t key = hasher(item);
+            // Get the key of the item we are trying to find.
+            size_t key = Order::key(item);
+            Probe probe(instruments, ListOperation::CONTAINS);
+            Guard guard(reclaimer);
 
             //
-            // Lock the head, and set it as prev.
-            std::shared_ptr<Node> prev;
-            std::shared_ptr<Node> curr;
-
-            prev = head;
+            // Try to find the item...
+            std::size_t traversed = 0;
+            Window window = find(guard, key, item, &head, 0, traversed);
+            probe.traversed(traversed);
+            Node* curr = window.curr;
 
             //
-            // Until validation is true (optimistically, this loop will only execute once)
-            while (true){
-                //
-                // Find the insertion spot without locking.
-                curr = prev->next;
-                while (curr->key < key){
-                    prev = curr;
-                    curr = curr->next;
-                }
-
-                prev->lock();
-                curr->lock();
+            // If we find it, and it is not marked for deletion.
+            return !curr->isMarked() && holds(curr, key, item);
+        }
 
-                try{
-                    if (validate(prev, curr)){
-                        //
-                        // If the item exists in the list, return true.
-                        if (key == curr->key){
-                            prev->unlock();
-                            curr->unlock();
-                            return true;
-                        }
-                        else {
-                            prev->unlock();
-                            curr->unlock();
-                            return false;
-                        }
-                    }
-                    else {
-                        //
-                        // If validation did not work, we start over again.
-                        continue;
-                    }
+        /**
+         * Add every element of a batch in one walk: each search starts where the
+         * previous key's window was. Each element is added atomically, the batch as
+         * a whole is not.
+         * @param items elements to add, in any order
+         * @param results if not null, results[i] is what add(items[i]) would have returned
+         * @return how many elements were added
+         * @throws std::bad_alloc if there is no memory for a node, the elements added
+         *         before it stay in the list
+         */
+        std::size_t addAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            std::size_t added = 0;
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            for (const BatchEntry& entry : batch){
+                Probe probe(instruments, ListOperation::ADD);
+                AddStatus status = insert(guard, items[entry.index], entry.key, start, startSlot, probe);
+                if (status == AddStatus::OUT_OF_MEMORY){
+                    throw std::bad_alloc();
                 }
-                catch (...) {
-                    cout << "Something went wrong during contains(). \n";
-                    prev->unlock();
-                    curr->unlock();
-                    prev = head;
+                bool result = status == AddStatus::ADDED;
+                added += result ? 1 : 0;
+                if (results != nullptr){
+                    (*results)[entry.index] = result;
                 }
             }
+            return added;
         }
-};
 
+        /**
+         * Remove every element of a batch in one walk: each search starts where the
+         * previous key's window was. Each element is removed atomically, the batch as
+         * a whole is not.
+         * @param items elements to remove, in any order
+         * @param results if not null, results[i] is what remove(items[i]) would have returned
+         * @return how many elements were removed
+         */
+        std::size_t removeAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            std::size_t removed = 0;
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            for (const BatchEntry& entry : batch){
+                Probe probe(instruments, ListOperation::REMOVE);
+                bool result = erase(guard, items[entry.index], entry.key, start, startSlot, probe);
+                removed += result ? 1 : 0;
+                if (results != nullptr){
+                    (*results)[entry.index] = result;
+                }
+            }
+            return removed;
+        }
 
+        /**
+         * Test a whole batch in one walk: each search starts where the previous key's
+         * window was. Each element is tested atomically, the batch as a whole is not.
+         * @param items elements to test, in any order
+         * @param results if not null, results[i] is what contains(items[i]) would have returned
+         * @return true iff every element is present
+         */
+        bool containsAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            bool all = true;
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            for (const BatchEntry& entry : batch){
+                Probe probe(instruments, ListOperation::CONTAINS);
+                std::size_t traversed = 0;
+                Window window = find(guard, entry.key, items[entry.index], start, startSlot, traversed);
+                probe.traversed(traversed);
+                start = window.pred;
+                startSlot = window.predSlot;
+
+                bool found = !window.curr->isMarked() && holds(window.curr, entry.key, items[entry.index]);
+                all = all && found;
+                if (results != nullptr){
+                    (*results)[entry.index] = found;
+                }
+            }
+            return all;
+        }
 
+        /**
+         * Number of elements, O(threads). Exact while no update is running, close
+         * to it while some are.
+         * @return the element count
+         */
+        std::size_t size() const {
+            return count.get();
+        }
 
+        /**
+         * Number of elements as of one moment. O(threads) too, unless updates keep
+         * racing it, then they wait for it.
+         * @return the element count
+         */
+        std::size_t exactSize() {
+            std::size_t elements = 0;
+            updates.snapshot([&]{
+                elements = count.get();
+            });
+            return elements;
+        }
 
+        /**
+         * @return bytes per element, for the benchmark's memory column
+         */
+        static constexpr std::size_t nodeSize(){
+            return sizeof(Node);
+        }
 
+        /**
+         * What add(), remove() and contains() recorded, empty unless Instrumentation
+         * is Instrumented. A batch counts as one operation per element, and the lock
+         * hold time is the validated window's.
+         * @return the numbers so far, merged over threads
+         */
+        InstrumentationReport instrumentation() const {
+            return instruments.report();
+        }
+};
 
-#endif 
\ No newline at end of file
+#endif
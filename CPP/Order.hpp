@@ -0,0 +1,87 @@
+#ifndef ORDER_HPP
+#define ORDER_HPP
+
+//
+// Used for hashing and comparing
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+/**
+ * The lists keep their items sorted by (key, item): the size_t key first, it is
+ * cheap and decides almost every comparison, then Compare on the items for the
+ * keys that tie. Two items are the same item iff neither is less than the other,
+ * so colliding keys no longer make distinct items look equal.
+ *
+ * An Order has two static functions:
+ *   key(item)   the item's size_t key
+ *   less(a, b)  the tie break, a strict weak order on items
+ */
+
+/**
+ * Order by hash, the default. Equal items must hash equally, which std::hash does.
+ * Walks are short for any key distribution, but the order says nothing about the
+ * items, so range scans make no sense.
+ */
+template<typename T, typename Hash = std::hash<T>, typename Compare = std::less<T>> class HashOrder {
+    public:
+        //
+        // The order is not the items' own order.
+        static constexpr bool ordersItems = false;
+
+        static std::size_t key(const T& item){
+            return Hash()(item);
+        }
+
+        static bool less(const T& a, const T& b){
+            return Compare()(a, b);
+        }
+};
+
+/**
+ * Order by the items themselves. Integral items under std::less get a key that
+ * preserves their order, so they compare as fast as hashed ones. Anything else
+ * gets key 0 and every comparison goes to Compare.
+ */
+template<typename T, typename Compare = std::less<T>> class DirectOrder {
+    private:
+        //
+        // Can the key carry the whole order?
+        static constexpr bool integralKey = std::is_integral<T>::value && sizeof(T) <= sizeof(std::size_t)
+                                            && std::is_same<Compare, std::less<T>>::value;
+
+    public:
+        //
+        // Walking the list visits items in Compare order.
+        static constexpr bool ordersItems = true;
+
+        static std::size_t key(const T& item){
+            if constexpr (integralKey){
+                //
+                // Flip the sign bit so negative items come first.
+                using Unsigned = typename std::make_unsigned<T>::type;
+                std::size_t bits = static_cast<Unsigned>(item);
+                if constexpr (std::is_signed<T>::value){
+                    bits ^= static_cast<std::size_t>(1) << (std::numeric_limits<Unsigned>::digits - 1);
+                }
+                return bits;
+            }
+            else {
+                return 0;
+            }
+        }
+
+        static bool less(const T& a, const T& b){
+            return Compare()(a, b);
+        }
+};
+
+/**
+ * Does (nodeKey, nodeItem) come strictly before (key, item)?
+ */
+template<typename Order, typename T> bool precedes(std::size_t nodeKey, const T& nodeItem, std::size_t key, const T& item){
+    return nodeKey < key || (nodeKey == key && Order::less(nodeItem, item));
+}
+
+#endif
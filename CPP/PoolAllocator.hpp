@@ -0,0 +1,261 @@
+#ifndef POOL_ALLOCATOR_HPP
+#define POOL_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "ThreadRegistry.hpp"
+
+/**
+ * Node allocator backed by per-thread free lists of fixed size blocks.
+ *
+ * Every block size gets its own pool, and a node type's blocks are just big enough
+ * for it: sizeof(Node) rounded up to its alignment, so a compact 24 byte node costs
+ * 24 bytes. A thread allocates from and frees to its own free list without any
+ * synchronization. Blocks move between threads in whole batches through a small
+ * global pool behind a mutex, which is also where new slabs are carved. Memory
+ * goes back to the system only at exit.
+ *
+ * Alignment is the least a block is aligned to, and rounded up to. The default
+ * packs nodes; PoolAllocator<CACHE_LINE_SIZE> gives every node its own cache lines,
+ * which costs 64 bytes a node but keeps updates to neighbouring nodes from sharing
+ * a line.
+ */
+template<std::size_t Alignment = alignof(void*)> class PoolAllocator {
+    static_assert(Alignment >= alignof(void*) && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two that fits a pointer.");
+
+    private:
+        /**
+         * One pool per block size and alignment.
+         */
+        template<std::size_t BlockSize, std::size_t BlockAlignment> class SizeClass {
+            private:
+                /**
+                 * A free block, the link lives inside the block itself.
+                 */
+                class Block {
+                    public:
+                        Block* next;
+                };
+
+                /**
+                 * A chain of free blocks and its length.
+                 */
+                class Batch {
+                    public:
+                        Block* head;
+                        std::size_t count;
+                };
+
+                //
+                // Blocks moved between a thread and the global pool at a time.
+                static constexpr std::size_t BATCH_SIZE = 64;
+
+                //
+                // Blocks carved per slab.
+                static constexpr std::size_t SLAB_BLOCKS = BATCH_SIZE * 4;
+
+                /**
+                 * Batches of free blocks shared by all threads, and every slab.
+                 */
+                class GlobalPool {
+                    public:
+                        std::mutex lock;
+                        std::vector<Batch> batches;
+                        std::vector<void*> slabs;
+
+                        ~GlobalPool(){
+                            for (void* slab : slabs){
+                                ::operator delete(slab, std::align_val_t(BlockAlignment));
+                            }
+                        }
+
+                        /**
+                         * Take one batch, carving a fresh slab if there are none.
+                         * @return a batch of at least one block, or an empty one if out of memory
+                         */
+                        Batch takeBatch(){
+                            std::lock_guard<std::mutex> guard(lock);
+                            if (batches.empty()){
+                                void* slab = ::operator new(BlockSize * SLAB_BLOCKS, std::align_val_t(BlockAlignment), std::nothrow);
+                                if (slab == nullptr){
+                                    return Batch{nullptr, 0};
+                                }
+                                //
+                                // Room for the bookkeeping first, so running out of memory
+                                // is reported the same way here too.
+                                try {
+                                    slabs.push_back(slab);
+                                    batches.reserve(batches.size() + SLAB_BLOCKS / BATCH_SIZE);
+                                }
+                                catch (const std::bad_alloc&) {
+                                    if (!slabs.empty() && slabs.back() == slab){
+                                        slabs.pop_back();
+                                    }
+                                    ::operator delete(slab, std::align_val_t(BlockAlignment));
+                                    return Batch{nullptr, 0};
+                                }
+
+                                char* bytes = static_cast<char*>(slab);
+                                for (std::size_t b = 0; b < SLAB_BLOCKS; b += BATCH_SIZE){
+                                    Block* chain = nullptr;
+                                    for (std::size_t i = b + BATCH_SIZE; i-- > b; ){
+                                        Block* block = reinterpret_cast<Block*>(bytes + i * BlockSize);
+                                        block->next = chain;
+                                        chain = block;
+                                    }
+                                    batches.push_back(Batch{chain, BATCH_SIZE});
+                                }
+                            }
+                            Batch batch = batches.back();
+                            batches.pop_back();
+                            return batch;
+                        }
+
+                        /**
+                         * Give back a batch of blocks.
+                         */
+                        void putBatch(Batch batch){
+                            std::lock_guard<std::mutex> guard(lock);
+                            batches.push_back(batch);
+                        }
+                };
+
+                /**
+                 * A thread's own free list. Whatever is left goes back when the thread exits.
+                 */
+                class ThreadCache {
+                    public:
+                        Block* head = nullptr;
+                        std::size_t count = 0;
+
+                        ~ThreadCache(){
+                            if (head != nullptr){
+                                global().putBatch(Batch{head, count});
+                            }
+                        }
+                };
+
+                static GlobalPool& global(){
+                    static GlobalPool pool;
+                    return pool;
+                }
+
+                static ThreadCache& cache(){
+                    thread_local ThreadCache threadCache;
+                    return threadCache;
+                }
+
+            public:
+                /**
+                 * @return a free block, or nullptr if out of memory
+                 */
+                static void* allocate(){
+                    ThreadCache& local = cache();
+                    if (local.head == nullptr){
+                        Batch batch = global().takeBatch();
+                        if (batch.head == nullptr){
+                            return nullptr;
+                        }
+                        local.head = batch.head;
+                        local.count = batch.count;
+                    }
+                    Block* block = local.head;
+                    local.head = block->next;
+                    local.count--;
+                    return block;
+                }
+
+                /**
+                 * Free a block. Half of the cache goes back to the global pool when it
+                 * gets too long, so a thread that only frees doesn't hoard memory.
+                 */
+                static void deallocate(void* memory){
+                    ThreadCache& local = cache();
+                    Block* block = static_cast<Block*>(memory);
+                    block->next = local.head;
+                    local.head = block;
+                    local.count++;
+
+                    if (local.count >= 2 * BATCH_SIZE){
+                        Block* chain = local.head;
+                        Block* last = chain;
+                        for (std::size_t i = 1; i < BATCH_SIZE; i++){
+                            last = last->next;
+                        }
+                        local.head = last->next;
+                        local.count -= BATCH_SIZE;
+                        last->next = nullptr;
+                        global().putBatch(Batch{chain, BATCH_SIZE});
+                    }
+                }
+        };
+
+        /**
+         * Block alignment used for a node type: the node's own, or Alignment if that is more.
+         */
+        template<typename Node> static constexpr std::size_t blockAlignment(){
+            return alignof(Node) < Alignment ? Alignment : alignof(Node);
+        }
+
+        /**
+         * Block size used for a node type, room for the node or a free list link.
+         */
+        template<typename Node> static constexpr std::size_t blockSize(){
+            std::size_t size = sizeof(Node) < sizeof(void*) ? sizeof(void*) : sizeof(Node);
+            return (size + blockAlignment<Node>() - 1) / blockAlignment<Node>() * blockAlignment<Node>();
+        }
+
+        /**
+         * The pool a node type's blocks come from.
+         */
+        template<typename Node> using PoolFor = SizeClass<blockSize<Node>(), blockAlignment<Node>()>;
+
+    public:
+        /**
+         * Allocate and construct a node.
+         */
+        template<typename Node, typename... Args> static Node* create(Args&&... args){
+            using Pool = PoolFor<Node>;
+
+            void* memory = Pool::allocate();
+            if (memory == nullptr){
+                throw std::bad_alloc();
+            }
+            try {
+                return new (memory) Node(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                Pool::deallocate(memory);
+                throw;
+            }
+        }
+
+        /**
+         * Allocate and construct a node, or return null if there is no memory.
+         * Node's constructor must not throw.
+         */
+        template<typename Node, typename... Args> static Node* tryCreate(Args&&... args) noexcept {
+            using Pool = PoolFor<Node>;
+
+            void* memory = Pool::allocate();
+            if (memory == nullptr){
+                return nullptr;
+            }
+            return new (memory) Node(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Destroy a node made by create() or tryCreate() and return its block to this
+         * thread's pool.
+         */
+        template<typename Node> static void destroy(Node* node){
+            node->~Node();
+            PoolFor<Node>::deallocate(node);
+        }
+};
+
+#endif
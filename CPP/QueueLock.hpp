@@ -0,0 +1,174 @@
+#ifndef QUEUE_LOCK_HPP
+#define QUEUE_LOCK_HPP
+
+//
+// Used for the queue
+#include <atomic>
+#include <vector>
+
+#include "SpinLock.hpp"
+#include "ThreadRegistry.hpp"
+
+/**
+ * A waiter's place in an MCS or CLH queue. Its owner spins on it, so it gets a
+ * cache line to itself.
+ */
+class alignas(CACHE_LINE_SIZE) QueueNode {
+    public:
+        std::atomic<bool> locked{false};
+        std::atomic<QueueNode*> next{nullptr};
+};
+
+/**
+ * This thread's spare queue nodes. A thread can hold several queue locks at once,
+ * FineList holds two, so one node per thread is not enough. CLH nodes also change
+ * hands: a releasing thread keeps its predecessor's node.
+ */
+class QueueNodePool {
+    private:
+        std::vector<QueueNode*> spare;
+
+    public:
+        ~QueueNodePool(){
+            for (QueueNode* node : spare){
+                delete node;
+            }
+        }
+
+        static QueueNodePool& local(){
+            thread_local QueueNodePool pool;
+            return pool;
+        }
+
+        QueueNode* take(){
+            if (spare.empty()){
+                return new QueueNode();
+            }
+            QueueNode* node = spare.back();
+            spare.pop_back();
+            return node;
+        }
+
+        void give(QueueNode* node){
+            spare.push_back(node);
+        }
+};
+
+/**
+ * Mellor-Crummey and Scott queue lock.
+ *
+ * Waiters line up in a linked queue and each spins on its own node, so a release
+ * touches exactly one waiter's cache line, and the lock is handed over first come
+ * first served. 16 bytes.
+ */
+class MCSLock {
+    private:
+        std::atomic<QueueNode*> tail{nullptr};
+
+        //
+        // The holder's node. Only the holder reads or writes it.
+        QueueNode* holder = nullptr;
+
+    public:
+        void lock(){
+            QueueNode* node = QueueNodePool::local().take();
+            node->next.store(nullptr, std::memory_order_relaxed);
+            node->locked.store(true, std::memory_order_relaxed);
+
+            QueueNode* pred = tail.exchange(node, std::memory_order_acq_rel);
+            if (pred != nullptr){
+                pred->next.store(node, std::memory_order_release);
+                SpinWait wait;
+                while (node->locked.load(std::memory_order_acquire)){
+                    wait.pause();
+                }
+            }
+            holder = node;
+        }
+
+        bool try_lock(){
+            QueueNode* node = QueueNodePool::local().take();
+            node->next.store(nullptr, std::memory_order_relaxed);
+
+            QueueNode* expected = nullptr;
+            if (tail.compare_exchange_strong(expected, node, std::memory_order_acq_rel)){
+                holder = node;
+                return true;
+            }
+            QueueNodePool::local().give(node);
+            return false;
+        }
+
+        void unlock(){
+            QueueNode* node = holder;
+            QueueNode* succ = node->next.load(std::memory_order_acquire);
+            if (succ == nullptr){
+                //
+                // Nobody queued, or somebody is between the exchange and linking in.
+                QueueNode* expected = node;
+                if (tail.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)){
+                    QueueNodePool::local().give(node);
+                    return;
+                }
+                SpinWait wait;
+                while ((succ = node->next.load(std::memory_order_acquire)) == nullptr){
+                    wait.pause();
+                }
+            }
+            succ->locked.store(false, std::memory_order_release);
+            QueueNodePool::local().give(node);
+        }
+};
+
+/**
+ * Craig, Landin and Hagersten queue lock.
+ *
+ * Like MCS, but a waiter spins on its predecessor's node, so the queue needs no
+ * next pointers and a release is a single store. A releasing thread keeps its
+ * predecessor's node for next time. 24 bytes, plus the node the lock starts with.
+ * There is no try_lock, a CLH waiter cannot leave the queue.
+ */
+class CLHLock {
+    private:
+        std::atomic<QueueNode*> tail;
+
+        //
+        // The holder's node and its predecessor's. Only the holder reads or writes them.
+        QueueNode* holder = nullptr;
+        QueueNode* holderPred = nullptr;
+
+    public:
+        CLHLock() : tail(new QueueNode()) {}
+
+        ~CLHLock(){
+            delete tail.load();
+        }
+
+        CLHLock(const CLHLock&) = delete;
+        CLHLock& operator=(const CLHLock&) = delete;
+
+        void lock(){
+            QueueNode* node = QueueNodePool::local().take();
+            node->locked.store(true, std::memory_order_relaxed);
+
+            QueueNode* pred = tail.exchange(node, std::memory_order_acq_rel);
+            SpinWait wait;
+            while (pred->locked.load(std::memory_order_acquire)){
+                wait.pause();
+            }
+            holder = node;
+            holderPred = pred;
+        }
+
+        void unlock(){
+            QueueNode* node = holder;
+            QueueNode* pred = holderPred;
+            node->locked.store(false, std::memory_order_release);
+
+            //
+            // Nobody can be spinning on pred any more, it is ours now.
+            QueueNodePool::local().give(pred);
+        }
+};
+
+#endif
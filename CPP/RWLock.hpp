@@ -0,0 +1,99 @@
+#ifndef RW_LOCK_HPP
+#define RW_LOCK_HPP
+
+//
+// Used for the lock word
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+//
+// Used for detecting shared locks
+#include <type_traits>
+#include <utility>
+
+#include "SpinLock.hpp"
+
+/**
+ * Does Lock have a shared mode (lock_shared and unlock_shared), like
+ * std::shared_mutex? Readers take it, anything else falls back to the exclusive lock.
+ */
+template<typename Lock, typename = void> class isSharedLockable : public std::false_type {};
+
+template<typename Lock> class isSharedLockable<Lock, std::void_t<decltype(std::declval<Lock&>().lock_shared()), decltype(std::declval<Lock&>().unlock_shared())>> : public std::true_type {};
+
+/**
+ * Reader-writer lock that prefers writers.
+ *
+ * std::shared_mutex is a pthread rwlock on Linux, which lets new readers in while
+ * a writer waits, so a steady stream of lookups can hold off an add forever. Here
+ * a writer announces itself before waiting, and readers that arrive after that wait
+ * behind it. Writers queue on a std::mutex, so only one of them spins at a time.
+ * Meets SharedLockable, so std::shared_lock works.
+ */
+class WriterPreferringRWLock {
+    private:
+        //
+        // The low bit is set while a writer holds or waits for the lock, the rest
+        // counts readers.
+        static constexpr std::uint32_t WRITER = 1;
+        static constexpr std::uint32_t READER = 2;
+
+        std::atomic<std::uint32_t> state{0};
+
+        //
+        // Writers line up here.
+        std::mutex writers;
+
+    public:
+        void lock(){
+            writers.lock();
+            state.fetch_or(WRITER, std::memory_order_relaxed);
+
+            //
+            // No new readers now, wait for the ones inside to leave.
+            SpinWait wait;
+            while (state.load(std::memory_order_acquire) != WRITER){
+                wait.pause();
+            }
+        }
+
+        bool try_lock(){
+            if (!writers.try_lock()){
+                return false;
+            }
+            std::uint32_t expected = 0;
+            if (state.compare_exchange_strong(expected, WRITER, std::memory_order_acquire)){
+                return true;
+            }
+            writers.unlock();
+            return false;
+        }
+
+        void unlock(){
+            state.fetch_and(~WRITER, std::memory_order_release);
+            writers.unlock();
+        }
+
+        void lock_shared(){
+            SpinWait wait;
+            while (!try_lock_shared()){
+                wait.pause();
+            }
+        }
+
+        bool try_lock_shared(){
+            std::uint32_t current = state.load(std::memory_order_relaxed);
+            while ((current & WRITER) == 0){
+                if (state.compare_exchange_weak(current, current + READER, std::memory_order_acquire, std::memory_order_relaxed)){
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void unlock_shared(){
+            state.fetch_sub(READER, std::memory_order_release);
+        }
+};
+
+#endif
@@ -0,0 +1,21 @@
+#include <iostream>
+
+#include "RcuList.hpp"
+
+int main()
+{
+    RcuList<int>* list = new RcuList<int>;
+    list->add(1);
+    bool a = list->contains(1);
+    std::cout << a << "\n";
+    list->addAll({2, 3, 4});
+    std::cout << list->size() << "\n";
+    bool remove = list->remove(1);
+    std::cout << remove << "\n";
+    a = list->contains(1);
+    std::cout << a << "\n";
+
+    delete list;
+
+    return 0;
+}
@@ -0,0 +1,419 @@
+#ifndef RCU_LIST_HPP
+#define RCU_LIST_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for publishing versions
+#include <atomic>
+//
+// Used for the writers' lock
+#include <mutex>
+//
+// Used to hold a version until it is published
+#include <memory>
+#include <new>
+//
+// Used for the sorted array
+#include <algorithm>
+#include <vector>
+#include "Batch.hpp"
+//
+// Grace periods for replaced versions.
+#include "EpochReclaimer.hpp"
+#include "HazardPointerReclaimer.hpp"
+//
+// Version allocation
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Item order
+#include "Order.hpp"
+
+/**
+ * Generic template for a read-copy-update Linked List.
+ *
+ * The items live in an immutable sorted array, the current version, reached through
+ * one atomic pointer. Readers load it and binary search, no locks and no writes to
+ * shared memory besides their reclamation guard. Writers take a mutex, copy the
+ * array with the change applied, publish the copy and retire the old version, so
+ * every update costs O(n). Meant for sets read far more often than they change;
+ * addAll() and removeAll() fold a whole batch into a single copy.
+ *
+ * Reclaimer provides the grace period before a replaced version is freed,
+ * EpochReclaimer or HazardPointerReclaimer. Allocator creates and destroys the
+ * versions. Order sorts the items, HashOrder or DirectOrder.
+ */
+template<typename T, typename Reclaimer = EpochReclaimer, typename Allocator = HeapAllocator, typename Order = HashOrder<T>> class RcuList {
+    private:
+        /**
+         * One element of a version: the item and Order's key for it.
+         */
+        class Entry{
+            public:
+                //
+                // Order's key for the item
+                size_t key;
+
+                //
+                // Item being stored
+                T item;
+        };
+
+        /**
+         * Inner nested version class. Never changed once published.
+         */
+        class Version{
+            public:
+                //
+                // The items, in (key, item) order.
+                std::vector<Entry> entries;
+        };
+
+        /**
+         * Frees a version that never got published.
+         */
+        class VersionDeleter{
+            public:
+                void operator()(Version* version) const {
+                    Allocator::destroy(version);
+                }
+        };
+
+        using VersionPtr = std::unique_ptr<Version, VersionDeleter>;
+
+        using Guard = typename Reclaimer::Guard;
+
+        //
+        // The version readers see.
+        std::atomic<Version*> current;
+
+        //
+        // Writers take turns, each one copies the version the last one published.
+        std::mutex writers;
+
+        //
+        // Frees replaced versions once no reader can be looking at them.
+        Reclaimer reclaimer;
+
+        /**
+         * Deleter handed to the reclaimer.
+         */
+        static void destroyVersion(void* version){
+            Allocator::destroy(static_cast<Version*>(version));
+        }
+
+        /**
+         * Does entry hold item?
+         */
+        static bool holds(const Entry& entry, size_t key, const T& item){
+            return entry.key == key && !Order::less(item, entry.item) && !Order::less(entry.item, item);
+        }
+
+        /**
+         * Binary search a version.
+         * @return index of the first entry not before (key, item)
+         */
+        static std::size_t locate(const Version* version, size_t key, const T& item){
+            auto first = std::partition_point(version->entries.begin(), version->entries.end(), [&](const Entry& entry){
+                return precedes<Order>(entry.key, entry.item, key, item);
+            });
+            return first - version->entries.begin();
+        }
+
+        /**
+         * Load the current version for reading.
+         */
+        const Version* read(Guard& guard){
+            return guard.protect(0, [&]{ return current.load(std::memory_order_acquire); });
+        }
+
+        /**
+         * Make room in guard to retire the version about to be replaced. Writers call
+         * it before they copy, so publish() cannot fail.
+         * @throws std::bad_alloc if there is no memory for the room
+         */
+        static void prepare(Guard& guard){
+            if (!guard.reserve(1)){
+                throw std::bad_alloc();
+            }
+        }
+
+        /**
+         * Make next the current version and retire the old one. Writers only, with a
+         * guard that went through prepare(). Nothing fails once next is published.
+         */
+        void publish(Guard& guard, Version* old, VersionPtr next){
+            current.store(next.release(), std::memory_order_release);
+            guard.retire(old, &destroyVersion);
+        }
+
+    public:
+        /**
+         * The constructor for the RcuList. It publishes an empty version.
+         */
+        RcuList() : current(Allocator::template create<Version>()) {}
+
+        /**
+         * The destructor for the RcuList. It frees the current version, replaced
+         * ones are freed by the reclaimer's destructor.
+         * What happens if this is called while other threads are doing work?
+         */
+        ~RcuList(){
+            Allocator::destroy(current.load(std::memory_order_relaxed));
+        }
+
+        /**
+         * Add an element. Copies the whole array.
+         * @param item element to add
+         * @return true iff element was not there already
+         * @throws std::bad_alloc if there is no memory for the copy, the list is unchanged
+         */
+        bool add(T item) {
+            //
+            // Get the key of the item we are trying to insert.
+            size_t key = Order::key(item);
+            std::lock_guard<std::mutex> writer(writers);
+
+            Version* old = current.load(std::memory_order_relaxed);
+            std::size_t index = locate(old, key, item);
+            if (index < old->entries.size() && holds(old->entries[index], key, item)){
+                return false;
+            }
+
+            //
+            // Copy with the new entry spliced in. Until it is published, next frees
+            // itself if anything throws.
+            Guard guard(reclaimer);
+            prepare(guard);
+            VersionPtr next(Allocator::template create<Version>());
+            next->entries.reserve(old->entries.size() + 1);
+            next->entries.insert(next->entries.end(), old->entries.begin(), old->entries.begin() + index);
+            next->entries.push_back(Entry{key, item});
+            next->entries.insert(next->entries.end(), old->entries.begin() + index, old->entries.end());
+
+            publish(guard, old, std::move(next));
+            return true;
+        }
+
+        /**
+         * Remove an element. Copies the whole array.
+         * @param item element to remove
+         * @return true if element was present
+         * @throws std::bad_alloc if there is no memory for the copy, the list is unchanged
+         */
+        bool remove(T item) {
+            //
+            // Get the key of the item we are trying to remove.
+            size_t key = Order::key(item);
+            std::lock_guard<std::mutex> writer(writers);
+
+            Version* old = current.load(std::memory_order_relaxed);
+            std::size_t index = locate(old, key, item);
+            if (index == old->entries.size() || !holds(old->entries[index], key, item)){
+                return false;
+            }
+
+            //
+            // Copy without the entry.
+            Guard guard(reclaimer);
+            prepare(guard);
+            VersionPtr next(Allocator::template create<Version>());
+            next->entries.reserve(old->entries.size() - 1);
+            next->entries.insert(next->entries.end(), old->entries.begin(), old->entries.begin() + index);
+            next->entries.insert(next->entries.end(), old->entries.begin() + index + 1, old->entries.end());
+
+            publish(guard, old, std::move(next));
+            return true;
+        }
+
+        /**
+         * Test whether element is present. One acquire load and a binary search.
+         * @param item element to test
+         * @return true iff element is present
+         */
+        bool contains(T item) {
+            //
+            // Get the key of the item we are trying to find.
+            size_t key = Order::key(item);
+            Guard guard(reclaimer);
+
+            const Version* version = read(guard);
+            std::size_t index = locate(version, key, item);
+            return index < version->entries.size() && holds(version->entries[index], key, item);
+        }
+
+        /**
+         * Add every element of a batch with a single copy, merged in one pass. The
+         * whole batch is atomic.
+         * @param items elements to add, in any order
+         * @param results if not null, results[i] is what add(items[i]) would have returned
+         * @return how many elements were added
+         * @throws std::bad_alloc if there is no memory for the copy, the list is unchanged
+         */
+        std::size_t addAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            std::size_t added = 0;
+            std::lock_guard<std::mutex> writer(writers);
+
+            //
+            // Everything that can throw comes before the first result is written.
+            Version* old = current.load(std::memory_order_relaxed);
+            Guard guard(reclaimer);
+            prepare(guard);
+            VersionPtr next(Allocator::template create<Version>());
+            next->entries.reserve(old->entries.size() + items.size());
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+
+            std::size_t i = 0;
+            for (const BatchEntry& entry : batch){
+                const T& item = items[entry.index];
+                //
+                // Copy the old entries that come first.
+                while (i < old->entries.size() && precedes<Order>(old->entries[i].key, old->entries[i].item, entry.key, item)){
+                    next->entries.push_back(old->entries[i++]);
+                }
+
+                //
+                // Skip it if it is already there, or earlier in the batch.
+                if (i < old->entries.size() && holds(old->entries[i], entry.key, item)){
+                    continue;
+                }
+                if (!next->entries.empty() && holds(next->entries.back(), entry.key, item)){
+                    continue;
+                }
+
+                next->entries.push_back(Entry{entry.key, item});
+                added++;
+                if (results != nullptr){
+                    (*results)[entry.index] = true;
+                }
+            }
+            next->entries.insert(next->entries.end(), old->entries.begin() + i, old->entries.end());
+
+            if (added == 0){
+                return 0;
+            }
+            publish(guard, old, std::move(next));
+            return added;
+        }
+
+        /**
+         * Remove every element of a batch with a single copy, merged in one pass. The
+         * whole batch is atomic.
+         * @param items elements to remove, in any order
+         * @param results if not null, results[i] is what remove(items[i]) would have returned
+         * @return how many elements were removed
+         * @throws std::bad_alloc if there is no memory for the copy, the list is unchanged
+         */
+        std::size_t removeAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            std::size_t removed = 0;
+            std::lock_guard<std::mutex> writer(writers);
+
+            //
+            // Everything that can throw comes before the first result is written.
+            Version* old = current.load(std::memory_order_relaxed);
+            Guard guard(reclaimer);
+            prepare(guard);
+            VersionPtr next(Allocator::template create<Version>());
+            next->entries.reserve(old->entries.size());
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+
+            std::size_t i = 0;
+            for (const BatchEntry& entry : batch){
+                const T& item = items[entry.index];
+                while (i < old->entries.size() && precedes<Order>(old->entries[i].key, old->entries[i].item, entry.key, item)){
+                    next->entries.push_back(old->entries[i++]);
+                }
+
+                //
+                // Drop the entry. A repeat of it later in the batch finds it gone.
+                if (i < old->entries.size() && holds(old->entries[i], entry.key, item)){
+                    i++;
+                    removed++;
+                    if (results != nullptr){
+                        (*results)[entry.index] = true;
+                    }
+                }
+            }
+            next->entries.insert(next->entries.end(), old->entries.begin() + i, old->entries.end());
+
+            if (removed == 0){
+                return 0;
+            }
+            publish(guard, old, std::move(next));
+            return removed;
+        }
+
+        /**
+         * Test a whole batch against one version. The whole batch is atomic.
+         * @param items elements to test, in any order
+         * @param results if not null, results[i] is what contains(items[i]) would have returned
+         * @return true iff every element is present
+         */
+        bool containsAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            bool all = true;
+            Guard guard(reclaimer);
+
+            const Version* version = read(guard);
+            for (std::size_t i = 0; i < items.size(); i++){
+                size_t key = Order::key(items[i]);
+                std::size_t index = locate(version, key, items[i]);
+                bool found = index < version->entries.size() && holds(version->entries[index], key, items[i]);
+                all = all && found;
+                if (results != nullptr){
+                    (*results)[i] = found;
+                }
+            }
+            return all;
+        }
+
+        /**
+         * Call f on every element of one version, in list order. Never blocks writers.
+         * @param f called with each item
+         */
+        template<typename F> void forEach(F f) {
+            Guard guard(reclaimer);
+            const Version* version = read(guard);
+            for (const Entry& entry : version->entries){
+                f(entry.item);
+            }
+        }
+
+        /**
+         * @return how many elements the current version holds
+         */
+        std::size_t size() {
+            Guard guard(reclaimer);
+            return read(guard)->entries.size();
+        }
+
+        /**
+         * Same as size(), a version never changes, so it is exact already.
+         * @return how many elements the current version holds
+         */
+        std::size_t exactSize() {
+            return size();
+        }
+
+        /**
+         * @return bytes per element, for the benchmark's memory column
+         */
+        static constexpr std::size_t nodeSize(){
+            return sizeof(Entry);
+        }
+};
+
+
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef REFINABLE_HASH_SET_HPP
+#define REFINABLE_HASH_SET_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for locks
+#include <mutex>
+#include <atomic>
+#include <thread>
+//
+// Used for the bucket table
+#include <memory>
+#include <vector>
+//
+// Default buckets
+#include "CoarseList.hpp"
+#include "FineList.hpp"
+
+/**
+ * Generic template for a refinable Hash Set.
+ *
+ * Like StripedHashSet, but the lock array grows with the table, one lock per
+ * bucket. A resize raises a flag that keeps new operations out, waits for the
+ * ones holding a lock to leave, then swaps in a bigger table and lock array.
+ */
+template<typename T, typename Bucket = CoarseList<T>> class RefinableHashSet {
+    private:
+        //
+        // Average items per bucket before the table doubles.
+        static constexpr std::size_t LOAD_FACTOR = 4;
+
+        /**
+         * One lock per bucket.
+         */
+        class LockArray {
+            public:
+                std::size_t size;
+                std::unique_ptr<std::mutex[]> mutexes;
+
+                LockArray(std::size_t size) : size(size), mutexes(new std::mutex[size]) {}
+        };
+
+        //
+        // The buckets. Only touched under a bucket lock, replaced while resizing.
+        std::vector<std::unique_ptr<Bucket>> table;
+
+        //
+        // Number of buckets, readable without a lock.
+        std::atomic<std::size_t> capacity;
+
+        //
+        // The current locks. Read without a lock, so old arrays stay alive until
+        // the set goes, a thread may still be waiting on one.
+        std::atomic<LockArray*> locks;
+        std::vector<std::unique_ptr<LockArray>> lockArrays;
+
+        //
+        // Set while a resize is running, nobody may take a bucket lock.
+        std::atomic<bool> resizing;
+
+        //
+        // Items in the set.
+        std::atomic<std::size_t> count;
+
+        //
+        // The std hashing object, so we don't need to initate it multiple times.
+        std::hash<T> hasher;
+
+        /**
+         * Lock the bucket for key, waiting out any resize.
+         * @return the lock that is now held
+         */
+        std::mutex& acquire(size_t key){
+            while (true){
+                while (resizing.load()){
+                    std::this_thread::yield();
+                }
+
+                LockArray* oldLocks = locks.load();
+                std::mutex& lock = oldLocks->mutexes[key % oldLocks->size];
+                lock.lock();
+
+                //
+                // A resize may have started, or finished, while we waited.
+                if (!resizing.load() && locks.load() == oldLocks){
+                    return lock;
+                }
+                lock.unlock();
+            }
+        }
+
+        /**
+         * Is the table due for a resize?
+         */
+        bool policy(){
+            return count.load(std::memory_order_relaxed) / capacity.load(std::memory_order_relaxed) > LOAD_FACTOR;
+        }
+
+        /**
+         * Double the table and the locks, moving every item to its new bucket.
+         * @param oldCapacity the capacity that looked too small
+         */
+        void resize(std::size_t oldCapacity){
+            bool expected = false;
+            if (!resizing.compare_exchange_strong(expected, true)){
+                return;
+            }
+
+            //
+            // Somebody beat us to it.
+            if (capacity.load() == oldCapacity){
+                //
+                // Wait for everyone holding a lock to leave. Anyone after them sees the flag.
+                LockArray* oldLocks = locks.load();
+                for (std::size_t i = 0; i < oldLocks->size; i++){
+                    oldLocks->mutexes[i].lock();
+                    oldLocks->mutexes[i].unlock();
+                }
+
+                std::size_t newCapacity = oldCapacity * 2;
+                std::vector<std::unique_ptr<Bucket>> newTable;
+                newTable.reserve(newCapacity);
+                for (std::size_t i = 0; i < newCapacity; i++){
+                    newTable.emplace_back(new Bucket());
+                }
+                for (std::unique_ptr<Bucket>& bucket : table){
+                    bucket->forEach([&](const T& item){
+                        newTable[hasher(item) % newCapacity]->add(item);
+                    });
+                }
+                table.swap(newTable);
+
+                lockArrays.emplace_back(new LockArray(newCapacity));
+                locks.store(lockArrays.back().get());
+                capacity.store(newCapacity);
+            }
+
+            resizing.store(false);
+        }
+
+    public:
+        /**
+         * The constructor for the RefinableHashSet.
+         * @param capacity initial number of buckets and locks
+         */
+        RefinableHashSet(std::size_t capacity = 16) : capacity(capacity), resizing(false), count(0){
+            table.reserve(capacity);
+            for (std::size_t i = 0; i < capacity; i++){
+                table.emplace_back(new Bucket());
+            }
+            lockArrays.emplace_back(new LockArray(capacity));
+            locks.store(lockArrays.back().get());
+        }
+
+        /**
+         * Add an element.
+         * @param item element to add
+         * @return true iff element was not there already
+         */
+        bool add(T item) {
+            size_t key = hasher(item);
+            bool added;
+            std::size_t oldCapacity;
+            {
+                std::lock_guard<std::mutex> bucketLock(acquire(key), std::adopt_lock);
+                oldCapacity = table.size();
+                added = table[key % oldCapacity]->add(item);
+            }
+
+            if (added){
+                count.fetch_add(1, std::memory_order_relaxed);
+                if (policy()){
+                    resize(oldCapacity);
+                }
+            }
+            return added;
+        }
+
+        /**
+         * Remove an element.
+         * @param item element to remove
+         * @return true if element was present
+         */
+        bool remove(T item) {
+            size_t key = hasher(item);
+            std::lock_guard<std::mutex> bucketLock(acquire(key), std::adopt_lock);
+            bool removed = table[key % table.size()]->remove(item);
+            if (removed){
+                count.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return removed;
+        }
+
+        /**
+         * Test whether element is present
+         * @param item element to test
+         * @return true iff element is present
+         */
+        bool contains(T item) {
+            size_t key = hasher(item);
+            std::lock_guard<std::mutex> bucketLock(acquire(key), std::adopt_lock);
+            return table[key % table.size()]->contains(item);
+        }
+
+        /**
+         * @return bytes per element, for the benchmark's memory column
+         */
+        static constexpr std::size_t nodeSize(){
+            return Bucket::nodeSize();
+        }
+};
+
+
+
+
+#endif
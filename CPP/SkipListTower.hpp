@@ -0,0 +1,126 @@
+#ifndef SKIP_LIST_TOWER_HPP
+#define SKIP_LIST_TOWER_HPP
+
+//
+// Used for the blocks
+#include <cstddef>
+#include <new>
+#include <utility>
+
+/**
+ * Skip list nodes with their tower of links in the same block, right behind the node,
+ * so a traversal reaches a level's link without another pointer to follow and an add
+ * or a free is one Allocator call.
+ *
+ * Every height is its own block type, so a PoolAllocator keeps a size class per
+ * height and a node costs what its tower needs. Node needs an int topLevel, its
+ * height less one, and a constructor that does not throw; Link must be nothrow
+ * default constructible, and is value initialized.
+ */
+template<typename Node, typename Link, typename Allocator, int MaxHeight> class SkipListTower {
+    private:
+        //
+        // Where the links start, the first Link aligned spot past the node.
+        static constexpr std::size_t OFFSET = (sizeof(Node) + alignof(Link) - 1) / alignof(Link) * alignof(Link);
+
+        //
+        // Alignment a block needs for both.
+        static constexpr std::size_t ALIGNMENT = alignof(Node) > alignof(Link) ? alignof(Node) : alignof(Link);
+
+        /**
+         * Room for a node and a tower of Height links.
+         */
+        template<int Height> class alignas(ALIGNMENT) Block {
+            public:
+                unsigned char bytes[OFFSET + Height * sizeof(Link)];
+        };
+
+        /**
+         * Allocate a block for Height links and build the node and links in it.
+         * @return the node, or null if there is no memory
+         */
+        template<int Height, typename... Args> static Node* make(Args&&... args){
+            Block<Height>* block = Allocator::template tryCreate<Block<Height>>();
+            if (block == nullptr){
+                return nullptr;
+            }
+            for (int level = 0; level < Height; level++){
+                new (block->bytes + OFFSET + level * sizeof(Link)) Link();
+            }
+            return new (block->bytes) Node(std::forward<Args>(args)...);
+        }
+
+        /**
+         * Take apart what make<Height>() built and free the block.
+         */
+        template<int Height> static void unmake(Node* node){
+            Link* tower = links(node);
+            node->~Node();
+            for (int level = 0; level < Height; level++){
+                tower[level].~Link();
+            }
+            Allocator::destroy(reinterpret_cast<Block<Height>*>(node));
+        }
+
+        /**
+         * make<height>(), picked from a table of every height.
+         */
+        template<typename... Args, std::size_t... Heights> static Node* dispatch(int height, std::index_sequence<Heights...>, Args&&... args){
+            using Maker = Node* (*)(Args&&...);
+            static constexpr Maker makers[] = {&make<static_cast<int>(Heights) + 1, Args...>...};
+            return makers[height - 1](std::forward<Args>(args)...);
+        }
+
+        /**
+         * unmake<height>(), picked from a table of every height.
+         */
+        template<std::size_t... Heights> static void dispatchDestroy(Node* node, std::index_sequence<Heights...>){
+            using Unmaker = void (*)(Node*);
+            static constexpr Unmaker unmakers[] = {&unmake<static_cast<int>(Heights) + 1>...};
+            unmakers[node->topLevel](node);
+        }
+
+    public:
+        /**
+         * @return the links of a node made here, level 0 first
+         */
+        static Link* links(Node* node){
+            return std::launder(reinterpret_cast<Link*>(reinterpret_cast<unsigned char*>(node) + OFFSET));
+        }
+
+        /**
+         * Allocate and construct a node with height links, or return null if there is
+         * no memory.
+         */
+        template<typename... Args> static Node* tryCreate(int height, Args&&... args) noexcept {
+            return dispatch(height, std::make_index_sequence<MaxHeight>(), std::forward<Args>(args)...);
+        }
+
+        /**
+         * Allocate and construct a node with height links.
+         * @throws std::bad_alloc if there is no memory for it
+         */
+        template<typename... Args> static Node* create(int height, Args&&... args){
+            Node* node = tryCreate(height, std::forward<Args>(args)...);
+            if (node == nullptr){
+                throw std::bad_alloc();
+            }
+            return node;
+        }
+
+        /**
+         * Destroy a node made by create() or tryCreate() and free its block.
+         */
+        static void destroy(Node* node){
+            dispatchDestroy(node, std::make_index_sequence<MaxHeight>());
+        }
+
+        /**
+         * @return bytes a node with height links takes
+         */
+        static constexpr std::size_t size(int height){
+            return (OFFSET + height * sizeof(Link) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        }
+};
+
+#endif
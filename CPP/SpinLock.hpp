@@ -0,0 +1,168 @@
+#ifndef SPIN_LOCK_HPP
+#define SPIN_LOCK_HPP
+
+//
+// Used for the lock word
+#include <atomic>
+#include <mutex>
+#include <thread>
+//
+// Used for detecting try_lock
+#include <type_traits>
+#include <utility>
+
+/**
+ * Tell the core we are spinning, so a sibling hyperthread gets the pipeline.
+ */
+inline void cpuRelax(){
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/**
+ * A waiting loop's pause: spin for a while, then start yielding, a preempted
+ * holder needs the core more than the waiter does.
+ */
+class SpinWait {
+    private:
+        //
+        // Spins before a waiter starts yielding.
+        static constexpr int SPIN_LIMIT = 64;
+
+        int spins = 0;
+
+    public:
+        void pause(){
+            if (spins < SPIN_LIMIT){
+                spins++;
+                cpuRelax();
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+};
+
+/**
+ * Does Lock have try_lock()? CLHLock does not, a CLH waiter cannot leave the queue.
+ */
+template<typename Lock, typename = void> class isTryLockable : public std::false_type {};
+
+template<typename Lock> class isTryLockable<Lock, std::void_t<decltype(std::declval<Lock&>().try_lock())>> : public std::true_type {};
+
+/**
+ * One byte test-and-test-and-set lock, small enough to live in every node.
+ *
+ * std::mutex is 40 bytes on Linux, more than the rest of a node. Waiters spin on
+ * a plain load, so the line only bounces when the lock is released. After a short
+ * spin they yield instead. Meets Lockable, so std::lock_guard works.
+ */
+class SpinLock {
+    private:
+        std::atomic<bool> locked{false};
+
+    public:
+        void lock(){
+            SpinWait wait;
+            while (locked.exchange(true, std::memory_order_acquire)){
+                while (locked.load(std::memory_order_relaxed)){
+                    wait.pause();
+                }
+            }
+        }
+
+        bool try_lock(){
+            return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock(){
+            locked.store(false, std::memory_order_release);
+        }
+};
+
+/**
+ * SpinLock with exponential backoff. A waiter that loses the race for a released
+ * lock waits twice as long before trying again, so a hot lock is not hammered by
+ * every waiter at once.
+ */
+class BackoffSpinLock {
+    private:
+        //
+        // Pauses after the first lost race, and the most a waiter backs off to.
+        static constexpr int MIN_DELAY = 4;
+        static constexpr int MAX_DELAY = 1024;
+
+        std::atomic<bool> locked{false};
+
+    public:
+        void lock(){
+            SpinWait wait;
+            int delay = MIN_DELAY;
+            while (true){
+                while (locked.load(std::memory_order_relaxed)){
+                    wait.pause();
+                }
+                if (!locked.exchange(true, std::memory_order_acquire)){
+                    return;
+                }
+
+                //
+                // Lost the race, back off. Past the cap, give the core away.
+                if (delay < MAX_DELAY){
+                    for (int i = 0; i < delay; i++){
+                        cpuRelax();
+                    }
+                    delay *= 2;
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        bool try_lock(){
+            return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock(){
+            locked.store(false, std::memory_order_release);
+        }
+};
+
+/**
+ * Spin then park. Tries the lock for a short while, which is all a short critical
+ * section needs, then blocks in the kernel like std::mutex, so a long one (a
+ * CoarseList traversal) does not burn the waiters' cores.
+ */
+class AdaptiveMutex {
+    private:
+        //
+        // try_lock attempts before parking.
+        static constexpr int SPIN_TRIES = 100;
+
+        std::mutex mutex;
+
+    public:
+        void lock(){
+            for (int i = 0; i < SPIN_TRIES; i++){
+                if (mutex.try_lock()){
+                    return;
+                }
+                cpuRelax();
+            }
+            mutex.lock();
+        }
+
+        bool try_lock(){
+            return mutex.try_lock();
+        }
+
+        void unlock(){
+            mutex.unlock();
+        }
+};
+
+#endif
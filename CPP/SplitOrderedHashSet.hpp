@@ -0,0 +1,492 @@
+#ifndef SPLIT_ORDERED_HASH_SET_HPP
+#define SPLIT_ORDERED_HASH_SET_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for compare and swap
+#include <atomic>
+#include <cstdint>
+//
+// Used for the sentinel keys
+#include <limits>
+#include <utility>
+//
+// Next pointer with the logical removal mark.
+#include "AtomicMarkableReference.hpp"
+//
+// Safe memory reclamation for snipped nodes.
+#include "EpochReclaimer.hpp"
+#include "HazardPointerReclaimer.hpp"
+//
+// Node allocation
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Hash and tie break
+#include "Order.hpp"
+
+/**
+ * Generic template for a lock-free Hash Set.
+ *
+ * Split-ordered list of Shalev and Shavit. Every item lives in one LockFreeList
+ * style list, sorted by the bit-reversed hash. Bucket b is a sentinel node inside
+ * that list, and all of its items follow it. Doubling the bucket count never moves
+ * an item: the new bucket's sentinel is spliced into the middle of its parent's
+ * run, lazily, the first time someone uses it.
+ *
+ * Reclaimer decides when snipped nodes are freed, EpochReclaimer or HazardPointerReclaimer.
+ * Allocator creates and destroys the nodes, HeapAllocator or PoolAllocator.
+ * Order supplies the hash, and breaks ties between items whose keys collide.
+ */
+template<typename T, typename Reclaimer = EpochReclaimer, typename Allocator = HeapAllocator, typename Order = HashOrder<T>> class SplitOrderedHashSet {
+    static_assert(sizeof(std::size_t) == 8, "The split order assumes a 64 bit size_t.");
+
+    private:
+        //
+        // Average items per bucket before the bucket count doubles.
+        static constexpr std::size_t LOAD_FACTOR = 2;
+
+        //
+        // Segment s holds 2^s buckets, so 64 segments cover every bucket index.
+        static constexpr int SEGMENTS = 64;
+
+        //
+        // Bucket count stops doubling here.
+        static constexpr std::size_t MAX_BUCKETS = std::size_t(1) << 62;
+
+        /**
+         * Inner nested node class.
+         */
+        class Node{
+            public:
+                //
+                // Item being stored
+                T item;
+
+                //
+                // Split order key. Odd for items, even for bucket sentinels.
+                size_t key;
+
+                //
+                // Next node in the chain, the mark means this node is logically removed.
+                AtomicMarkableReference<Node> next;
+
+                /**
+                 * Regular Node constructor
+                 */
+                Node(T item, size_t key) {
+                    this->item = item;
+                    this->key = key;
+                }
+
+                /**
+                 * Constructor for sentinal nodes
+                 */
+                Node(size_t key){
+                    this->key = key;
+                }
+        };
+
+        /**
+         * Inner nested Window class.
+         */
+        class Window {
+            public:
+                //
+                // The nodes of the window.
+                Node* pred;
+                Node* curr;
+
+                /**
+                 * Window constructor
+                 */
+                Window(Node* pred, Node* curr) {
+                    this->curr = curr;
+                    this->pred = pred;
+                }
+        };
+
+        using Guard = typename Reclaimer::Guard;
+
+        //
+        // The head (bucket 0's sentinel) and tail of the list.
+        Node head;
+        Node tail;
+
+        //
+        // Bucket sentinels, allocated a segment at a time. Null until first used.
+        std::atomic<std::atomic<Node*>*> segments[SEGMENTS];
+
+        //
+        // Buckets in use, always a power of two.
+        std::atomic<std::size_t> bucketCount;
+
+        //
+        // Items in the set, counted before they are linked in and uncounted after they
+        // are marked, so it never drops below the true count and cannot wrap around.
+        std::atomic<std::size_t> count;
+
+        //
+        // Frees snipped nodes once no traversal can be standing on them.
+        Reclaimer reclaimer;
+
+        /**
+         * Does node come before (key, item)? Sentinel keys are even and item keys odd,
+         * so items are only ever compared with items. item is null for a sentinel.
+         * The tail comes after everything.
+         */
+        bool before(const Node* node, size_t key, const T* item) const {
+            return node != &tail && (node->key < key || (item != nullptr && node->key == key && Order::less(node->item, *item)));
+        }
+
+        /**
+         * Does node hold item? Only asked once before() is false.
+         */
+        bool holds(const Node* node, size_t key, const T& item) const {
+            return node != &tail && node->key == key && !Order::less(item, node->item);
+        }
+
+        /**
+         * Deleter handed to the reclaimer.
+         */
+        static void destroyNode(void* node){
+            Allocator::destroy(static_cast<Node*>(node));
+        }
+
+        /**
+         * Reverse the bits of a key.
+         */
+        static size_t reverse(size_t key){
+            key = ((key >> 1) & 0x5555555555555555ULL) | ((key & 0x5555555555555555ULL) << 1);
+            key = ((key >> 2) & 0x3333333333333333ULL) | ((key & 0x3333333333333333ULL) << 2);
+            key = ((key >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((key & 0x0F0F0F0F0F0F0F0FULL) << 4);
+            key = ((key >> 8) & 0x00FF00FF00FF00FFULL) | ((key & 0x00FF00FF00FF00FFULL) << 8);
+            key = ((key >> 16) & 0x0000FFFF0000FFFFULL) | ((key & 0x0000FFFF0000FFFFULL) << 16);
+            return (key >> 32) | (key << 32);
+        }
+
+        /**
+         * Split order key of an item's hash. The hash keeps its low 63 bits, the top bit
+         * is set so the key comes out odd. The one hash that reverses into the tail's key
+         * still sorts before the tail, before() never lets anything pass it.
+         */
+        static size_t regularKey(size_t hash){
+            return reverse(hash | ~(std::numeric_limits<std::size_t>::max() >> 1));
+        }
+
+        /**
+         * Split order key of bucket b's sentinel.
+         */
+        static size_t sentinelKey(size_t bucket){
+            return reverse(bucket);
+        }
+
+        /**
+         * Bucket b's parent: b without its highest set bit.
+         */
+        static size_t parentOf(size_t bucket){
+            size_t parent = bucket;
+            parent |= parent >> 1;
+            parent |= parent >> 2;
+            parent |= parent >> 4;
+            parent |= parent >> 8;
+            parent |= parent >> 16;
+            parent |= parent >> 32;
+            return bucket & (parent >> 1);
+        }
+
+        /**
+         * The slot holding bucket b's sentinel, allocating its segment if needed.
+         */
+        std::atomic<Node*>& slot(size_t bucket){
+            //
+            // Segment s holds buckets [2^s - 1, 2^(s+1) - 1).
+            size_t index = bucket + 1;
+            int segment = 63 - __builtin_clzll(index);
+            size_t offset = index - (size_t(1) << segment);
+
+            std::atomic<Node*>* buckets = segments[segment].load(std::memory_order_acquire);
+            if (buckets == nullptr){
+                size_t size = size_t(1) << segment;
+                std::atomic<Node*>* fresh = new std::atomic<Node*>[size];
+                for (size_t i = 0; i < size; i++){
+                    fresh[i].store(nullptr, std::memory_order_relaxed);
+                }
+                if (segments[segment].compare_exchange_strong(buckets, fresh, std::memory_order_acq_rel)){
+                    buckets = fresh;
+                }
+                else {
+                    delete[] fresh;
+                }
+            }
+            return buckets[offset];
+        }
+
+        /**
+         * Bucket b's sentinel, splicing it in after its parent's if this is its first use.
+         * Sentinels are never removed, so they need no protection.
+         */
+        Node* sentinel(Guard& guard, size_t bucket){
+            std::atomic<Node*>& bucketSlot = slot(bucket);
+            Node* node = bucketSlot.load(std::memory_order_acquire);
+            if (node != nullptr){
+                return node;
+            }
+
+            Node* parent = sentinel(guard, parentOf(bucket));
+            size_t key = sentinelKey(bucket);
+            Node* newNode = nullptr;
+
+            while (true){
+                Window window = find(guard, parent, key, nullptr);
+
+                //
+                // Someone else spliced it in first.
+                if (window.curr->key == key){
+                    if (newNode != nullptr){
+                        Allocator::destroy(newNode);
+                    }
+                    node = window.curr;
+                    break;
+                }
+
+                if (newNode == nullptr){
+                    newNode = Allocator::template create<Node>(key);
+                }
+                newNode->next.set(window.curr, false);
+                if (window.pred->next.compareAndSet(window.curr, newNode, false, false)){
+                    node = newNode;
+                    break;
+                }
+            }
+
+            bucketSlot.store(node, std::memory_order_release);
+            return node;
+        }
+
+        /**
+         * Sentinel of the bucket an item's hash falls in.
+         */
+        Node* bucketOf(Guard& guard, size_t hash){
+            return sentinel(guard, hash & (bucketCount.load(std::memory_order_acquire) - 1));
+        }
+
+        /**
+         * Same as LockFreeList::find, starting at a bucket sentinel instead of head.
+         * @param guard the operation's reclamation guard
+         * @param start a sentinel at or before key
+         * @param key split order key to search for
+         * @param item item to search for, null for a sentinel
+         * @return the window (pred, curr), pred before (key, item) and curr not
+         */
+        Window find(Guard& guard, Node* start, size_t key, const T* item){
+            while (true){
+                //
+                // Rotating hazard slots, a pointer never moves between slots.
+                int predSlot = 0, currSlot = 1, succSlot = 2;
+
+                Node* pred = start;
+                Node* curr = guard.protect(currSlot, [&]{ return pred->next.getReference(); });
+
+                while (true){
+                    bool marked = false;
+                    Node* succ = guard.protect(succSlot, [&]{ return curr->next.get(marked); });
+
+                    //
+                    // If pred no longer points to curr, curr (and succ) may already be retired.
+                    if (Reclaimer::validatesTraversal){
+                        bool predMarked;
+                        if (pred->next.get(predMarked) != curr || predMarked){
+                            break;
+                        }
+                    }
+
+                    if (marked){
+                        //
+                        // Snip out the marked node. If pred changed under us, start over.
+                        if (!pred->next.compareAndSet(curr, succ, false, false)){
+                            break;
+                        }
+                        guard.retire(curr, &destroyNode);
+
+                        std::swap(currSlot, succSlot);
+                        curr = succ;
+                        continue;
+                    }
+
+                    if (!before(curr, key, item)){
+                        return Window(pred, curr);
+                    }
+
+                    int freeSlot = predSlot;
+                    predSlot = currSlot;
+                    currSlot = succSlot;
+                    succSlot = freeSlot;
+
+                    pred = curr;
+                    curr = succ;
+                }
+            }
+        }
+
+    public:
+        /**
+         * The constructor for the SplitOrderedHashSet. It initiates the head, tail and the first two buckets.
+         */
+        SplitOrderedHashSet() : head(sentinelKey(0)), tail(std::numeric_limits<std::size_t>::max()), bucketCount(2), count(0){
+            head.next.set(&tail, false);
+            for (int segment = 0; segment < SEGMENTS; segment++){
+                segments[segment].store(nullptr, std::memory_order_relaxed);
+            }
+            slot(0).store(&head, std::memory_order_relaxed);
+        }
+
+        /**
+         * The destructor for the SplitOrderedHashSet. It clears all dynamically allocated memory.
+         * Snipped nodes are freed by the reclaimer's destructor.
+         * What happens if this is called while other threads are doing work?
+         */
+        ~SplitOrderedHashSet(){
+            //
+            // Items and bucket sentinels alike.
+            Node* curr = head.next.getReference();
+            while (curr != &tail){
+                Node* temp = curr;
+                curr = curr->next.getReference();
+                Allocator::destroy(temp);
+            }
+            for (int segment = 0; segment < SEGMENTS; segment++){
+                delete[] segments[segment].load();
+            }
+        }
+
+        /**
+         * Add an element.
+         * @param item element to add
+         * @return true iff element was not there already
+         */
+        bool add(T item) {
+            //
+            // Get the hash of the item we are trying to insert.
+            size_t hash = Order::key(item);
+            size_t key = regularKey(hash);
+            Guard guard(reclaimer);
+            Node* start = bucketOf(guard, hash);
+            Node* newNode = nullptr;
+            size_t items = 0;
+
+            while (true){
+                Window window = find(guard, start, key, &item);
+                Node* pred = window.pred;
+                Node* curr = window.curr;
+
+                //
+                // If the item already exists in the set, return false.
+                if (holds(curr, key, item)){
+                    if (newNode != nullptr){
+                        Allocator::destroy(newNode);
+                        count.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                    return false;
+                }
+
+                //
+                // Count the node before anyone can see it, a remove() of it may
+                // uncount it as soon as it is linked.
+                if (newNode == nullptr){
+                    newNode = Allocator::template create<Node>(item, key);
+                    items = count.fetch_add(1, std::memory_order_relaxed) + 1;
+                }
+
+                //
+                // Splice in the new node, if pred still points to curr and is not marked.
+                newNode->next.set(curr, false);
+                if (pred->next.compareAndSet(curr, newNode, false, false)){
+                    break;
+                }
+            }
+
+            //
+            // Double the buckets once they get too long on average. Nothing moves,
+            // the new buckets are split off their parents as they are used.
+            size_t buckets = bucketCount.load(std::memory_order_relaxed);
+            if (items / buckets > LOAD_FACTOR && buckets < MAX_BUCKETS){
+                bucketCount.compare_exchange_strong(buckets, buckets * 2, std::memory_order_acq_rel);
+            }
+            return true;
+        }
+
+        /**
+         * Remove an element.
+         * @param item element to remove
+         * @return true if element was present
+         */
+        bool remove(T item) {
+            //
+            // Get the hash of the item we are trying to remove.
+            size_t hash = Order::key(item);
+            size_t key = regularKey(hash);
+            Guard guard(reclaimer);
+            Node* start = bucketOf(guard, hash);
+
+            while (true){
+                Window window = find(guard, start, key, &item);
+                Node* pred = window.pred;
+                Node* curr = window.curr;
+
+                //
+                // If the item does not exist in the set, return false.
+                if (!holds(curr, key, item)){
+                    return false;
+                }
+
+                //
+                // Logically remove the node by marking it. This is the linearization point.
+                Node* succ = curr->next.getReference();
+                if (!curr->next.compareAndSet(succ, succ, false, true)){
+                    continue;
+                }
+                count.fetch_sub(1, std::memory_order_relaxed);
+
+                //
+                // Try to snip it once. If it fails, someone else's find() will do it.
+                if (pred->next.compareAndSet(curr, succ, false, false)){
+                    guard.retire(curr, &destroyNode);
+                }
+                return true;
+            }
+        }
+
+        /**
+         * Test whether element is present.
+         * @param item element to test
+         * @return true iff element is present
+         */
+        bool contains(T item) {
+            //
+            // Get the hash of the item we are trying to find.
+            size_t hash = Order::key(item);
+            size_t key = regularKey(hash);
+            Guard guard(reclaimer);
+
+            //
+            // Try to find the item, starting from its bucket.
+            Window window = find(guard, bucketOf(guard, hash), key, &item);
+            return holds(window.curr, key, item);
+        }
+
+        /**
+         * @return bytes per element, for the benchmark's memory column
+         */
+        static constexpr std::size_t nodeSize(){
+            return sizeof(Node);
+        }
+};
+
+
+
+
+#endif
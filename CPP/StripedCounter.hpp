@@ -0,0 +1,190 @@
+#ifndef STRIPED_COUNTER_HPP
+#define STRIPED_COUNTER_HPP
+
+//
+// Used for the stripes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+//
+// Used for detecting retryStats()
+#include <type_traits>
+#include <utility>
+
+#include "ThreadRegistry.hpp"
+
+/**
+ * Counter that many threads bump and few threads read.
+ *
+ * It starts out as one atomic, so a list nobody fights over (a hash set bucket,
+ * say) pays 16 bytes for it. The first time two threads collide on that atomic
+ * it grows a stripe per thread, each on its own cache line, and from then on
+ * counting never contends. Reading sums the atomic and every stripe and is only
+ * a snapshot while writers are running.
+ */
+class StripedCounter {
+    private:
+        //
+        // Threads beyond this share stripes, which is still correct, just slower.
+        static constexpr std::size_t STRIPES = 64;
+
+        /**
+         * One thread's share of the count, alone on its cache line.
+         */
+        class alignas(CACHE_LINE_SIZE) Stripe {
+            public:
+                std::atomic<std::uint64_t> value{0};
+        };
+
+        //
+        // The count until the first collision, and whatever threads that had not
+        // seen the stripes yet added after it.
+        std::atomic<std::uint64_t> base{0};
+
+        //
+        // STRIPES stripes, null until the first collision.
+        std::atomic<Stripe*> stripes{nullptr};
+
+        /**
+         * @return this thread's stripe index, handed out round robin the first time it counts
+         */
+        static std::size_t index(){
+            static std::atomic<std::size_t> next{0};
+            thread_local std::size_t threadIndex = next.fetch_add(1, std::memory_order_relaxed) % STRIPES;
+            return threadIndex;
+        }
+
+        /**
+         * Make the stripes after a collision. If another thread beat us to it, use
+         * theirs. If there is no memory for them, keep everyone on base.
+         * @return the stripes, null only without memory
+         */
+        Stripe* grow(){
+            Stripe* made = new (std::nothrow) Stripe[STRIPES];
+            if (made == nullptr){
+                return nullptr;
+            }
+            Stripe* expected = nullptr;
+            if (!stripes.compare_exchange_strong(expected, made, std::memory_order_acq_rel, std::memory_order_acquire)){
+                delete[] made;
+                return expected;
+            }
+            return made;
+        }
+
+    public:
+        StripedCounter() = default;
+
+        StripedCounter(const StripedCounter&) = delete;
+        StripedCounter& operator=(const StripedCounter&) = delete;
+
+        ~StripedCounter(){
+            delete[] stripes.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Add to the count. Relaxed unless the caller orders other memory by it.
+         * Never throws, growing the stripes just gives up without memory.
+         */
+        void add(std::uint64_t amount = 1, std::memory_order order = std::memory_order_relaxed) noexcept {
+            Stripe* striped = stripes.load(std::memory_order_acquire);
+            if (striped == nullptr){
+                std::uint64_t seen = base.load(std::memory_order_relaxed);
+                if (base.compare_exchange_strong(seen, seen + amount, order, std::memory_order_relaxed)){
+                    return;
+                }
+                striped = grow();
+                if (striped == nullptr){
+                    base.fetch_add(amount, order);
+                    return;
+                }
+            }
+            striped[index()].value.fetch_add(amount, order);
+        }
+
+        /**
+         * @return the sum of base and every stripe
+         */
+        std::uint64_t sum(std::memory_order order = std::memory_order_relaxed) const {
+            std::uint64_t total = base.load(order);
+            const Stripe* striped = stripes.load(std::memory_order_acquire);
+            if (striped != nullptr){
+                for (std::size_t i = 0; i < STRIPES; i++){
+                    total += striped[i].value.load(order);
+                }
+            }
+            return total;
+        }
+};
+
+/**
+ * Element count of a concurrent set. Successful adds and removes go on separate
+ * striped counters, so counting does not contend once it has been fought over,
+ * and reading is O(threads).
+ */
+class StripedSize {
+    private:
+        StripedCounter adds;
+        StripedCounter removes;
+
+    public:
+        void added(std::uint64_t amount = 1){
+            adds.add(amount);
+        }
+
+        void removed(std::uint64_t amount = 1){
+            removes.add(amount);
+        }
+
+        /**
+         * @return adds minus removes. Only a snapshot while writers are running: a
+         *         remove can be counted before the add it undid, so it never goes below 0.
+         */
+        std::size_t get() const {
+            std::uint64_t out = removes.sum();
+            std::uint64_t in = adds.sum();
+            return in > out ? in - out : 0;
+        }
+};
+
+/**
+ * How hard a list had to work for its updates. The lock-free lists count lost CASes
+ * as retries and never wait for a lock.
+ */
+class RetryStats {
+    public:
+        //
+        // add() and remove() calls.
+        std::uint64_t operations = 0;
+
+        //
+        // Failed validations or lost CASes, each one cost another traversal.
+        std::uint64_t retries = 0;
+
+        //
+        // Retries that had to go all the way back to head, the rest resumed from pred.
+        std::uint64_t restarts = 0;
+
+        //
+        // Node locks that were taken when asked for, and the nanoseconds spent waiting
+        // for them. A Lock without try_lock() has every acquisition timed.
+        std::uint64_t lockWaits = 0;
+        std::uint64_t lockWaitNanos = 0;
+
+        /**
+         * @return retries per add() or remove(), 0 before the first one
+         */
+        double retriesPerOperation() const {
+            return operations == 0 ? 0.0 : static_cast<double>(retries) / operations;
+        }
+};
+
+/**
+ * Does List have retryStats()?
+ */
+template<typename List, typename = void> class hasRetryStats : public std::false_type {};
+
+template<typename List> class hasRetryStats<List, std::void_t<decltype(std::declval<const List&>().retryStats())>> : public std::true_type {};
+
+#endif
@@ -0,0 +1,20 @@
+#include <iostream>
+
+#include "StripedHashSet.hpp"
+
+int main()
+{
+    StripedHashSet<int>* list = new StripedHashSet<int>;
+    list->add(1);
+    bool a = list->contains(1);
+    std::cout << a << "\n";
+    bool remove = list->remove(1);
+    std::cout << remove << "\n";
+    a = list->contains(1);
+    std::cout << a << "\n";
+
+    delete list;
+
+    return 0;
+}
+
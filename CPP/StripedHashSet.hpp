@@ -0,0 +1,168 @@
+#ifndef STRIPED_HASH_SET_HPP
+#define STRIPED_HASH_SET_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for locks
+#include <mutex>
+#include <atomic>
+//
+// Used for the bucket table
+#include <memory>
+#include <vector>
+//
+// Default buckets
+#include "CoarseList.hpp"
+#include "FineList.hpp"
+
+/**
+ * Generic template for a lock striped Hash Set.
+ *
+ * An array of Bucket lists (CoarseList or FineList) behind a fixed array of locks.
+ * Lock i guards every bucket whose index is i modulo the number of locks, so the
+ * table can double without the locks changing. A resize takes every lock.
+ */
+template<typename T, typename Bucket = CoarseList<T>> class StripedHashSet {
+    private:
+        //
+        // Average items per bucket before the table doubles.
+        static constexpr std::size_t LOAD_FACTOR = 4;
+
+        //
+        // The buckets. Only touched under a stripe lock, replaced under all of them.
+        std::vector<std::unique_ptr<Bucket>> table;
+
+        //
+        // Number of buckets, readable without a lock.
+        std::atomic<std::size_t> capacity;
+
+        //
+        // The stripes. Fixed for the life of the set.
+        std::vector<std::mutex> locks;
+
+        //
+        // Items in the set.
+        std::atomic<std::size_t> count;
+
+        //
+        // The std hashing object, so we don't need to initate it multiple times.
+        std::hash<T> hasher;
+
+        /**
+         * Is the table due for a resize?
+         */
+        bool policy(){
+            return count.load(std::memory_order_relaxed) / capacity.load(std::memory_order_relaxed) > LOAD_FACTOR;
+        }
+
+        /**
+         * Double the table, moving every item to its new bucket.
+         * @param oldCapacity the capacity that looked too small
+         */
+        void resize(std::size_t oldCapacity){
+            //
+            // Take every stripe, in order.
+            for (std::mutex& stripe : locks){
+                stripe.lock();
+            }
+
+            //
+            // Somebody beat us to it.
+            if (capacity.load() == oldCapacity){
+                std::size_t newCapacity = oldCapacity * 2;
+                std::vector<std::unique_ptr<Bucket>> newTable;
+                newTable.reserve(newCapacity);
+                for (std::size_t i = 0; i < newCapacity; i++){
+                    newTable.emplace_back(new Bucket());
+                }
+                for (std::unique_ptr<Bucket>& bucket : table){
+                    bucket->forEach([&](const T& item){
+                        newTable[hasher(item) % newCapacity]->add(item);
+                    });
+                }
+                table.swap(newTable);
+                capacity.store(newCapacity);
+            }
+
+            for (std::mutex& stripe : locks){
+                stripe.unlock();
+            }
+        }
+
+    public:
+        /**
+         * The constructor for the StripedHashSet.
+         * @param capacity initial number of buckets, also the number of locks
+         */
+        StripedHashSet(std::size_t capacity = 16) : capacity(capacity), locks(capacity), count(0){
+            table.reserve(capacity);
+            for (std::size_t i = 0; i < capacity; i++){
+                table.emplace_back(new Bucket());
+            }
+        }
+
+        /**
+         * Add an element.
+         * @param item element to add
+         * @return true iff element was not there already
+         */
+        bool add(T item) {
+            size_t key = hasher(item);
+            bool added;
+            std::size_t oldCapacity;
+            {
+                std::lock_guard<std::mutex> stripe(locks[key % locks.size()]);
+                oldCapacity = table.size();
+                added = table[key % oldCapacity]->add(item);
+            }
+
+            if (added){
+                count.fetch_add(1, std::memory_order_relaxed);
+                if (policy()){
+                    resize(oldCapacity);
+                }
+            }
+            return added;
+        }
+
+        /**
+         * Remove an element.
+         * @param item element to remove
+         * @return true if element was present
+         */
+        bool remove(T item) {
+            size_t key = hasher(item);
+            std::lock_guard<std::mutex> stripe(locks[key % locks.size()]);
+            bool removed = table[key % table.size()]->remove(item);
+            if (removed){
+                count.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return removed;
+        }
+
+        /**
+         * Test whether element is present
+         * @param item element to test
+         * @return true iff element is present
+         */
+        bool contains(T item) {
+            size_t key = hasher(item);
+            std::lock_guard<std::mutex> stripe(locks[key % locks.size()]);
+            return table[key % table.size()]->contains(item);
+        }
+
+        /**
+         * @return bytes per element, for the benchmark's memory column
+         */
+        static constexpr std::size_t nodeSize(){
+            return Bucket::nodeSize();
+        }
+};
+
+
+
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef THREAD_REGISTRY_HPP
+#define THREAD_REGISTRY_HPP
+
+//
+// Used for the record list
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+//
+// Used for allocation failure
+#include <new>
+
+//
+// Size of a cache line on every machine we care about. Anything written by one
+// thread and scanned by others gets its own line.
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Lock-free registry of per-thread records, used by the reclamation domains.
+ *
+ * A record is claimed for the length of one operation and handed back afterwards,
+ * so threads can come and go without leaking records. Every thread remembers the
+ * record it used last time, so claiming is normally one uncontended exchange.
+ * Records are only deleted together with the registry.
+ *
+ * Record needs an std::atomic<bool> inUse and a Record* nextRecord.
+ */
+template<typename Record> class ThreadRegistry {
+    private:
+        /**
+         * The record a thread used last, and the registry it came from.
+         */
+        class Hint {
+            public:
+                std::uint64_t owner = 0;
+                Record* record = nullptr;
+        };
+
+        //
+        // All records ever created, newest first. Records are never unlinked.
+        std::atomic<Record*> records{nullptr};
+
+        //
+        // How many records there are, scans use it to size their work.
+        std::atomic<std::size_t> count{0};
+
+        //
+        // Unique id of this registry, so a stale hint never points into another one.
+        const std::uint64_t id;
+
+        /**
+         * @return a process wide unique registry id
+         */
+        static std::uint64_t nextId(){
+            static std::atomic<std::uint64_t> counter{1};
+            return counter.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @return this thread's hint for the given record type
+         */
+        static Hint& hint(){
+            thread_local Hint threadHint;
+            return threadHint;
+        }
+
+        /**
+         * Try to claim a record.
+         * @return true iff the record was free and is now ours
+         */
+        static bool tryClaim(Record* record){
+            return !record->inUse.load(std::memory_order_relaxed) && !record->inUse.exchange(true, std::memory_order_acquire);
+        }
+
+    public:
+        /**
+         * Constructor
+         */
+        ThreadRegistry() : id(nextId()) {}
+
+        ThreadRegistry(const ThreadRegistry&) = delete;
+        ThreadRegistry& operator=(const ThreadRegistry&) = delete;
+
+        /**
+         * Destructor, no thread may be holding a record anymore.
+         */
+        ~ThreadRegistry(){
+            Record* curr = records.load();
+            while (curr != nullptr){
+                Record* temp = curr;
+                curr = curr->nextRecord;
+                delete temp;
+            }
+        }
+
+        /**
+         * Claim a record for the calling thread.
+         * @return a record nobody else is using until release() is called
+         * @throws std::bad_alloc if a new record was needed and there is no memory for it
+         */
+        Record* acquire(){
+            Record* record = tryAcquire();
+            if (record == nullptr){
+                throw std::bad_alloc();
+            }
+            return record;
+        }
+
+        /**
+         * acquire() without throwing.
+         * @return a record nobody else is using until release() is called, or null if
+         *         a new record was needed and there is no memory for it
+         */
+        Record* tryAcquire() noexcept {
+            Hint& last = hint();
+            if (last.owner == id && tryClaim(last.record)){
+                return last.record;
+            }
+
+            //
+            // Reuse a record an exited (or busy elsewhere) thread left behind.
+            for (Record* curr = records.load(std::memory_order_acquire); curr != nullptr; curr = curr->nextRecord){
+                if (tryClaim(curr)){
+                    last.owner = id;
+                    last.record = curr;
+                    return curr;
+                }
+            }
+
+            //
+            // Everything is taken, push a fresh record.
+            Record* record = new (std::nothrow) Record();
+            if (record == nullptr){
+                return nullptr;
+            }
+            record->inUse.store(true, std::memory_order_relaxed);
+            Record* top = records.load(std::memory_order_relaxed);
+            do {
+                record->nextRecord = top;
+            } while (!records.compare_exchange_weak(top, record, std::memory_order_release, std::memory_order_relaxed));
+            count.fetch_add(1, std::memory_order_relaxed);
+
+            last.owner = id;
+            last.record = record;
+            return record;
+        }
+
+        /**
+         * Hand a record back.
+         * @param record record returned by acquire()
+         */
+        void release(Record* record){
+            record->inUse.store(false, std::memory_order_release);
+        }
+
+        /**
+         * @return the first record, follow nextRecord for the rest
+         */
+        Record* first() const {
+            return records.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @return how many records exist
+         */
+        std::size_t size() const {
+            return count.load(std::memory_order_relaxed);
+        }
+};
+
+#endif
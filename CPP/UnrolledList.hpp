@@ -0,0 +1,957 @@
+#ifndef UNROLLED_LIST_HPP
+#define UNROLLED_LIST_HPP
+
+
+//
+// Used for hashing
+#include <functional>
+//
+// Used for locks
+#include <atomic>
+#include <cstdint>
+#include "SpinLock.hpp"
+#include "QueueLock.hpp"
+//
+// Paces retries after a failed validation
+#include "Backoff.hpp"
+//
+// Next pointer with the replaced mark.
+#include "AtomicMarkableReference.hpp"
+//
+// Used for batches
+#include <vector>
+#include "Batch.hpp"
+//
+// Used for snapshots
+#include "UpdateTracker.hpp"
+//
+// Item order
+#include "Order.hpp"
+//
+// Used for the empty key slots
+#include <limits>
+//
+// Safe memory reclamation, traversal is unlocked.
+#include "EpochReclaimer.hpp"
+#include "HazardPointerReclaimer.hpp"
+//
+// Node allocation, and reporting when it fails
+#include <new>
+#include "AddStatus.hpp"
+#include "HeapAllocator.hpp"
+#include "PoolAllocator.hpp"
+//
+// Retry counters and the element count
+#include <chrono>
+#include "StripedCounter.hpp"
+
+/**
+ * Generic template for an unrolled Linked List.
+ *
+ * Every node holds up to Capacity items, sorted, with their keys in an array of their
+ * own. A traversal takes one cache miss per node instead of one per item, and the
+ * search within a node counts the keys below the one it wants over the whole array
+ * with compare-and-add, no branch to mispredict.
+ *
+ * A node never changes once it is linked. An update locks the node and its
+ * predecessor like LazyList does, validates them, and links in a copy with the
+ * change: split in two halves if the node was full, merged with its successor if it
+ * falls below a quarter full and they fit in one, unlinked if it is left empty. The
+ * node it replaces is marked first and then retired through the reclaimer. So
+ * contains() takes no lock and writes nothing shared; it only goes around again if it
+ * catches a node in the middle of being replaced.
+ *
+ * Capacity is the number of items per node, 8 to 32 is the useful range.
+ * Reclaimer decides when replaced nodes are freed, EpochReclaimer or HazardPointerReclaimer.
+ * Allocator creates and destroys the nodes, HeapAllocator or PoolAllocator.
+ * Order sorts the items, HashOrder or DirectOrder.
+ * Lock is the node lock: SpinLock, BackoffSpinLock, MCSLock, CLHLock or std::mutex.
+ * Backoff paces the retries after a failed validation: ExponentialBackoff,
+ * RandomizedBackoff, YieldBackoff<N> or NoBackoff.
+ */
+template<typename T, std::size_t Capacity = 16, typename Reclaimer = EpochReclaimer, typename Allocator = HeapAllocator, typename Order = HashOrder<T>, typename Lock = SpinLock, typename Backoff = ExponentialBackoff> class UnrolledList {
+    static_assert(Capacity >= 4, "An unrolled node needs room for at least four items.");
+
+    private:
+        //
+        // A node left with fewer items than this is merged with its successor, if
+        // the two fit in one node.
+        static constexpr std::size_t MIN_FILL = Capacity / 4;
+
+        /**
+         * Inner nested node class. The keys come first and together, so the search
+         * within a node reads a few whole cache lines. The slots past count hold the
+         * largest key, which no key is below.
+         */
+        class Node{
+            public:
+                //
+                // Order's keys for the items, in order
+                size_t keys[Capacity];
+
+                //
+                // Next node in the chain, written under the lock and read without it.
+                // The mark means this node has been replaced or unlinked.
+                AtomicMarkableReference<Node> next;
+
+                //
+                // How many items the node holds, 0 only for the sentinels.
+                std::uint32_t count = 0;
+
+                //
+                // Lock for a node.
+                Lock mutex;
+
+                //
+                // Items being stored, in the same order as their keys
+                T items[Capacity];
+
+                /**
+                 * Constructor for an empty node, filled in before it is linked
+                 */
+                Node(){
+                    for (size_t& key : keys){
+                        key = std::numeric_limits<size_t>::max();
+                    }
+                }
+
+                /**
+                 * Lock the node
+                 */
+                void lock(){
+                    mutex.lock();
+                }
+
+                /**
+                 * Lock the node if nobody holds it. Only for a Lock with try_lock().
+                 */
+                bool tryLock(){
+                    return mutex.try_lock();
+                }
+
+                /**
+                 * Unlock the node
+                 */
+                void unlock(){
+                    mutex.unlock();
+                }
+
+                /**
+                 * Has this node been replaced?
+                 */
+                bool isMarked() const {
+                    return next.isMarked();
+                }
+
+                /**
+                 * Put an item after the ones already there. Only before the node is linked.
+                 */
+                void append(size_t key, const T& item){
+                    keys[count] = key;
+                    items[count] = item;
+                    count++;
+                }
+        };
+
+        /**
+         * Inner nested Window class.
+         */
+        class Window {
+            public:
+                //
+                // The nodes of the window.
+                Node* pred;
+                Node* curr;
+
+                //
+                // The hazard slot holding pred.
+                int predSlot;
+
+                /**
+                 * Window constructor
+                 */
+                Window(Node* pred, Node* curr, int predSlot) {
+                    this->curr = curr;
+                    this->pred = pred;
+                    this->predSlot = predSlot;
+                }
+        };
+
+        using Guard = typename Reclaimer::Guard;
+
+        //
+        // The head and tail of the singly linked list implementation of UnrolledList.
+        // Neither holds items.
+        Node head;
+        Node tail;
+
+        //
+        // Frees replaced nodes once no traversal can be standing on them.
+        Reclaimer reclaimer;
+
+        //
+        // Updates, failed validations, and how many of those went back to head.
+        StripedCounter operations;
+        StripedCounter retries;
+        StripedCounter restarts;
+
+        //
+        // Node locks that were taken when asked for, and the time spent waiting for them.
+        StripedCounter lockWaits;
+        StripedCounter lockWaitNanos;
+
+        //
+        // Brackets every replacement, so snapshots can tell whether they raced one.
+        UpdateTracker updates;
+
+        //
+        // Successful adds and removes, counted inside the brackets.
+        StripedSize count;
+
+        /**
+         * Deleter handed to the reclaimer.
+         */
+        static void destroyNode(void* node){
+            Allocator::destroy(static_cast<Node*>(node));
+        }
+
+        /**
+         * Does node's first item come after (key, item)? Then (key, item) belongs in an
+         * earlier node. The tail comes after everything.
+         */
+        bool after(const Node* node, size_t key, const T& item) const {
+            return node == &tail || precedes<Order>(key, item, node->keys[0], node->items[0]);
+        }
+
+        /**
+         * Index of the first item in node not before (key, item). Counts the keys below
+         * key over every slot, then steps over equal keys whose items come first, which
+         * only a hash collision leaves.
+         */
+        static std::size_t locate(const Node* node, size_t key, const T& item){
+            std::size_t index = 0;
+            for (std::size_t i = 0; i < Capacity; i++){
+                index += node->keys[i] < key ? 1 : 0;
+            }
+            while (index < node->count && node->keys[index] == key && Order::less(node->items[index], item)){
+                index++;
+            }
+            return index;
+        }
+
+        /**
+         * Does node hold item at index? Only asked of the index locate() returned.
+         */
+        static bool holdsAt(const Node* node, std::size_t index, size_t key, const T& item){
+            return index < node->count && node->keys[index] == key && !Order::less(item, node->items[index]);
+        }
+
+        /**
+         * Lock a node, counting and timing the wait if somebody holds it. The clock
+         * is only read once try_lock() has failed, an uncontended lock costs nothing.
+         */
+        void lockNode(Node* node){
+            if constexpr (isTryLockable<Lock>::value){
+                if (node->tryLock()){
+                    return;
+                }
+            }
+            auto begin = std::chrono::steady_clock::now();
+            node->lock();
+            lockWaits.add();
+            lockWaitNanos.add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()));
+        }
+
+        /**
+         * Find the node (key, item) belongs in without locking: the last one whose first
+         * item does not come after it, the first node if they all do, or the tail if
+         * the list is empty. pred and curr are protected in the guard.
+         * @param guard the operation's reclamation guard
+         * @param key key to search for
+         * @param item item to search for
+         * @param start where to start, head or a node (key, item) comes after
+         * @param startSlot the hazard slot start is protected in
+         * @param traversed has the number of nodes stepped over added to it
+         * @return the window (pred, curr)
+         */
+        Window find(Guard& guard, size_t key, const T& item, Node* start, int startSlot, std::size_t& traversed){
+            while (true){
+                //
+                // Rotating hazard slots, a pointer never moves between slots.
+                int predSlot = startSlot, currSlot = (startSlot + 1) % 3, nextSlot = (startSlot + 2) % 3;
+
+                Node* pred = start;
+                Node* curr = guard.protect(currSlot, [&]{ return pred->next.getReference(); });
+
+                //
+                // A marked start may already be unlinked, and one whose successor now
+                // starts past (key, item) may be where it belongs. Go back to head.
+                bool restart = pred->isMarked() || (pred != &head && after(curr, key, item));
+                while (!restart && curr != &tail){
+                    bool marked = false;
+                    Node* next = guard.protect(nextSlot, [&]{ return curr->next.get(marked); });
+
+                    //
+                    // A marked node may already be unlinked, so next may already be retired.
+                    if (Reclaimer::validatesTraversal && marked){
+                        restart = true;
+                        break;
+                    }
+                    if (after(next, key, item)){
+                        break;
+                    }
+
+                    int freeSlot = predSlot;
+                    predSlot = currSlot;
+                    currSlot = nextSlot;
+                    nextSlot = freeSlot;
+
+                    pred = curr;
+                    curr = next;
+                    traversed++;
+                }
+
+                if (!restart){
+                    return Window(pred, curr, predSlot);
+                }
+                restarts.add();
+                start = &head;
+                startSlot = 0;
+            }
+        }
+
+        /**
+         * Check, with prev and curr locked, that curr is still prev's successor and
+         * still the node (key, item) belongs in. An unmarked prev is in the list; curr
+         * never changes once linked, only its successor can, and that needs curr's lock.
+         */
+        bool validate(Node* prev, Node* curr, size_t key, const T& item){
+            return !prev->isMarked() && prev->next.getReference() == curr && !curr->isMarked()
+                && (curr == &tail || after(curr->next.getReference(), key, item));
+        }
+
+        /**
+         * Copy curr with (key, item) put in at index: one node, or two halves linked
+         * together if curr is full.
+         * @param last set to the copy's last node, whose next is left to the caller
+         * @return the copy's first node, or null if there is no memory
+         */
+        static Node* copyAdding(const Node* curr, std::size_t index, size_t key, const T& item, Node*& last){
+            std::size_t total = curr->count + 1;
+            Node* first = Allocator::template tryCreate<Node>();
+            if (first == nullptr){
+                return nullptr;
+            }
+            last = first;
+            std::size_t split = total;
+            if (total > Capacity){
+                last = Allocator::template tryCreate<Node>();
+                if (last == nullptr){
+                    Allocator::destroy(first);
+                    return nullptr;
+                }
+                split = total / 2;
+                first->next.set(last, false);
+            }
+
+            Node* into = first;
+            for (std::size_t i = 0; i < total; i++){
+                if (i == split){
+                    into = last;
+                }
+                if (i < index){
+                    into->append(curr->keys[i], curr->items[i]);
+                }
+                else if (i == index){
+                    into->append(key, item);
+                }
+                else {
+                    into->append(curr->keys[i - 1], curr->items[i - 1]);
+                }
+            }
+            return first;
+        }
+
+        /**
+         * Copy curr without the item at index, followed by every item of then, if
+         * not null.
+         * @return the copy, whose next is left to the caller, or null if there is no memory
+         */
+        static Node* copyRemoving(const Node* curr, std::size_t index, const Node* then){
+            Node* copy = Allocator::template tryCreate<Node>();
+            if (copy == nullptr){
+                return nullptr;
+            }
+            for (std::size_t i = 0; i < curr->count; i++){
+                if (i != index){
+                    copy->append(curr->keys[i], curr->items[i]);
+                }
+            }
+            if (then != nullptr){
+                for (std::size_t i = 0; i < then->count; i++){
+                    copy->append(then->keys[i], then->items[i]);
+                }
+            }
+            return copy;
+        }
+
+        /**
+         * Put replacement in place of prev's successor, all locked: mark the nodes it
+         * replaces first, so a reader that finds one unmarked knows it is still current,
+         * then point prev past them.
+         * @param prev predecessor node
+         * @param curr first node replaced
+         * @param last last node replaced, curr or its successor
+         * @param replacement what comes instead, or last's successor to just unlink
+         */
+        void replace(Node* prev, Node* curr, Node* last, Node* replacement){
+            Node* next = last->next.getReference();
+            curr->next.set(curr->next.getReference(), true);
+            if (last != curr){
+                last->next.set(next, true);
+            }
+            prev->next.set(replacement, false);
+        }
+
+        /**
+         * The window an update locked, pred and curr. Both are unlocked when it goes
+         * out of scope, however the attempt ends.
+         */
+        class LockedWindow {
+            private:
+                Node* prev;
+                Node* curr;
+
+            public:
+                LockedWindow(UnrolledList& list, Node* prev, Node* curr) : prev(prev), curr(curr) {
+                    list.lockNode(prev);
+                    list.lockNode(curr);
+                }
+
+                ~LockedWindow(){
+                    prev->unlock();
+                    curr->unlock();
+                }
+
+                LockedWindow(const LockedWindow&) = delete;
+                LockedWindow& operator=(const LockedWindow&) = delete;
+        };
+
+        /**
+         * Add an element, searching from start. Shared by tryAdd() and addAll().
+         * @param guard the operation's reclamation guard
+         * @param item element to add
+         * @param key its key
+         * @param start where to search from, left at the window's pred for the next search
+         * @param startSlot the hazard slot start is protected in, moves with it
+         * @return ADDED, PRESENT if it was there already, or OUT_OF_MEMORY
+         */
+        AddStatus insert(Guard& guard, T item, size_t key, Node*& start, int& startSlot) noexcept {
+            operations.add();
+            Backoff backoff;
+
+            //
+            // Until validation is true (optimistically, this loop will only execute once)
+            while (true){
+                std::size_t traversed = 0;
+                Window window = find(guard, key, item, start, startSlot, traversed);
+                Node* prev = window.pred;
+                Node* curr = window.curr;
+
+                //
+                // The next search, whether a retry or the next key of a batch, starts here.
+                start = prev;
+                startSlot = window.predSlot;
+
+                {
+                    LockedWindow locked(*this, prev, curr);
+                    if (validate(prev, curr, key, item)){
+                        //
+                        // An empty list gets its first node.
+                        if (curr == &tail){
+                            Node* newNode = Allocator::template tryCreate<Node>();
+                            if (newNode == nullptr){
+                                return AddStatus::OUT_OF_MEMORY;
+                            }
+                            newNode->append(key, item);
+                            newNode->next.set(&tail, false);
+
+                            updates.begin();
+                            prev->next.set(newNode, false);
+                            count.added();
+                            updates.end();
+                            return AddStatus::ADDED;
+                        }
+
+                        //
+                        // If the item already exists in the list, there is nothing to do.
+                        std::size_t index = locate(curr, key, item);
+                        if (holdsAt(curr, index, key, item)){
+                            return AddStatus::PRESENT;
+                        }
+
+                        //
+                        // Replace the node with a copy holding the item, two if it was full.
+                        // Room to retire the old node is made first, nothing can fail after
+                        // the change.
+                        if (!guard.reserve(1)){
+                            return AddStatus::OUT_OF_MEMORY;
+                        }
+                        Node* last = nullptr;
+                        Node* first = copyAdding(curr, index, key, item, last);
+                        if (first == nullptr){
+                            return AddStatus::OUT_OF_MEMORY;
+                        }
+                        last->next.set(curr->next.getReference(), false);
+
+                        updates.begin();
+                        replace(prev, curr, curr, first);
+                        count.added();
+                        updates.end();
+                    }
+                    else {
+                        curr = nullptr;
+                    }
+                }
+
+                if (curr == nullptr){
+                    //
+                    // If validation did not work, we look again from prev. find() goes
+                    // back to head if prev was replaced or no longer comes before us.
+                    retries.add();
+                    backoff.pause();
+                    continue;
+                }
+
+                //
+                // The locks are gone, retire the replaced node.
+                guard.retire(curr, &destroyNode);
+                return AddStatus::ADDED;
+            }
+        }
+
+        /**
+         * Remove an element, searching from start. Shared by remove() and removeAll().
+         * @param guard the operation's reclamation guard
+         * @param item element to remove
+         * @param key its key
+         * @param start where to search from, left at the window's pred for the next search
+         * @param startSlot the hazard slot start is protected in, moves with it
+         * @return true if element was present
+         * @throws std::bad_alloc if there is no memory for the node's copy or to retire it, the list is unchanged
+         */
+        bool erase(Guard& guard, const T& item, size_t key, Node*& start, int& startSlot){
+            operations.add();
+            Backoff backoff;
+
+            //
+            // Until validation is true (optimistically, this loop will only execute once)
+            while (true){
+                std::size_t traversed = 0;
+                Window window = find(guard, key, item, start, startSlot, traversed);
+                Node* prev = window.pred;
+                Node* curr = window.curr;
+
+                //
+                // The next search, whether a retry or the next key of a batch, starts here.
+                start = prev;
+                startSlot = window.predSlot;
+
+                //
+                // The nodes replaced, retired once the locks are gone.
+                Node* merged = nullptr;
+                bool validated;
+                {
+                    LockedWindow locked(*this, prev, curr);
+                    validated = validate(prev, curr, key, item);
+                    if (validated){
+                        //
+                        // If the item does not exist in the list, return false.
+                        if (curr == &tail){
+                            return false;
+                        }
+                        std::size_t index = locate(curr, key, item);
+                        if (!holdsAt(curr, index, key, item)){
+                            return false;
+                        }
+                        if (!guard.reserve(2)){
+                            throw std::bad_alloc();
+                        }
+
+                        Node* next = curr->next.getReference();
+                        std::size_t left = curr->count - 1;
+                        if (left == 0){
+                            //
+                            // Nothing left in the node, unlink it.
+                            updates.begin();
+                            replace(prev, curr, curr, next);
+                            count.removed();
+                            updates.end();
+                        }
+                        else if (left < MIN_FILL && next != &tail && left + next->count <= Capacity){
+                            //
+                            // Too empty, fold the successor into the copy. Holding curr,
+                            // nobody can have replaced the successor under us.
+                            lockNode(next);
+                            Node* copy = copyRemoving(curr, index, next);
+                            if (copy == nullptr){
+                                next->unlock();
+                                throw std::bad_alloc();
+                            }
+                            copy->next.set(next->next.getReference(), false);
+
+                            updates.begin();
+                            replace(prev, curr, next, copy);
+                            count.removed();
+                            updates.end();
+                            next->unlock();
+                            merged = next;
+                        }
+                        else {
+                            Node* copy = copyRemoving(curr, index, nullptr);
+                            if (copy == nullptr){
+                                throw std::bad_alloc();
+                            }
+                            copy->next.set(next, false);
+
+                            updates.begin();
+                            replace(prev, curr, curr, copy);
+                            count.removed();
+                            updates.end();
+                        }
+                    }
+                }
+
+                if (!validated){
+                    //
+                    // If validation did not work, we look again from prev. find() goes
+                    // back to head if prev was replaced or no longer comes before us.
+                    retries.add();
+                    backoff.pause();
+                    continue;
+                }
+
+                //
+                // The locks are gone, retire the replaced nodes.
+                guard.retire(curr, &destroyNode);
+                if (merged != nullptr){
+                    guard.retire(merged, &destroyNode);
+                }
+                return true;
+            }
+        }
+
+        /**
+         * Test whether element is present, searching from start. Shared by contains()
+         * and containsAll().
+         * @param guard the operation's reclamation guard
+         * @param item element to test
+         * @param key its key
+         * @param start where to search from, left at the window's pred for the next search
+         * @param startSlot the hazard slot start is protected in, moves with it
+         * @return true iff element is present
+         */
+        bool find(Guard& guard, const T& item, size_t key, Node*& start, int& startSlot){
+            Backoff backoff;
+            while (true){
+                std::size_t traversed = 0;
+                Window window = find(guard, key, item, start, startSlot, traversed);
+                start = window.pred;
+                startSlot = window.predSlot;
+                if (window.curr == &tail){
+                    return false;
+                }
+
+                //
+                // The node never changes, so if it is still not replaced after the
+                // search, the answer held at that moment.
+                bool found = holdsAt(window.curr, locate(window.curr, key, item), key, item);
+                if (!window.curr->isMarked()){
+                    return found;
+                }
+                backoff.pause();
+            }
+        }
+
+        /**
+         * Copy out every item in one walk. Only consistent if no update ran during it,
+         * snapshot() checks.
+         */
+        std::vector<T> collect(){
+            std::vector<T> items;
+            Guard guard(reclaimer);
+            Node* curr = guard.protect(0, [&]{ return head.next.getReference(); });
+            int slot = 0;
+            while (curr != &tail){
+                for (std::size_t i = 0; i < curr->count; i++){
+                    items.push_back(curr->items[i]);
+                }
+                bool marked = false;
+                slot = 1 - slot;
+                curr = guard.protect(slot, [&]{ return curr->next.get(marked); });
+
+                //
+                // curr's successor may already be retired, and the walk is useless
+                // anyway. Start over.
+                if (Reclaimer::validatesTraversal && marked){
+                    items.clear();
+                    slot = 0;
+                    curr = guard.protect(slot, [&]{ return head.next.getReference(); });
+                }
+            }
+            return items;
+        }
+
+    public:
+        /**
+         * The constructor for the UnrolledList. It initiates the head and tail.
+         */
+        UnrolledList(){
+            head.next.set(&tail, false);
+        }
+
+        /**
+         * The destructor for the UnrolledList. It clears all dynamically allocated memory.
+         * Replaced nodes are freed by the reclaimer's destructor.
+         * What happens if this is called while other threads are doing work?
+         */
+        ~UnrolledList(){
+            Node* curr = head.next.getReference();
+            while (curr != &tail){
+                Node* temp = curr;
+                curr = curr->next.getReference();
+                Allocator::destroy(temp);
+            }
+        }
+
+        /**
+         * How many times add() and remove() had to retry, and how long they waited
+         * for node locks, since the list was made.
+         * @return the counters, a snapshot if threads are still running
+         */
+        RetryStats retryStats() const {
+            RetryStats stats;
+            stats.operations = operations.sum();
+            stats.retries = retries.sum();
+            stats.restarts = restarts.sum();
+            stats.lockWaits = lockWaits.sum();
+            stats.lockWaitNanos = lockWaitNanos.sum();
+            return stats;
+        }
+
+        /**
+         * Add an element.
+         * @param item element to add
+         * @return true iff element was not there already
+         * @throws std::bad_alloc if there is no memory for the node's copy or to retire it, the list is unchanged
+         */
+        bool add(T item) {
+            AddStatus status = tryAdd(item);
+            if (status == AddStatus::OUT_OF_MEMORY){
+                throw std::bad_alloc();
+            }
+            return status == AddStatus::ADDED;
+        }
+
+        /**
+         * Add an element without throwing. No memory for the node copies, for the
+         * reclaimer's record on a thread's first operation, or for the reclaimer to
+         * retire the replaced node comes back as OUT_OF_MEMORY, the list unchanged.
+         * @param item element to add
+         * @return ADDED, PRESENT if it was there already, or OUT_OF_MEMORY
+         */
+        AddStatus tryAdd(T item) noexcept {
+            //
+            // Get the key of the item we are trying to insert.
+            size_t key = Order::key(item);
+            Guard guard(reclaimer, std::nothrow);
+            if (!guard){
+                return AddStatus::OUT_OF_MEMORY;
+            }
+            Node* start = &head;
+            int startSlot = 0;
+
+            return insert(guard, item, key, start, startSlot);
+        }
+
+        /**
+         * Remove an element.
+         * @param item element to remove
+         * @return true if element was present
+         * @throws std::bad_alloc if there is no memory for the node's copy or to retire it, the list is unchanged
+         */
+        bool remove(T item) {
+            //
+            // Get the key of the item we are trying to remove.
+            size_t key = Order::key(item);
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            return erase(guard, item, key, start, startSlot);
+        }
+
+        /**
+         * Test whether element is present
+         * @param item element to test
+         * @return true iff element is present
+         */
+        bool contains(T item) {
+            //
+            // Get the key of the item we are trying to find.
+            size_t key = Order::key(item);
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            return find(guard, item, key, start, startSlot);
+        }
+
+        /**
+         * Add every element of a batch in one walk: each search starts where the
+         * previous key's window was. Each element is added atomically, the batch as
+         * a whole is not.
+         * @param items elements to add, in any order
+         * @param results if not null, results[i] is what add(items[i]) would have returned
+         * @return how many elements were added
+         * @throws std::bad_alloc if there is no memory for a copy, the elements added
+         *         before it stay in the list
+         */
+        std::size_t addAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            std::size_t added = 0;
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            for (const BatchEntry& entry : batch){
+                AddStatus status = insert(guard, items[entry.index], entry.key, start, startSlot);
+                if (status == AddStatus::OUT_OF_MEMORY){
+                    throw std::bad_alloc();
+                }
+                bool result = status == AddStatus::ADDED;
+                added += result ? 1 : 0;
+                if (results != nullptr){
+                    (*results)[entry.index] = result;
+                }
+            }
+            return added;
+        }
+
+        /**
+         * Remove every element of a batch in one walk: each search starts where the
+         * previous key's window was. Each element is removed atomically, the batch as
+         * a whole is not.
+         * @param items elements to remove, in any order
+         * @param results if not null, results[i] is what remove(items[i]) would have returned
+         * @return how many elements were removed
+         * @throws std::bad_alloc if there is no memory for a copy, the elements removed
+         *         before it stay removed
+         */
+        std::size_t removeAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            std::size_t removed = 0;
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            for (const BatchEntry& entry : batch){
+                bool result = erase(guard, items[entry.index], entry.key, start, startSlot);
+                removed += result ? 1 : 0;
+                if (results != nullptr){
+                    (*results)[entry.index] = result;
+                }
+            }
+            return removed;
+        }
+
+        /**
+         * Test a whole batch in one walk: each search starts where the previous key's
+         * window was. Each element is tested atomically, the batch as a whole is not.
+         * @param items elements to test, in any order
+         * @param results if not null, results[i] is what contains(items[i]) would have returned
+         * @return true iff every element is present
+         */
+        bool containsAll(const std::vector<T>& items, std::vector<bool>* results = nullptr) {
+            std::vector<BatchEntry> batch = sortBatch<Order>(items);
+            if (results != nullptr){
+                results->assign(items.size(), false);
+            }
+            bool all = true;
+            Guard guard(reclaimer);
+            Node* start = &head;
+            int startSlot = 0;
+
+            for (const BatchEntry& entry : batch){
+                bool found = find(guard, items[entry.index], entry.key, start, startSlot);
+                all = all && found;
+                if (results != nullptr){
+                    (*results)[entry.index] = found;
+                }
+            }
+            return all;
+        }
+
+        /**
+         * Call f on every element of one snapshot, in list order.
+         * @param f called with each item
+         */
+        template<typename F> void forEach(F f) {
+            for (const T& item : snapshot()){
+                f(item);
+            }
+        }
+
+        /**
+         * Copy out every element, as of one moment. Lock-free unless updates keep
+         * racing it, then updates wait for one walk.
+         * @return the elements, in list order
+         */
+        std::vector<T> snapshot() {
+            std::vector<T> items;
+            updates.snapshot([&]{
+                items = collect();
+            });
+            return items;
+        }
+
+        /**
+         * Number of elements, O(threads). Exact while no update is running, close
+         * to it while some are.
+         * @return the element count
+         */
+        std::size_t size() const {
+            return count.get();
+        }
+
+        /**
+         * Number of elements as of one moment. O(threads) too, unless updates keep
+         * racing it, then they wait for it.
+         * @return the element count
+         */
+        std::size_t exactSize() {
+            std::size_t elements = 0;
+            updates.snapshot([&]{
+                elements = count.get();
+            });
+            return elements;
+        }
+
+        /**
+         * @return bytes per element in a half full node, for the benchmark's memory
+         *         column. Splits leave nodes half full, adds fill them back up.
+         */
+        static constexpr std::size_t nodeSize(){
+            return sizeof(Node) / (Capacity / 2);
+        }
+};
+
+
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef UPDATE_TRACKER_HPP
+#define UPDATE_TRACKER_HPP
+
+//
+// Used for the counters and the gate
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "SpinLock.hpp"
+#include "StripedCounter.hpp"
+
+/**
+ * Lets a lock-free traversal tell whether the set changed under it, which turns a
+ * plain collect into a linearizable snapshot.
+ *
+ * Every update brackets the write that makes it visible (the insert or the mark)
+ * with begin() and end(), which bump striped started and finished counters. A
+ * snapshot first waits for a moment with nothing in flight, started == finished,
+ * collects, then checks that started has not moved. If it has not, nothing changed
+ * during the collect, so the collect is exactly the set as of then. Logical changes
+ * only, snipping an already marked node does not count.
+ *
+ * Under a steady stream of updates those checks keep failing, so after a few tries a
+ * snapshot closes the gate: new updates wait in begin() until it is done, the ones
+ * in flight finish, and the collect runs alone. Updates block for one traversal at
+ * most, and only then.
+ */
+class UpdateTracker {
+    private:
+        //
+        // Optimistic tries before a snapshot closes the gate.
+        static constexpr int OPTIMISTIC_TRIES = 16;
+
+        //
+        // Updates that got past begin(), and those that got to end().
+        StripedCounter started;
+        StripedCounter finished;
+
+        //
+        // Set while a snapshot holds updates back.
+        std::atomic<bool> closed{false};
+
+        //
+        // Snapshots that close the gate take turns.
+        std::mutex gate;
+
+        /**
+         * Is no update between begin() and end()?
+         * @param begun set to the started count at that moment
+         */
+        bool idle(std::uint64_t& begun){
+            //
+            // finished first: every end() it counts had its begin() counted by
+            // started, so equal sums mean nothing was in flight in between.
+            std::uint64_t done = finished.sum(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            begun = started.sum(std::memory_order_relaxed);
+            return begun == done;
+        }
+
+    public:
+        /**
+         * Called by an update right before the write that makes it visible. Waits
+         * while a snapshot has the gate closed.
+         */
+        void begin(){
+            while (true){
+                started.add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!closed.load(std::memory_order_relaxed)){
+                    return;
+                }
+
+                //
+                // A snapshot is running alone, back out and wait for it.
+                finished.add(1, std::memory_order_release);
+                SpinWait wait;
+                while (closed.load(std::memory_order_acquire)){
+                    wait.pause();
+                }
+            }
+        }
+
+        /**
+         * Called by an update once its write is done, whether or not it succeeded.
+         */
+        void end(){
+            finished.add(1, std::memory_order_release);
+        }
+
+        /**
+         * Run collect until one run saw no update at all.
+         * @param collect fills the caller's result from scratch
+         */
+        template<typename Collect> void snapshot(Collect collect){
+            SpinWait wait;
+            std::uint64_t before;
+            for (int attempt = 0; attempt < OPTIMISTIC_TRIES; attempt++){
+                if (!idle(before)){
+                    wait.pause();
+                    continue;
+                }
+                collect();
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (started.sum(std::memory_order_relaxed) == before){
+                    return;
+                }
+            }
+
+            //
+            // Too busy, hold updates back for one collect.
+            std::lock_guard<std::mutex> turn(gate);
+            closed.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while (!idle(before)){
+                wait.pause();
+            }
+            collect();
+            closed.store(false, std::memory_order_release);
+        }
+};
+
+#endif
@@ -0,0 +1,25 @@
+#include "ListTest.hpp"
+
+#include "../CoarseList.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<CoarseList<int>>(report, "coarse", config);
+    runListTests<CoarseList<int, PoolAllocator<>>>(report, "coarse-pool", config);
+    runListTests<CoarseList<int, HeapAllocator, DirectOrder<int>>>(report, "coarse-direct", config);
+    runListTests<CoarseList<int, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "coarse-colliding", config);
+    runListTests<CoarseList<int, HeapAllocator, HashOrder<int>, SpinLock>>(report, "coarse-spin", config);
+    runListTests<CoarseList<int, HeapAllocator, HashOrder<int>, MCSLock>>(report, "coarse-mcs", config);
+    runListTests<CoarseList<int, HeapAllocator, HashOrder<int>, CLHLock>>(report, "coarse-clh", config);
+    runListTests<CoarseRWList<int>>(report, "coarse-rw", config);
+    runListTests<CoarseList<int, HeapAllocator, HashOrder<int>, WriterPreferringRWLock>>(report, "coarse-rw-writer", config);
+
+    runListTests<CoarseList<int, HeapAllocator, HashOrder<int>, std::mutex, Instrumented>>(report, "coarse-instrumented", config);
+    runListTests<CoarseList<int, HeapAllocator, HashOrder<int>, std::shared_mutex, Instrumented>>(report, "coarse-rw-instrumented", config);
+
+    testOutOfMemory<CoarseList<int, FailingAllocator>>(report, "coarse-out-of-memory", config);
+    return report.exitCode();
+}
@@ -0,0 +1,27 @@
+#include "ListTest.hpp"
+
+#include "../FineList.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<FineList<int>>(report, "fine", config);
+    runListTests<FineList<int, PoolAllocator<>>>(report, "fine-pool", config);
+    runListTests<FineList<int, HeapAllocator, DirectOrder<int>>>(report, "fine-direct", config);
+    runListTests<FineList<int, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "fine-colliding", config);
+    runListTests<FineList<int, HeapAllocator, HashOrder<int>, std::mutex>>(report, "fine-mutex", config);
+    runListTests<FineList<int, HeapAllocator, HashOrder<int>, BackoffSpinLock>>(report, "fine-backoff", config);
+    runListTests<FineList<int, HeapAllocator, HashOrder<int>, MCSLock>>(report, "fine-mcs", config);
+    runListTests<FineList<int, HeapAllocator, HashOrder<int>, CLHLock>>(report, "fine-clh", config);
+
+    runListTests<FineList<int, HeapAllocator, HashOrder<int>, SpinLock, Instrumented>>(report, "fine-instrumented", config);
+
+    testOutOfMemory<FineList<int, FailingAllocator>>(report, "fine-out-of-memory", config);
+
+    testCursors<FineList<int>>(report, "fine-cursors", config);
+    testCursors<FineList<int, PoolAllocator<>, HashOrder<int>, MCSLock>>(report, "fine-cursors-mcs", config);
+    testCursors<FineList<int, HeapAllocator, DirectOrder<int>, SpinLock, Instrumented>>(report, "fine-cursors-instrumented", config);
+    return report.exitCode();
+}
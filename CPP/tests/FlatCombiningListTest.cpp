@@ -0,0 +1,19 @@
+#include "ListTest.hpp"
+
+#include "../FlatCombiningList.hpp"
+#include "../FineList.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<FlatCombiningList<int>>(report, "flat-combining", config);
+    runListTests<FlatCombiningList<int, FineList<int>>>(report, "flat-combining-fine", config);
+    runListTests<FlatCombiningList<int, CoarseList<int, HeapAllocator, HashOrder<int, CollidingHash>>, HashOrder<int, CollidingHash>>>(report, "flat-combining-colliding", config);
+
+
+    testOutOfMemory<FlatCombiningList<int, CoarseList<int, FailingAllocator>>>(report, "flat-combining-out-of-memory", config);
+    testParallelOutOfMemory<FlatCombiningList<int, CoarseList<int, FailingAllocator>>>(report, "flat-combining-parallel-out-of-memory", config);
+    return report.exitCode();
+}
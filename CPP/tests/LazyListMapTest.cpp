@@ -0,0 +1,18 @@
+#include "MapTest.hpp"
+
+#include "../LazyListMap.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runMapTests<LazyListMap<int, long>>(report, "lazy-map", config);
+    runMapTests<LazyListMap<int, long, HazardPointerReclaimer>>(report, "lazy-map-hp", config);
+    runMapTests<LazyListMap<int, long, EpochReclaimer, PoolAllocator<>>>(report, "lazy-map-pool", config);
+    runMapTests<LazyListMap<int, long, EpochReclaimer, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "lazy-map-colliding", config);
+    runMapTests<LazyListMap<int, long, EpochReclaimer, HeapAllocator, HashOrder<int>, std::mutex>>(report, "lazy-map-mutex", config);
+
+    testMapExceptions<LazyListMap<int, long, EpochReclaimer, FailingAllocator>>(report, "lazy-map-exceptions");
+    return report.exitCode();
+}
@@ -0,0 +1,32 @@
+#include "MemoryTest.hpp"
+
+#include "../LazyList.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    //
+    // First, so the pool has no free blocks yet and carves every one it hands out.
+    testMemory<LazyList<int, EpochReclaimer, PoolAllocator<>>>(report, "lazy-pool-memory", LazyList<int>::nodeSize() + 8, 1 << 12);
+
+    runListTests<LazyList<int>>(report, "lazy", config);
+    runListTests<LazyList<int, HazardPointerReclaimer>>(report, "lazy-hp", config);
+    runListTests<LazyList<int, EpochReclaimer, PoolAllocator<>>>(report, "lazy-pool", config);
+    runListTests<LazyList<int, EpochReclaimer, HeapAllocator, DirectOrder<int>>>(report, "lazy-direct", config);
+    runListTests<LazyList<int, EpochReclaimer, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "lazy-colliding", config);
+    runListTests<LazyList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, SpinLock, NoBackoff>>(report, "lazy-nobackoff", config);
+    runListTests<LazyList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, SpinLock, RandomizedBackoff>>(report, "lazy-random", config);
+    runListTests<LazyList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, SpinLock, YieldBackoff<>>>(report, "lazy-yield", config);
+    runListTests<LazyList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, std::mutex>>(report, "lazy-mutex", config);
+    runListTests<LazyList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, MCSLock>>(report, "lazy-mcs", config);
+
+    runListTests<LazyList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, SpinLock, ExponentialBackoff, Instrumented>>(report, "lazy-instrumented", config);
+
+    testOutOfMemory<LazyList<int, EpochReclaimer, FailingAllocator>>(report, "lazy-out-of-memory", config);
+
+    testRangeScan<LazyList<int, EpochReclaimer, HeapAllocator, DirectOrder<int>>>(report, "lazy-range-scan", config);
+    testRangeScan<LazyList<int, HazardPointerReclaimer, HeapAllocator, DirectOrder<int>>>(report, "lazy-hp-range-scan", config);
+    return report.exitCode();
+}
@@ -0,0 +1,16 @@
+#include "ListTest.hpp"
+
+#include "../LazySkipList.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<LazySkipList<int>>(report, "lazy-skiplist", config);
+    runListTests<LazySkipList<int, PoolAllocator<>>>(report, "lazy-skiplist-pool", config);
+    runListTests<LazySkipList<int, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "lazy-skiplist-colliding", config);
+
+    testOutOfMemory<LazySkipList<int, FailingAllocator>>(report, "lazy-skiplist-out-of-memory", config);
+    return report.exitCode();
+}
@@ -0,0 +1,216 @@
+#ifndef LINEARIZABILITY_HPP
+#define LINEARIZABILITY_HPP
+
+//
+// Used for the clock
+#include <atomic>
+#include <cstdint>
+//
+// Used for the histories and the search
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+/**
+ * The set operations a history can hold.
+ */
+enum class SetOperation { ADD, REMOVE, CONTAINS };
+
+/**
+ * One completed operation: what was asked, what came back, and when it was called
+ * and when it returned on the recorder's clock.
+ */
+class HistoryEvent {
+    public:
+        SetOperation operation;
+        int item;
+        bool result;
+        std::uint64_t call;
+        std::uint64_t ret;
+};
+
+/**
+ * Records a concurrent history of set operations.
+ *
+ * Each thread logs to its own vector, so recording adds no contention beyond the
+ * clock, one shared counter bumped before the call and after the return. That makes
+ * the timestamps a total order that respects real time: if one operation returned
+ * before another was called, its ret is smaller than the other's call.
+ */
+class HistoryRecorder {
+    private:
+        std::atomic<std::uint64_t> clock{0};
+
+        //
+        // One log per thread, only written by that thread.
+        std::vector<std::vector<HistoryEvent>> logs;
+
+    public:
+        /**
+         * @param threads how many threads will record
+         */
+        explicit HistoryRecorder(int threads) : logs(threads) {}
+
+        /**
+         * Run f, an add, remove or contains of item, and log it for the given thread.
+         * @return what f returned
+         */
+        template<typename F> bool record(int thread, SetOperation operation, int item, F f){
+            std::uint64_t call = clock.fetch_add(1, std::memory_order_seq_cst);
+            bool result = f();
+            std::uint64_t ret = clock.fetch_add(1, std::memory_order_seq_cst);
+            logs[thread].push_back(HistoryEvent{operation, item, result, call, ret});
+            return result;
+        }
+
+        /**
+         * Every thread's events together. Only once the threads are done.
+         */
+        std::vector<HistoryEvent> history() const {
+            std::vector<HistoryEvent> events;
+            for (const std::vector<HistoryEvent>& log : logs){
+                events.insert(events.end(), log.begin(), log.end());
+            }
+            return events;
+        }
+};
+
+/**
+ * Apply one operation to the sequential specification of a single item: whether it
+ * is in the set.
+ * @return true iff the operation may return its result from state present
+ */
+inline bool applySequential(const HistoryEvent& event, bool& present){
+    switch (event.operation){
+        case SetOperation::ADD: {
+            bool expected = !present;
+            present = true;
+            return event.result == expected;
+        }
+        case SetOperation::REMOVE: {
+            bool expected = present;
+            present = false;
+            return event.result == expected;
+        }
+        default:
+            return event.result == present;
+    }
+}
+
+/**
+ * Wing and Gong's search, with Lowe's cache of visited configurations, over the
+ * history of one item, starting from an empty set.
+ *
+ * The history is a doubly linked list of call and return entries in time order.
+ * The search linearizes the first call it can, lifts the operation out of the list
+ * and starts over from the front; reaching a return means that operation has to be
+ * linearized before anything still in the list, so it backtracks instead. A
+ * configuration, the set of linearized operations and the state, is only tried once.
+ * @return true iff the history is linearizable
+ */
+inline bool isLinearizableItem(const std::vector<HistoryEvent>& events){
+    int n = static_cast<int>(events.size());
+
+    //
+    // Entry 2i is the call of operation i, 2i + 1 its return, 2n the head.
+    std::vector<std::pair<std::uint64_t, int>> order;
+    order.reserve(2 * n);
+    for (int i = 0; i < n; i++){
+        order.emplace_back(events[i].call, 2 * i);
+        order.emplace_back(events[i].ret, 2 * i + 1);
+    }
+    std::sort(order.begin(), order.end());
+
+    const int head = 2 * n;
+    std::vector<int> prev(2 * n + 1, -1);
+    std::vector<int> next(2 * n + 1, -1);
+    int last = head;
+    for (const std::pair<std::uint64_t, int>& entry : order){
+        next[last] = entry.second;
+        prev[entry.second] = last;
+        last = entry.second;
+    }
+
+    auto unlink = [&](int entry){
+        next[prev[entry]] = next[entry];
+        if (next[entry] != -1){
+            prev[next[entry]] = prev[entry];
+        }
+    };
+    auto relink = [&](int entry){
+        next[prev[entry]] = entry;
+        if (next[entry] != -1){
+            prev[next[entry]] = entry;
+        }
+    };
+
+    std::vector<bool> linearized(n, false);
+    std::set<std::pair<std::vector<bool>, bool>> seen;
+    std::vector<std::pair<int, bool>> stack;
+    bool present = false;
+
+    int entry = next[head];
+    while (next[head] != -1){
+        if (entry % 2 == 0){
+            //
+            // A call: linearize it here if the result fits and this is new ground.
+            int op = entry / 2;
+            bool after = present;
+            if (applySequential(events[op], after)){
+                linearized[op] = true;
+                if (seen.emplace(linearized, after).second){
+                    stack.emplace_back(op, present);
+                    present = after;
+                    unlink(2 * op);
+                    unlink(2 * op + 1);
+                    entry = next[head];
+                    continue;
+                }
+                linearized[op] = false;
+            }
+            entry = next[entry];
+        }
+        else {
+            //
+            // A return: its operation should have gone earlier, undo the last choice.
+            if (stack.empty()){
+                return false;
+            }
+            int op = stack.back().first;
+            present = stack.back().second;
+            stack.pop_back();
+            linearized[op] = false;
+            relink(2 * op + 1);
+            relink(2 * op);
+            entry = next[2 * op];
+        }
+    }
+    return true;
+}
+
+/**
+ * Check a whole set history. Operations on different items commute, so the history
+ * is linearizable iff each item's part of it is (P-compositionality), and the items
+ * are searched one at a time.
+ * @param failed if not null, set to the first item whose history is not linearizable
+ * @return true iff the history is linearizable
+ */
+inline bool isLinearizable(const std::vector<HistoryEvent>& history, int* failed = nullptr){
+    std::map<int, std::vector<HistoryEvent>> items;
+    for (const HistoryEvent& event : history){
+        items[event.item].push_back(event);
+    }
+    for (const auto& item : items){
+        if (!isLinearizableItem(item.second)){
+            if (failed != nullptr){
+                *failed = item.first;
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,63 @@
+#include "ListTest.hpp"
+
+/**
+ * Shorthand for a history event.
+ */
+static HistoryEvent event(SetOperation operation, int item, bool result, std::uint64_t call, std::uint64_t ret){
+    return HistoryEvent{operation, item, result, call, ret};
+}
+
+int main()
+{
+    TestReport report;
+    const std::string name = "checker";
+
+    //
+    // Sequential and fine.
+    report.check(isLinearizable({
+        event(SetOperation::ADD, 1, true, 0, 1),
+        event(SetOperation::CONTAINS, 1, true, 2, 3),
+        event(SetOperation::REMOVE, 1, true, 4, 5),
+        event(SetOperation::CONTAINS, 1, false, 6, 7),
+    }), name, "sequential", "rejected a legal history");
+
+    //
+    // A contains that finished before the add started cannot see it.
+    report.check(!isLinearizable({
+        event(SetOperation::CONTAINS, 1, true, 0, 1),
+        event(SetOperation::ADD, 1, true, 2, 3),
+    }), name, "real time", "accepted a read from the future");
+
+    //
+    // Overlapping, so the contains may go after the add.
+    report.check(isLinearizable({
+        event(SetOperation::CONTAINS, 1, true, 0, 3),
+        event(SetOperation::ADD, 1, true, 1, 2),
+    }), name, "overlap", "rejected a legal overlap");
+
+    //
+    // Two adds of one item cannot both succeed without a remove.
+    report.check(!isLinearizable({
+        event(SetOperation::ADD, 1, true, 0, 3),
+        event(SetOperation::ADD, 1, true, 1, 2),
+    }), name, "duplicate add", "accepted two successful adds");
+
+    //
+    // The same, with a remove overlapping both.
+    report.check(isLinearizable({
+        event(SetOperation::ADD, 1, true, 0, 3),
+        event(SetOperation::ADD, 1, true, 1, 4),
+        event(SetOperation::REMOVE, 1, true, 2, 5),
+    }), name, "add remove add", "rejected a legal history");
+
+    //
+    // Items are checked apart, a bad item is found among good ones.
+    int failed = 0;
+    report.check(!isLinearizable({
+        event(SetOperation::ADD, 1, true, 0, 1),
+        event(SetOperation::REMOVE, 2, true, 2, 3),
+        event(SetOperation::ADD, 3, true, 4, 5),
+    }, &failed) && failed == 2, name, "per item", "missed the bad item");
+
+    return report.exitCode();
+}
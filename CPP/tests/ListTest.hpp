@@ -0,0 +1,951 @@
+#ifndef LIST_TEST_HPP
+#define LIST_TEST_HPP
+
+//
+// Used for the worker threads
+#include <atomic>
+#include <thread>
+#include <vector>
+//
+// Used for the random workloads
+#include <algorithm>
+#include <random>
+//
+// Used for reporting
+#include <cstring>
+#include <iostream>
+#include <string>
+//
+// Used for detecting size()
+#include <type_traits>
+#include <utility>
+//
+// Used for the failing allocator
+#include <new>
+
+#include "Linearizability.hpp"
+#include "../StripedCounter.hpp"
+#include "../Instrumentation.hpp"
+#include "../AddStatus.hpp"
+#include "../HeapAllocator.hpp"
+
+/**
+ * Sizes for one test run. The ports keep the Java tests' numbers; the stress test
+ * runs millions of operations over a small key range so every key is fought over.
+ * --quick divides the stress and history sizes by 16, for sanitizer builds.
+ */
+class TestConfig {
+    public:
+        int threads = 8;
+        int testSize = 512;
+
+        int stressOps = 1 << 21;
+        int stressRange = 64;
+
+        int historyRounds = 256;
+        int historyThreads = 4;
+        int historyOps = 64;
+        int historyRange = 4;
+
+        /**
+         * Read the command line of a test program.
+         */
+        static TestConfig fromArgs(int argc, char** argv){
+            TestConfig config;
+            for (int i = 1; i < argc; i++){
+                if (std::strcmp(argv[i], "--quick") == 0){
+                    config.stressOps /= 16;
+                    config.historyRounds /= 16;
+                }
+            }
+            return config;
+        }
+};
+
+/**
+ * Counts failures and prints them as they happen.
+ */
+class TestReport {
+    private:
+        int failures = 0;
+
+    public:
+        /**
+         * Record a failure unless condition holds.
+         */
+        void check(bool condition, const std::string& list, const std::string& test, const std::string& message){
+            if (!condition){
+                failures++;
+                std::cout << "FAIL " << list << " " << test << ": " << message << "\n";
+            }
+        }
+
+        /**
+         * @return the test program's exit code
+         */
+        int exitCode() const {
+            std::cout << (failures == 0 ? "all tests passed" : std::to_string(failures) + " failures") << "\n";
+            return failures == 0 ? 0 : 1;
+        }
+};
+
+/**
+ * Does List have size() and exactSize()? The hash sets and skip lists do not.
+ */
+template<typename List, typename = void> class hasSize : public std::false_type {};
+
+template<typename List> class hasSize<List, std::void_t<decltype(std::declval<List&>().size()), decltype(std::declval<List&>().exactSize())>> : public std::true_type {};
+
+/**
+ * Does List have tryAdd()? The skip lists and hash sets only have add().
+ */
+template<typename List, typename = void> class hasTryAdd : public std::false_type {};
+
+template<typename List> class hasTryAdd<List, std::void_t<decltype(std::declval<List&>().tryAdd(0))>> : public std::true_type {};
+
+/**
+ * Does List have addAll(), removeAll() and containsAll()?
+ */
+template<typename List, typename = void> class hasBatch : public std::false_type {};
+
+template<typename List> class hasBatch<List, std::void_t<decltype(std::declval<List&>().addAll(std::declval<const std::vector<int>&>())), decltype(std::declval<List&>().removeAll(std::declval<const std::vector<int>&>())), decltype(std::declval<List&>().containsAll(std::declval<const std::vector<int>&>()))>> : public std::true_type {};
+
+/**
+ * Does List have forEach()?
+ */
+template<typename List, typename = void> class hasForEach : public std::false_type {};
+
+template<typename List> class hasForEach<List, std::void_t<decltype(std::declval<List&>().forEach(std::declval<void(*)(const int&)>()))>> : public std::true_type {};
+
+/**
+ * Does List have begin() and end()?
+ */
+template<typename List, typename = void> class hasIterators : public std::false_type {};
+
+template<typename List> class hasIterators<List, std::void_t<decltype(std::declval<List&>().begin() != std::declval<List&>().end())>> : public std::true_type {};
+
+/**
+ * Does List have snapshot()?
+ */
+template<typename List, typename = void> class hasSnapshot : public std::false_type {};
+
+template<typename List> class hasSnapshot<List, std::void_t<decltype(std::declval<List&>().snapshot())>> : public std::true_type {};
+
+/**
+ * Hash that sends every item to one of four keys, so lists have to tell apart
+ * distinct items with equal keys.
+ */
+class CollidingHash {
+    public:
+        std::size_t operator()(int item) const {
+            return static_cast<std::size_t>(item) % 4;
+        }
+};
+
+/**
+ * HeapAllocator that runs out of memory: once budget nodes have been made, every
+ * create() throws and every tryCreate() returns null. A negative budget never runs out.
+ */
+class FailingAllocator {
+    public:
+        static inline std::atomic<int> budget{-1};
+
+        template<typename Node, typename... Args> static Node* create(Args&&... args){
+            Node* node = tryCreate<Node>(std::forward<Args>(args)...);
+            if (node == nullptr){
+                throw std::bad_alloc();
+            }
+            return node;
+        }
+
+        template<typename Node, typename... Args> static Node* tryCreate(Args&&... args) noexcept {
+            int left = budget.load();
+            while (left != 0){
+                if (left < 0 || budget.compare_exchange_weak(left, left - 1)){
+                    return HeapAllocator::tryCreate<Node>(std::forward<Args>(args)...);
+                }
+            }
+            return nullptr;
+        }
+
+        template<typename Node> static void destroy(Node* node){
+            HeapAllocator::destroy(node);
+        }
+};
+
+/**
+ * Start threads together: each one calls f(thread) once all of them are running.
+ */
+template<typename F> void runThreads(int threads, F f){
+    std::atomic<int> ready{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++){
+        workers.emplace_back([&, t]{
+            ready.fetch_add(1);
+            while (ready.load() < threads){
+                std::this_thread::yield();
+            }
+            f(t);
+        });
+    }
+    for (std::thread& worker : workers){
+        worker.join();
+    }
+}
+
+/**
+ * Sequential calls.
+ */
+template<typename List> void testSequential(TestReport& report, const std::string& name, const TestConfig& config){
+    List instance;
+    for (int i = 0; i < config.testSize; i++){
+        report.check(instance.add(i), name, "sequential", "bad add: " + std::to_string(i));
+    }
+    for (int i = 0; i < config.testSize; i++){
+        report.check(!instance.add(i), name, "sequential", "duplicate add: " + std::to_string(i));
+        report.check(instance.contains(i), name, "sequential", "bad contains: " + std::to_string(i));
+    }
+    for (int i = 0; i < config.testSize; i++){
+        report.check(instance.remove(i), name, "sequential", "bad remove: " + std::to_string(i));
+        report.check(!instance.contains(i), name, "sequential", "contains after remove: " + std::to_string(i));
+    }
+}
+
+/**
+ * Parallel adds, sequential removes.
+ */
+template<typename List> void testParallelAdd(TestReport& report, const std::string& name, const TestConfig& config){
+    List instance;
+    int perThread = config.testSize / config.threads;
+    std::atomic<int> failedAdds{0};
+    runThreads(config.threads, [&](int t){
+        for (int i = 0; i < perThread; i++){
+            if (!instance.add(t * perThread + i)){
+                failedAdds.fetch_add(1);
+            }
+        }
+    });
+    report.check(failedAdds.load() == 0, name, "parallel add", "failed adds: " + std::to_string(failedAdds.load()));
+    for (int i = 0; i < config.testSize; i++){
+        report.check(instance.contains(i), name, "parallel add", "bad contains: " + std::to_string(i));
+    }
+    for (int i = 0; i < config.testSize; i++){
+        report.check(instance.remove(i), name, "parallel add", "bad remove: " + std::to_string(i));
+    }
+}
+
+/**
+ * Sequential adds, parallel removes.
+ */
+template<typename List> void testParallelRemove(TestReport& report, const std::string& name, const TestConfig& config){
+    List instance;
+    int perThread = config.testSize / config.threads;
+    for (int i = 0; i < config.testSize; i++){
+        instance.add(i);
+    }
+    std::atomic<int> failedRemoves{0};
+    runThreads(config.threads, [&](int t){
+        for (int i = 0; i < perThread; i++){
+            if (!instance.remove(t * perThread + i)){
+                failedRemoves.fetch_add(1);
+            }
+        }
+    });
+    report.check(failedRemoves.load() == 0, name, "parallel remove", "duplicate removes: " + std::to_string(failedRemoves.load()));
+    for (int i = 0; i < config.testSize; i++){
+        report.check(!instance.contains(i), name, "parallel remove", "contains after remove: " + std::to_string(i));
+    }
+}
+
+/**
+ * Parallel adds and removes of the same items. Every add succeeds, and an item is
+ * left in the set exactly when its remove came too early and failed.
+ */
+template<typename List> void testParallelBoth(TestReport& report, const std::string& name, const TestConfig& config){
+    List instance;
+    int perThread = config.testSize / config.threads;
+    std::vector<std::atomic<bool>> removed(config.testSize);
+    std::atomic<int> failedAdds{0};
+    runThreads(2 * config.threads, [&](int t){
+        for (int i = 0; i < perThread; i++){
+            int item = (t % config.threads) * perThread + i;
+            if (t < config.threads){
+                if (!instance.add(item)){
+                    failedAdds.fetch_add(1);
+                }
+            }
+            else {
+                removed[item].store(instance.remove(item));
+            }
+        }
+    });
+    report.check(failedAdds.load() == 0, name, "parallel both", "failed adds: " + std::to_string(failedAdds.load()));
+    for (int i = 0; i < config.testSize; i++){
+        report.check(instance.contains(i) != removed[i].load(), name, "parallel both", "wrong membership: " + std::to_string(i));
+    }
+}
+
+/**
+ * Millions of random operations on a small key range. Every thread keeps a ledger of
+ * the adds and removes that succeeded; per item they have to net out to 0 or 1 and
+ * match what the set holds at the end, and so does the size. Lists with
+ * retryStats() have to have counted every add() and remove(), and instrumented
+ * lists every call, and at least as many allocations as there are items left.
+ */
+template<typename List> void testStress(TestReport& report, const std::string& name, const TestConfig& config){
+    List instance;
+    std::vector<std::atomic<long>> net(config.stressRange);
+    std::atomic<std::uint64_t> updates{0};
+    std::atomic<std::uint64_t> calls[3] = {};
+    int perThread = config.stressOps / config.threads;
+    runThreads(config.threads, [&](int t){
+        std::mt19937 random(t + 1);
+        std::uint64_t called[3] = {};
+        for (int i = 0; i < perThread; i++){
+            int item = random() % config.stressRange;
+            int dice = random() % 4;
+            called[dice < 2 ? dice : 2]++;
+            switch (dice){
+                case 0:
+                    if (instance.add(item)){
+                        net[item].fetch_add(1, std::memory_order_relaxed);
+                    }
+                    break;
+                case 1:
+                    if (instance.remove(item)){
+                        net[item].fetch_sub(1, std::memory_order_relaxed);
+                    }
+                    break;
+                default:
+                    instance.contains(item);
+                    break;
+            }
+        }
+        updates.fetch_add(called[0] + called[1]);
+        for (int op = 0; op < 3; op++){
+            calls[op].fetch_add(called[op]);
+        }
+    });
+
+    std::size_t expected = 0;
+    for (int i = 0; i < config.stressRange; i++){
+        long count = net[i].load();
+        report.check(count == 0 || count == 1, name, "stress", "item " + std::to_string(i) + " added " + std::to_string(count) + " more times than removed");
+        report.check(instance.contains(i) == (count == 1), name, "stress", "wrong membership: " + std::to_string(i));
+        expected += count == 1;
+    }
+    if constexpr (hasSize<List>::value){
+        report.check(instance.size() == expected, name, "stress", "size() " + std::to_string(instance.size()) + " expected " + std::to_string(expected));
+        report.check(instance.exactSize() == expected, name, "stress", "exactSize() " + std::to_string(instance.exactSize()) + " expected " + std::to_string(expected));
+    }
+    if constexpr (hasRetryStats<List>::value){
+        RetryStats stats = instance.retryStats();
+        report.check(stats.operations == updates.load(), name, "stress", "retryStats() counted " + std::to_string(stats.operations) + " updates, expected " + std::to_string(updates.load()));
+    }
+    InstrumentationReport numbers;
+    if constexpr (hasInstrumentation<List>::value){
+        numbers = instance.instrumentation();
+    }
+    if (numbers.enabled){
+        //
+        // The membership checks above were contains() calls too.
+        calls[2].fetch_add(config.stressRange);
+        const char* ops[3] = {"add", "remove", "contains"};
+        for (int op = 0; op < 3; op++){
+            ListOperation operation = static_cast<ListOperation>(op);
+            report.check(numbers.latencyOf(operation).count() == calls[op].load(), name, "stress", std::string(ops[op]) + " latencies " + std::to_string(numbers.latencyOf(operation).count()) + " expected " + std::to_string(calls[op].load()));
+            report.check(numbers.traversedOf(operation).count() == calls[op].load(), name, "stress", std::string(ops[op]) + " traversals " + std::to_string(numbers.traversedOf(operation).count()) + " expected " + std::to_string(calls[op].load()));
+        }
+        report.check(numbers.frees <= numbers.allocations && numbers.allocations - numbers.frees >= expected, name, "stress", std::to_string(numbers.allocations) + " allocations and " + std::to_string(numbers.frees) + " frees for " + std::to_string(expected) + " items");
+    }
+}
+
+/**
+ * Many short rounds of random operations on a handful of items, each recorded and
+ * checked for linearizability.
+ */
+template<typename List> void testLinearizable(TestReport& report, const std::string& name, const TestConfig& config){
+    for (int round = 0; round < config.historyRounds; round++){
+        List instance;
+        HistoryRecorder recorder(config.historyThreads);
+        runThreads(config.historyThreads, [&](int t){
+            std::mt19937 random(round * config.historyThreads + t + 1);
+            for (int i = 0; i < config.historyOps; i++){
+                int item = random() % config.historyRange;
+                switch (random() % 3){
+                    case 0:
+                        recorder.record(t, SetOperation::ADD, item, [&]{ return instance.add(item); });
+                        break;
+                    case 1:
+                        recorder.record(t, SetOperation::REMOVE, item, [&]{ return instance.remove(item); });
+                        break;
+                    default:
+                        recorder.record(t, SetOperation::CONTAINS, item, [&]{ return instance.contains(item); });
+                        break;
+                }
+            }
+        });
+
+        int item = 0;
+        if (!isLinearizable(recorder.history(), &item)){
+            report.check(false, name, "linearizability", "round " + std::to_string(round) + ", item " + std::to_string(item));
+            return;
+        }
+    }
+}
+
+/**
+ * tryAdd() and add() once the allocator is out of memory, for a List over
+ * FailingAllocator: tryAdd() says so, add() throws std::bad_alloc, and the list is
+ * left as it was and keeps working once memory is back. Lists without tryAdd() only
+ * have their add() checked.
+ */
+template<typename List> void testOutOfMemory(TestReport& report, const std::string& name, const TestConfig& config){
+    std::cout << name << "\n";
+    List instance;
+    int items = config.testSize < 64 ? config.testSize : 64;
+    FailingAllocator::budget.store(items);
+    for (int i = 0; i < items; i++){
+        if constexpr (hasTryAdd<List>::value){
+            report.check(instance.tryAdd(i) == AddStatus::ADDED, name, "out of memory", "bad tryAdd: " + std::to_string(i));
+        }
+        else {
+            report.check(instance.add(i), name, "out of memory", "bad add: " + std::to_string(i));
+        }
+    }
+    for (int i = 0; i < items; i++){
+        if constexpr (hasTryAdd<List>::value){
+            report.check(instance.tryAdd(i) == AddStatus::PRESENT, name, "out of memory", "duplicate tryAdd: " + std::to_string(i));
+        }
+        else {
+            report.check(!instance.add(i), name, "out of memory", "duplicate add: " + std::to_string(i));
+        }
+    }
+    if constexpr (hasTryAdd<List>::value){
+        report.check(instance.tryAdd(items) == AddStatus::OUT_OF_MEMORY, name, "out of memory", "tryAdd without memory");
+    }
+    bool threw = false;
+    try {
+        instance.add(items);
+    }
+    catch (const std::bad_alloc&){
+        threw = true;
+    }
+    report.check(threw, name, "out of memory", "add without memory did not throw");
+    report.check(!instance.contains(items), name, "out of memory", "contains an item that was never added");
+    for (int i = 0; i < items; i++){
+        report.check(instance.contains(i), name, "out of memory", "lost item: " + std::to_string(i));
+    }
+    report.check(instance.remove(0), name, "out of memory", "remove without memory");
+    FailingAllocator::budget.store(-1);
+    report.check(instance.add(items), name, "out of memory", "add once memory is back");
+    report.check(instance.contains(items), name, "out of memory", "contains once memory is back");
+}
+
+/**
+ * Threads add their own items to a List over FailingAllocator until it runs out of
+ * memory partway, with one node per item. Every add() has to return, true or by
+ * throwing std::bad_alloc: exactly as many succeed as there was memory for, and the
+ * list holds just those.
+ */
+template<typename List> void testParallelOutOfMemory(TestReport& report, const std::string& name, const TestConfig& config){
+    std::cout << name << "\n";
+    List instance;
+    int perThread = config.testSize;
+    int budget = config.threads * perThread / 2;
+    std::vector<std::vector<char>> added(config.threads, std::vector<char>(perThread));
+    std::atomic<int> successes{0};
+    std::atomic<int> wrong{0};
+    FailingAllocator::budget.store(budget);
+    runThreads(config.threads, [&](int t){
+        for (int i = 0; i < perThread; i++){
+            try {
+                if (instance.add(t * perThread + i)){
+                    added[t][i] = 1;
+                    successes.fetch_add(1);
+                }
+                else {
+                    wrong.fetch_add(1);
+                }
+            }
+            catch (const std::bad_alloc&){
+            }
+        }
+    });
+    FailingAllocator::budget.store(-1);
+    report.check(wrong.load() == 0, name, "parallel out of memory", std::to_string(wrong.load()) + " adds of new items returned false");
+    report.check(successes.load() == budget, name, "parallel out of memory", std::to_string(successes.load()) + " adds succeeded with memory for " + std::to_string(budget));
+    for (int t = 0; t < config.threads; t++){
+        for (int i = 0; i < perThread; i++){
+            report.check(instance.contains(t * perThread + i) == (added[t][i] == 1), name, "parallel out of memory", "wrong membership: " + std::to_string(t * perThread + i));
+        }
+    }
+}
+
+/**
+ * add(), remove() and contains() through a List::Cursor. Every thread ingests its own
+ * ascending range through one cursor while the others do the same, then removes half
+ * of it; cursors whose node is removed under them, and cursors moved to another list,
+ * have to keep working. Instrumented lists fed ascending keys in key order have to
+ * step past at most one node per add, cursor or per-thread finger alike, after the
+ * first add from the head.
+ */
+template<typename List> void testCursors(TestReport& report, const std::string& name, const TestConfig& config){
+    std::cout << name << "\n";
+    {
+        List instance;
+        int perThread = config.testSize / config.threads;
+        std::atomic<int> failures{0};
+        runThreads(config.threads, [&](int t){
+            typename List::Cursor cursor;
+            for (int i = 0; i < perThread; i++){
+                if (!instance.add(t * perThread + i, cursor)){
+                    failures.fetch_add(1);
+                }
+            }
+            cursor.reset();
+            for (int i = 0; i < perThread; i++){
+                if (!instance.contains(t * perThread + i, cursor)){
+                    failures.fetch_add(1);
+                }
+            }
+            cursor.reset();
+            for (int i = 0; i < perThread; i += 2){
+                if (!instance.remove(t * perThread + i, cursor)){
+                    failures.fetch_add(1);
+                }
+            }
+        });
+        report.check(failures.load() == 0, name, "cursors", "failed operations: " + std::to_string(failures.load()));
+        for (int i = 0; i < perThread * config.threads; i++){
+            report.check(instance.contains(i) == (i % perThread % 2 == 1), name, "cursors", "wrong membership: " + std::to_string(i));
+        }
+    }
+    {
+        List first;
+        List second;
+        typename List::Cursor cursor;
+        first.add(1, cursor);
+        first.add(3, cursor);
+        report.check(first.remove(3), name, "cursors", "remove under a cursor");
+        report.check(first.add(2, cursor), name, "cursors", "add after the cursor's node was removed");
+        report.check(!first.contains(3, cursor), name, "cursors", "contains after remove under a cursor");
+        report.check(second.add(3, cursor), name, "cursors", "add with a cursor from another list");
+        report.check(!second.contains(1) && first.contains(1), name, "cursors", "cursor mixed the lists up");
+    }
+    if constexpr (hasInstrumentation<List>::value){
+        List instance;
+        typename List::Cursor cursor;
+        int items = config.testSize < 4096 ? config.testSize : 4096;
+        for (int i = 0; i < items; i++){
+            instance.add(i, cursor);
+        }
+        cursor.reset();
+        for (int i = items; i < 2 * items; i++){
+            instance.add(i);
+        }
+        LatencyHistogram traversed = instance.instrumentation().traversedByAll();
+        report.check(traversed.valueAt(99) <= 1, name, "cursors", "ascending adds stepped past " + std::to_string(traversed.valueAt(99)) + " nodes");
+    }
+}
+
+/**
+ * addAll(), removeAll() and containsAll(), alone and from many threads. A batch may
+ * hold items already in the list, items that are not, and the same item twice: the
+ * count and results[] say what the single operations would have, in batch order, so
+ * only the first of two equal items is added or removed.
+ */
+template<typename List> void testBatch(TestReport& report, const std::string& name, const TestConfig& config){
+    int items = config.testSize;
+    std::mt19937 random(items);
+    {
+        List instance;
+        for (int i = 0; i < items; i += 3){
+            instance.add(i);
+        }
+        std::vector<int> batch;
+        for (int i = 0; i < items; i++){
+            batch.push_back(i);
+        }
+        std::shuffle(batch.begin(), batch.end(), random);
+        for (int i = 0; i < items; i += 5){
+            batch.push_back(i);
+        }
+        std::vector<bool> results;
+        std::size_t added = instance.addAll(batch, &results);
+        std::size_t expected = static_cast<std::size_t>(items - (items + 2) / 3);
+        report.check(added == expected, name, "batch", "addAll() added " + std::to_string(added) + " expected " + std::to_string(expected));
+        report.check(results.size() == batch.size(), name, "batch", "addAll() results size");
+        std::vector<bool> seen(items);
+        for (std::size_t i = 0; i < batch.size() && i < results.size(); i++){
+            int item = batch[i];
+            bool first = !seen[item];
+            seen[item] = true;
+            report.check(results[i] == (first && item % 3 != 0), name, "batch", "addAll() result for " + std::to_string(item) + (first ? "" : ", a duplicate"));
+        }
+        report.check(instance.containsAll(batch), name, "batch", "containsAll() after addAll()");
+
+        std::vector<int> probe = {items + 1, 0, items - 1, items + 2};
+        report.check(!instance.containsAll(probe, &results), name, "batch", "containsAll() with absent items");
+        report.check(results == std::vector<bool>({false, true, true, false}), name, "batch", "containsAll() results");
+        report.check(instance.addAll({}) == 0 && instance.removeAll({}) == 0 && instance.containsAll({}), name, "batch", "empty batch");
+
+        std::vector<int> evens;
+        for (int i = items + 9; i >= items; i--){
+            evens.push_back(i);
+        }
+        for (int i = 0; i < items; i += 2){
+            evens.push_back(i);
+            if (i % 4 == 0){
+                evens.push_back(i);
+            }
+        }
+        std::size_t removed = instance.removeAll(evens, &results);
+        report.check(removed == static_cast<std::size_t>((items + 1) / 2), name, "batch", "removeAll() removed " + std::to_string(removed));
+        std::fill(seen.begin(), seen.end(), false);
+        for (std::size_t i = 0; i < evens.size() && i < results.size(); i++){
+            int item = evens[i];
+            bool first = item < items && !seen[item];
+            if (item < items){
+                seen[item] = true;
+            }
+            report.check(results[i] == first, name, "batch", "removeAll() result for " + std::to_string(item));
+        }
+        for (int i = 0; i < items; i++){
+            report.check(instance.contains(i) == (i % 2 == 1), name, "batch", "wrong membership after removeAll(): " + std::to_string(i));
+        }
+    }
+    {
+        //
+        // Every thread adds the whole range, in its own order. Once all are done,
+        // each removes a share that overlaps the next thread's. Either way every
+        // item has to be added once and removed once.
+        List instance;
+        std::vector<std::atomic<int>> adds(items);
+        std::vector<std::atomic<int>> removes(items);
+        std::atomic<std::size_t> added{0};
+        std::atomic<std::size_t> removed{0};
+        runThreads(config.threads, [&](int t){
+            std::mt19937 shuffler(t + 1);
+            std::vector<int> batch;
+            for (int i = 0; i < items; i++){
+                batch.push_back(i);
+            }
+            std::shuffle(batch.begin(), batch.end(), shuffler);
+            std::vector<bool> results;
+            added.fetch_add(instance.addAll(batch, &results));
+            for (int i = 0; i < items; i++){
+                if (results[i]){
+                    adds[batch[i]].fetch_add(1);
+                }
+            }
+        });
+        runThreads(config.threads, [&](int t){
+            std::vector<int> batch;
+            std::vector<bool> results;
+            for (int i = 0; i < items; i++){
+                if (i % config.threads == t || (i + 1) % config.threads == t){
+                    batch.push_back(i);
+                }
+            }
+            removed.fetch_add(instance.removeAll(batch, &results));
+            for (std::size_t i = 0; i < batch.size(); i++){
+                if (results[i]){
+                    removes[batch[i]].fetch_add(1);
+                }
+            }
+        });
+        report.check(added.load() == static_cast<std::size_t>(items), name, "parallel batch", "addAll() added " + std::to_string(added.load()) + " expected " + std::to_string(items));
+        report.check(removed.load() == static_cast<std::size_t>(items), name, "parallel batch", "removeAll() removed " + std::to_string(removed.load()) + " expected " + std::to_string(items));
+        std::vector<bool> results;
+        std::vector<int> all;
+        for (int i = 0; i < items; i++){
+            report.check(adds[i].load() == 1 && removes[i].load() == 1, name, "parallel batch", "item " + std::to_string(i) + " added " + std::to_string(adds[i].load()) + " and removed " + std::to_string(removes[i].load()) + " times");
+            all.push_back(i);
+        }
+        instance.containsAll(all, &results);
+        report.check(std::find(results.begin(), results.end(), true) == results.end(), name, "parallel batch", "items left after removeAll()");
+    }
+}
+
+/**
+ * Collect a List's items with forEach().
+ */
+template<typename List> std::vector<int> forEachItems(List& instance){
+    std::vector<int> items;
+    instance.forEach([&](const int& item){ items.push_back(item); });
+    return items;
+}
+
+/**
+ * Collect a List's items with its iterators.
+ */
+template<typename List> std::vector<int> iteratedItems(List& instance){
+    std::vector<int> items;
+    for (auto it = instance.begin(); it != instance.end(); ++it){
+        items.push_back(*it);
+    }
+    return items;
+}
+
+/**
+ * Is walk a subsequence of order, each item at most once? Then it came up in list
+ * order, whatever the Order is.
+ */
+inline bool inOrder(const std::vector<int>& walk, const std::vector<int>& order){
+    std::size_t next = 0;
+    for (int item : walk){
+        while (next < order.size() && order[next] != item){
+            next++;
+        }
+        if (next == order.size()){
+            return false;
+        }
+        next++;
+    }
+    return true;
+}
+
+/**
+ * forEach(), the iterators and snapshot(), whichever List has. Alone they must give
+ * every item once, in an order that does not depend on the order of the adds, and
+ * all agree. Under concurrent adds and removes of odd items, every walk must come up
+ * in list order, each item at most once, with every even item, which stays put.
+ */
+template<typename List> void testIteration(TestReport& report, const std::string& name, const TestConfig& config){
+    int items = config.testSize;
+    std::vector<int> order;
+    {
+        List ascending;
+        List shuffled;
+        std::vector<int> all;
+        for (int i = 0; i < items; i++){
+            ascending.add(i);
+            all.push_back(i);
+        }
+        std::shuffle(all.begin(), all.end(), std::mt19937(items));
+        for (int item : all){
+            shuffled.add(item);
+        }
+        order = forEachItems(ascending);
+        std::vector<int> sorted = order;
+        std::sort(sorted.begin(), sorted.end());
+        std::sort(all.begin(), all.end());
+        report.check(sorted == all, name, "iteration", "forEach() did not give every item once");
+        report.check(forEachItems(shuffled) == order, name, "iteration", "order depends on the order of the adds");
+
+        for (int i = 1; i < items; i += 2){
+            ascending.remove(i);
+        }
+        std::vector<int> evens;
+        for (int item : order){
+            if (item % 2 == 0){
+                evens.push_back(item);
+            }
+        }
+        report.check(forEachItems(ascending) == evens, name, "iteration", "forEach() after removes");
+        if constexpr (hasIterators<List>::value){
+            report.check(iteratedItems(ascending) == evens, name, "iteration", "iterators disagree with forEach()");
+            List empty;
+            report.check(!(empty.begin() != empty.end()), name, "iteration", "begin() of an empty list is not end()");
+        }
+        if constexpr (hasSnapshot<List>::value){
+            report.check(ascending.snapshot() == evens, name, "iteration", "snapshot() disagrees with forEach()");
+        }
+    }
+
+    List instance;
+    for (int i = 0; i < items; i += 2){
+        instance.add(i);
+    }
+    std::atomic<int> writers{config.threads / 2};
+    std::atomic<int> bad{0};
+    runThreads(config.threads, [&](int t){
+        if (t < config.threads / 2){
+            std::mt19937 random(t + 1);
+            for (int i = 0; i < config.testSize * 16; i++){
+                int item = (random() % (items / 2)) * 2 + 1;
+                if (random() % 2 == 0){
+                    instance.add(item);
+                }
+                else {
+                    instance.remove(item);
+                }
+            }
+            writers.fetch_sub(1);
+            return;
+        }
+        int walks = 0;
+        while (writers.load() > 0 || walks < 4){
+            std::vector<int> walk;
+            switch (walks++ % 3){
+                case 0:
+                    walk = forEachItems(instance);
+                    break;
+                case 1:
+                    if constexpr (hasIterators<List>::value){
+                        walk = iteratedItems(instance);
+                        break;
+                    }
+                    [[fallthrough]];
+                default:
+                    if constexpr (hasSnapshot<List>::value){
+                        walk = instance.snapshot();
+                    }
+                    else {
+                        walk = forEachItems(instance);
+                    }
+                    break;
+            }
+            int evens = 0;
+            for (int item : walk){
+                evens += item % 2 == 0;
+            }
+            if (!inOrder(walk, order) || evens != (items + 1) / 2){
+                bad.fetch_add(1);
+            }
+        }
+    });
+    report.check(bad.load() == 0, name, "parallel iteration", std::to_string(bad.load()) + " walks out of order, with an item twice, or missing an even item");
+}
+
+/**
+ * How many writers' windows does a scan of [lo, hi) get wrong? Writer w owns items
+ * i * writers + w, and at any one moment holds a run of W or W+1 consecutive i; the
+ * scan sees what of that run falls in [lo, hi). whole says the scan covered every i.
+ */
+inline int badWindows(const std::vector<int>& seen, int writers, int window, int lo, int hi, bool whole){
+    int bad = 0;
+    std::vector<std::vector<int>> runs(writers);
+    for (int item : seen){
+        int i = item / writers;
+        if (i < lo || i >= hi){
+            bad++;
+            continue;
+        }
+        runs[item % writers].push_back(i);
+    }
+    for (std::vector<int>& run : runs){
+        std::sort(run.begin(), run.end());
+        std::size_t size = run.size();
+        bool contiguous = run.empty() || run.back() - run.front() + 1 == static_cast<int>(size);
+        bool sized = whole ? size == static_cast<std::size_t>(window) || size == static_cast<std::size_t>(window) + 1 : size <= static_cast<std::size_t>(window) + 1;
+        bad += !contiguous || !sized;
+    }
+    return bad;
+}
+
+/**
+ * Writers slide a window over their own items: with items 0..W-1 in, they add item
+ * W, remove item 0, add W+1, remove 1 and so on. A collect that is not one moment can
+ * see a window that never was, with a gap or W+2 items. Readers call
+ * scan(instance, random, writers, window, items) over and over while the writers
+ * run; it returns how many windows it saw wrong, see badWindows().
+ */
+template<typename List, typename Scan> void testSlidingWindows(TestReport& report, const std::string& name, const std::string& test, const TestConfig& config, Scan scan){
+    const int window = 8;
+    int writers = config.threads / 2 > 0 ? config.threads / 2 : 1;
+    int readers = config.threads - writers > 0 ? config.threads - writers : 1;
+    int steps = config.testSize * 8;
+    List instance;
+    for (int i = 0; i < window; i++){
+        for (int w = 0; w < writers; w++){
+            instance.add(i * writers + w);
+        }
+    }
+    std::atomic<int> running{writers};
+    std::atomic<int> bad{0};
+    std::atomic<int> scans{0};
+    runThreads(writers + readers, [&](int t){
+        if (t < writers){
+            for (int i = 0; i < steps; i++){
+                instance.add((i + window) * writers + t);
+                instance.remove(i * writers + t);
+            }
+            running.fetch_sub(1);
+            return;
+        }
+        std::mt19937 random(t);
+        while (running.load() > 0){
+            bad.fetch_add(scan(instance, random, writers, window, steps + window));
+            scans.fetch_add(1);
+        }
+    });
+    report.check(bad.load() == 0, name, test, std::to_string(bad.load()) + " windows that never were in " + std::to_string(scans.load()) + " scans");
+}
+
+/**
+ * snapshot(), and exactSize() if List has it, under sliding window writers: the
+ * snapshot has to show every writer's window whole, the size has to count W or W+1
+ * items per writer.
+ */
+template<typename List> void testSnapshot(TestReport& report, const std::string& name, const TestConfig& config){
+    testSlidingWindows<List>(report, name, "snapshot", config, [](List& instance, std::mt19937&, int writers, int window, int items){
+        return badWindows(instance.snapshot(), writers, window, 0, items, true);
+    });
+    if constexpr (hasSize<List>::value){
+        testSlidingWindows<List>(report, name, "exactSize", config, [](List& instance, std::mt19937&, int writers, int window, int){
+            std::size_t size = instance.exactSize();
+            return static_cast<int>(size < static_cast<std::size_t>(writers * window) || size > static_cast<std::size_t>(writers * (window + 1)));
+        });
+    }
+}
+
+/**
+ * rangeScan(), for a List with DirectOrder<int>: alone, it gives [lo, hi) in order,
+ * and under sliding window writers every writer's part of a random range has to be
+ * a run of at most W+1 items.
+ */
+template<typename List> void testRangeScan(TestReport& report, const std::string& name, const TestConfig& config){
+    std::cout << name << "\n";
+    {
+        List instance;
+        std::vector<int> all;
+        for (int i = -config.testSize; i < config.testSize; i++){
+            all.push_back(i);
+        }
+        std::shuffle(all.begin(), all.end(), std::mt19937(config.testSize));
+        for (int item : all){
+            instance.add(item);
+        }
+        std::vector<int> expected;
+        for (int i = -10; i < 20; i++){
+            expected.push_back(i);
+        }
+        report.check(instance.rangeScan(-10, 20) == expected, name, "range scan", "rangeScan(-10, 20)");
+        report.check(instance.rangeScan(5, 5).empty(), name, "range scan", "empty range");
+        report.check(instance.rangeScan(config.testSize, config.testSize + 10).empty(), name, "range scan", "range past the end");
+        std::sort(all.begin(), all.end());
+        report.check(forEachItems(instance) == all, name, "range scan", "DirectOrder walk is not ascending");
+    }
+    testSlidingWindows<List>(report, name, "parallel range scan", config, [](List& instance, std::mt19937& random, int writers, int window, int items){
+        int lo = random() % items;
+        int hi = lo + 1 + random() % (4 * window);
+        std::vector<int> seen = instance.rangeScan(lo * writers, hi * writers);
+        return badWindows(seen, writers, window, lo, hi, false) + !std::is_sorted(seen.begin(), seen.end());
+    });
+}
+
+/**
+ * Every test, against a fresh List each time.
+ */
+template<typename List> void runListTests(TestReport& report, const std::string& name, const TestConfig& config){
+    std::cout << name << "\n";
+    testSequential<List>(report, name, config);
+    testParallelAdd<List>(report, name, config);
+    testParallelRemove<List>(report, name, config);
+    testParallelBoth<List>(report, name, config);
+    testStress<List>(report, name, config);
+    testLinearizable<List>(report, name, config);
+    if constexpr (hasBatch<List>::value){
+        testBatch<List>(report, name, config);
+    }
+    if constexpr (hasForEach<List>::value){
+        testIteration<List>(report, name, config);
+    }
+    if constexpr (hasSnapshot<List>::value){
+        testSnapshot<List>(report, name, config);
+    }
+}
+
+#endif
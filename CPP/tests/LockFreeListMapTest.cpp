@@ -0,0 +1,17 @@
+#include "MapTest.hpp"
+
+#include "../LockFreeListMap.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runMapTests<LockFreeListMap<int, long>>(report, "lockfree-map", config);
+    runMapTests<LockFreeListMap<int, long, HazardPointerReclaimer>>(report, "lockfree-map-hp", config);
+    runMapTests<LockFreeListMap<int, long, EpochReclaimer, PoolAllocator<>>>(report, "lockfree-map-pool", config);
+    runMapTests<LockFreeListMap<int, long, EpochReclaimer, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "lockfree-map-colliding", config);
+
+    testMapExceptions<LockFreeListMap<int, long, EpochReclaimer, FailingAllocator>>(report, "lockfree-map-exceptions");
+    return report.exitCode();
+}
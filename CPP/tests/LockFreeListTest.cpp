@@ -0,0 +1,24 @@
+#include "ListTest.hpp"
+
+#include "../LockFreeList.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<LockFreeList<int>>(report, "lockfree", config);
+    runListTests<LockFreeList<int, HazardPointerReclaimer>>(report, "lockfree-hp", config);
+    runListTests<LockFreeList<int, EpochReclaimer, PoolAllocator<>>>(report, "lockfree-pool", config);
+    runListTests<LockFreeList<int, EpochReclaimer, HeapAllocator, DirectOrder<int>>>(report, "lockfree-direct", config);
+    runListTests<LockFreeList<int, EpochReclaimer, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "lockfree-colliding", config);
+    runListTests<LockFreeList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, NoBackoff>>(report, "lockfree-nobackoff", config);
+    runListTests<LockFreeList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, RandomizedBackoff>>(report, "lockfree-random", config);
+    runListTests<LockFreeList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, YieldBackoff<>>>(report, "lockfree-yield", config);
+
+    runListTests<LockFreeList<int, HazardPointerReclaimer, HeapAllocator, HashOrder<int>, ExponentialBackoff, Instrumented>>(report, "lockfree-hp-instrumented", config);
+
+    testRangeScan<LockFreeList<int, EpochReclaimer, HeapAllocator, DirectOrder<int>>>(report, "lockfree-range-scan", config);
+    testRangeScan<LockFreeList<int, HazardPointerReclaimer, HeapAllocator, DirectOrder<int>>>(report, "lockfree-hp-range-scan", config);
+    return report.exitCode();
+}
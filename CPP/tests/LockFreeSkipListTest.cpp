@@ -0,0 +1,15 @@
+#include "ListTest.hpp"
+
+#include "../LockFreeSkipList.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<LockFreeSkipList<int>>(report, "lockfree-skiplist", config);
+    runListTests<LockFreeSkipList<int, PoolAllocator<>>>(report, "lockfree-skiplist-pool", config);
+    runListTests<LockFreeSkipList<int, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "lockfree-skiplist-colliding", config);
+
+    return report.exitCode();
+}
@@ -0,0 +1,183 @@
+#ifndef MAP_TEST_HPP
+#define MAP_TEST_HPP
+
+//
+// Used for the values
+#include <optional>
+#include <stdexcept>
+
+#include "ListTest.hpp"
+
+/**
+ * Every write of a map in turn, against what a std::map would say: the value each
+ * call returns, and what get() and containsKey() see afterwards.
+ */
+template<typename Map> void testMapSequential(TestReport& report, const std::string& name, const TestConfig& config){
+    Map instance;
+    auto some = [](long value){ return std::optional<long>(value); };
+    for (int i = 0; i < config.testSize; i++){
+        std::string key = std::to_string(i);
+        report.check(!instance.get(i) && !instance.containsKey(i), name, "map sequential", "present before put: " + key);
+        report.check(!instance.replace(i, 1), name, "map sequential", "replace of an absent key: " + key);
+        report.check(!instance.containsKey(i), name, "map sequential", "replace added: " + key);
+        report.check(!instance.computeIfPresent(i, [](long value){ return std::optional<long>(value + 1); }), name, "map sequential", "computeIfPresent of an absent key: " + key);
+        report.check(!instance.containsKey(i), name, "map sequential", "computeIfPresent added: " + key);
+
+        report.check(!instance.put(i, i), name, "map sequential", "put of a new key returned a value: " + key);
+        report.check(instance.get(i) == some(i) && instance.containsKey(i), name, "map sequential", "bad get after put: " + key);
+        report.check(instance.put(i, i + 1) == some(i), name, "map sequential", "put did not return the old value: " + key);
+        report.check(instance.putIfAbsent(i, -1) == some(i + 1), name, "map sequential", "putIfAbsent of a present key: " + key);
+        report.check(instance.get(i) == some(i + 1), name, "map sequential", "putIfAbsent overwrote: " + key);
+        report.check(instance.replace(i, i + 2) == some(i + 1), name, "map sequential", "bad replace: " + key);
+        report.check(instance.computeIfPresent(i, [](long value){ return std::optional<long>(value * 2); }) == some(2 * (i + 2)), name, "map sequential", "bad computeIfPresent: " + key);
+        report.check(instance.get(i) == some(2 * (i + 2)), name, "map sequential", "computeIfPresent not stored: " + key);
+    }
+    for (int i = 0; i < config.testSize; i++){
+        std::string key = std::to_string(i);
+        if (i % 2 == 0){
+            report.check(instance.remove(i) == some(2 * (i + 2)), name, "map sequential", "bad remove: " + key);
+        }
+        else {
+            report.check(!instance.computeIfPresent(i, [](long){ return std::optional<long>(); }), name, "map sequential", "computeIfPresent removing returned a value: " + key);
+        }
+        report.check(!instance.containsKey(i) && !instance.get(i), name, "map sequential", "present after remove: " + key);
+        report.check(!instance.remove(i), name, "map sequential", "second remove: " + key);
+
+        report.check(instance.compute(i, [](std::optional<long> value){ return std::optional<long>(value ? -1 : 7); }) == some(7), name, "map sequential", "compute of an absent key: " + key);
+        report.check(instance.putIfAbsent(i, -1) == some(7), name, "map sequential", "compute did not add: " + key);
+        report.check(!instance.compute(i, [](std::optional<long>){ return std::optional<long>(); }), name, "map sequential", "compute removing returned a value: " + key);
+        report.check(!instance.containsKey(i), name, "map sequential", "compute did not remove: " + key);
+        report.check(!instance.putIfAbsent(i, 3) && instance.get(i) == some(3), name, "map sequential", "putIfAbsent of an absent key: " + key);
+    }
+}
+
+/**
+ * Threads increment a handful of counters with compute() and computeIfPresent().
+ * No increment may be lost, so each counter ends at exactly the number made on it.
+ */
+template<typename Map> void testMapParallelCompute(TestReport& report, const std::string& name, const TestConfig& config){
+    Map instance;
+    const int keys = 4;
+    int perThread = config.testSize * 8;
+    runThreads(config.threads, [&](int t){
+        for (int i = 0; i < perThread; i++){
+            int key = (t + i) % keys;
+            if (i % 2 == 0 || !instance.computeIfPresent(key, [](long value){ return std::optional<long>(value + 1); })){
+                instance.compute(key, [](std::optional<long> value){ return std::optional<long>(value ? *value + 1 : 1); });
+            }
+        }
+    });
+    long total = 0;
+    for (int key = 0; key < keys; key++){
+        total += instance.get(key).value_or(0);
+    }
+    long expected = static_cast<long>(config.threads) * perThread;
+    report.check(total == expected, name, "map parallel compute", std::to_string(total) + " increments counted, expected " + std::to_string(expected));
+}
+
+/**
+ * Millions of random writes and reads on a small key range. Every value a key is
+ * given names the key, so a get() can tell a value that was never put there. Each
+ * thread keeps a ledger of the calls that added or removed a key; per key they net
+ * out to 0 or 1 and match containsKey() at the end.
+ */
+template<typename Map> void testMapStress(TestReport& report, const std::string& name, const TestConfig& config){
+    Map instance;
+    std::vector<std::atomic<long>> net(config.stressRange);
+    std::atomic<int> foreign{0};
+    int perThread = config.stressOps / config.threads / 4;
+    runThreads(config.threads, [&](int t){
+        std::mt19937 random(t + 1);
+        for (int i = 0; i < perThread; i++){
+            int key = random() % config.stressRange;
+            long value = static_cast<long>(i) * config.stressRange + key;
+            std::optional<long> seen;
+            switch (random() % 6){
+                case 0:
+                    seen = instance.put(key, value);
+                    if (!seen){
+                        net[key].fetch_add(1, std::memory_order_relaxed);
+                    }
+                    break;
+                case 1:
+                    seen = instance.putIfAbsent(key, value);
+                    if (!seen){
+                        net[key].fetch_add(1, std::memory_order_relaxed);
+                    }
+                    break;
+                case 2:
+                    seen = instance.remove(key);
+                    if (seen){
+                        net[key].fetch_sub(1, std::memory_order_relaxed);
+                    }
+                    break;
+                case 3:
+                    seen = instance.replace(key, value);
+                    break;
+                case 4:
+                    seen = instance.computeIfPresent(key, [&](long current){ return std::optional<long>(current + config.stressRange); });
+                    break;
+                default:
+                    seen = instance.get(key);
+                    break;
+            }
+            if (seen && *seen % config.stressRange != key){
+                foreign.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    report.check(foreign.load() == 0, name, "map stress", std::to_string(foreign.load()) + " values of another key");
+    for (int key = 0; key < config.stressRange; key++){
+        long count = net[key].load();
+        report.check(count == 0 || count == 1, name, "map stress", "key " + std::to_string(key) + " added " + std::to_string(count) + " more times than removed");
+        report.check(instance.containsKey(key) == (count == 1), name, "map stress", "wrong membership: " + std::to_string(key));
+    }
+}
+
+/**
+ * A write whose function throws, and one with no memory for the node, for a Map
+ * over FailingAllocator. Both let the exception through with the map unchanged and
+ * its locks released, so the key can still be written.
+ */
+template<typename Map> void testMapExceptions(TestReport& report, const std::string& name){
+    std::cout << name << "\n";
+    Map instance;
+    instance.put(1, 10);
+
+    bool threw = false;
+    try {
+        instance.compute(1, [](std::optional<long>) -> std::optional<long> { throw std::runtime_error("compute"); });
+    }
+    catch (const std::runtime_error&){
+        threw = true;
+    }
+    report.check(threw, name, "map exceptions", "compute swallowed the exception");
+    report.check(instance.get(1) == std::optional<long>(10), name, "map exceptions", "throwing compute changed the value");
+
+    FailingAllocator::budget.store(0);
+    threw = false;
+    try {
+        instance.put(2, 20);
+    }
+    catch (const std::bad_alloc&){
+        threw = true;
+    }
+    FailingAllocator::budget.store(-1);
+    report.check(threw, name, "map exceptions", "put without memory did not throw");
+    report.check(!instance.containsKey(2), name, "map exceptions", "put without memory added the key");
+
+    report.check(instance.put(1, 11) == std::optional<long>(10), name, "map exceptions", "put after a throwing compute");
+    report.check(!instance.put(2, 20) && instance.get(2) == std::optional<long>(20), name, "map exceptions", "put once memory is back");
+}
+
+/**
+ * Every map test, against a fresh Map each time.
+ */
+template<typename Map> void runMapTests(TestReport& report, const std::string& name, const TestConfig& config){
+    std::cout << name << "\n";
+    testMapSequential<Map>(report, name, config);
+    testMapParallelCompute<Map>(report, name, config);
+    testMapStress<Map>(report, name, config);
+}
+
+#endif
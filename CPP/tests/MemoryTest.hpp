@@ -0,0 +1,166 @@
+#ifndef MEMORY_TEST_HPP
+#define MEMORY_TEST_HPP
+
+//
+// Used for counting
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+//
+// Used for the replacement operator new
+#include <cstdlib>
+#include <new>
+
+#include "ListTest.hpp"
+
+/**
+ * Bytes handed out by operator new and not deleted yet, in this program. Including
+ * this header replaces the global operator new and delete, so only one file of a
+ * program may include it.
+ */
+inline std::atomic<std::int64_t> liveBytes{0};
+
+/**
+ * Allocate size bytes aligned to align, with the size stored just in front.
+ */
+inline void* countedAllocate(std::size_t size, std::size_t align){
+    if (align < alignof(std::max_align_t)){
+        align = alignof(std::max_align_t);
+    }
+    std::size_t total = (align + size + align - 1) / align * align;
+    char* block = static_cast<char*>(std::aligned_alloc(align, total));
+    if (block == nullptr){
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<std::size_t*>(block + align - sizeof(std::size_t)) = size;
+    liveBytes.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+    return block + align;
+}
+
+/**
+ * Free what countedAllocate() made with the same align.
+ */
+inline void countedFree(void* memory, std::size_t align){
+    if (memory == nullptr){
+        return;
+    }
+    if (align < alignof(std::max_align_t)){
+        align = alignof(std::max_align_t);
+    }
+    char* block = static_cast<char*>(memory) - align;
+    std::size_t size = *reinterpret_cast<std::size_t*>(block + align - sizeof(std::size_t));
+    liveBytes.fetch_sub(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+    std::free(block);
+}
+
+void* operator new(std::size_t size){
+    return countedAllocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t align){
+    return countedAllocate(size, static_cast<std::size_t>(align));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAllocate(size, 0);
+    }
+    catch (const std::bad_alloc&){
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    try {
+        return countedAllocate(size, static_cast<std::size_t>(align));
+    }
+    catch (const std::bad_alloc&){
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size){
+    return countedAllocate(size, 0);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align){
+    return countedAllocate(size, static_cast<std::size_t>(align));
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& nothrow) noexcept {
+    return operator new(size, nothrow);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t& nothrow) noexcept {
+    return operator new(size, align, nothrow);
+}
+
+void operator delete(void* memory) noexcept {
+    countedFree(memory, 0);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    countedFree(memory, 0);
+}
+
+void operator delete(void* memory, std::align_val_t align) noexcept {
+    countedFree(memory, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t align) noexcept {
+    countedFree(memory, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    countedFree(memory, 0);
+}
+
+void operator delete(void* memory, std::align_val_t align, const std::nothrow_t&) noexcept {
+    countedFree(memory, static_cast<std::size_t>(align));
+}
+
+void operator delete[](void* memory) noexcept {
+    countedFree(memory, 0);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    countedFree(memory, 0);
+}
+
+void operator delete[](void* memory, std::align_val_t align) noexcept {
+    countedFree(memory, static_cast<std::size_t>(align));
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t align) noexcept {
+    countedFree(memory, static_cast<std::size_t>(align));
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    countedFree(memory, 0);
+}
+
+void operator delete[](void* memory, std::align_val_t align, const std::nothrow_t&) noexcept {
+    countedFree(memory, static_cast<std::size_t>(align));
+}
+
+/**
+ * Memory per item of a Set that has grown to many items from one thread, as a hash
+ * set with list buckets does. Every bucket is a whole list, so whatever a list
+ * carries besides its nodes is paid once per bucket: at most bytesPerItem bytes,
+ * nodes and table included, may be live per item. A plain list takes quadratic time
+ * to fill, give it fewer items.
+ */
+template<typename Set> void testMemory(TestReport& report, const std::string& name, std::size_t bytesPerItem, int items = 1 << 17){
+    std::cout << name << "\n";
+    std::int64_t before = liveBytes.load();
+    {
+        Set instance;
+        for (int i = 0; i < items; i++){
+            instance.add(i);
+        }
+        std::int64_t used = liveBytes.load() - before;
+        report.check(used <= static_cast<std::int64_t>(bytesPerItem) * items, name, "memory", std::to_string(used / items) + " bytes per item, expected at most " + std::to_string(bytesPerItem));
+    }
+}
+
+#endif
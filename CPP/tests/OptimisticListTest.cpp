@@ -0,0 +1,25 @@
+#include "ListTest.hpp"
+
+#include "../OptimisticList.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<OptimisticList<int>>(report, "optimistic", config);
+    runListTests<OptimisticList<int, HazardPointerReclaimer>>(report, "optimistic-hp", config);
+    runListTests<OptimisticList<int, EpochReclaimer, PoolAllocator<>>>(report, "optimistic-pool", config);
+    runListTests<OptimisticList<int, EpochReclaimer, HeapAllocator, DirectOrder<int>>>(report, "optimistic-direct", config);
+    runListTests<OptimisticList<int, EpochReclaimer, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "optimistic-colliding", config);
+    runListTests<OptimisticList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, SpinLock, NoBackoff>>(report, "optimistic-nobackoff", config);
+    runListTests<OptimisticList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, SpinLock, RandomizedBackoff>>(report, "optimistic-random", config);
+    runListTests<OptimisticList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, SpinLock, YieldBackoff<>>>(report, "optimistic-yield", config);
+    runListTests<OptimisticList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, std::mutex>>(report, "optimistic-mutex", config);
+    runListTests<OptimisticList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, MCSLock>>(report, "optimistic-mcs", config);
+
+    runListTests<OptimisticList<int, EpochReclaimer, HeapAllocator, HashOrder<int>, SpinLock, ExponentialBackoff, Instrumented>>(report, "optimistic-instrumented", config);
+
+    testOutOfMemory<OptimisticList<int, EpochReclaimer, FailingAllocator>>(report, "optimistic-out-of-memory", config);
+    return report.exitCode();
+}
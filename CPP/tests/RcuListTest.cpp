@@ -0,0 +1,17 @@
+#include "ListTest.hpp"
+
+#include "../RcuList.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<RcuList<int>>(report, "rcu", config);
+    runListTests<RcuList<int, HazardPointerReclaimer>>(report, "rcu-hp", config);
+    runListTests<RcuList<int, EpochReclaimer, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "rcu-colliding", config);
+
+    testParallelOutOfMemory<RcuList<int, EpochReclaimer, FailingAllocator>>(report, "rcu-parallel-out-of-memory", config);
+
+    return report.exitCode();
+}
@@ -0,0 +1,18 @@
+#include "ListTest.hpp"
+#include "MemoryTest.hpp"
+
+#include "../RefinableHashSet.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<RefinableHashSet<int>>(report, "refinable", config);
+    runListTests<RefinableHashSet<int, FineList<int>>>(report, "refinable-fine", config);
+
+    testMemory<RefinableHashSet<int>>(report, "refinable-memory", 128);
+    testMemory<RefinableHashSet<int, FineList<int>>>(report, "refinable-fine-memory", 128);
+
+    return report.exitCode();
+}
@@ -0,0 +1,15 @@
+#include "ListTest.hpp"
+
+#include "../SplitOrderedHashSet.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<SplitOrderedHashSet<int>>(report, "split-ordered", config);
+    runListTests<SplitOrderedHashSet<int, HazardPointerReclaimer>>(report, "split-ordered-hp", config);
+    runListTests<SplitOrderedHashSet<int, EpochReclaimer, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "split-ordered-colliding", config);
+
+    return report.exitCode();
+}
@@ -0,0 +1,18 @@
+#include "ListTest.hpp"
+#include "MemoryTest.hpp"
+
+#include "../StripedHashSet.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<StripedHashSet<int>>(report, "striped", config);
+    runListTests<StripedHashSet<int, FineList<int>>>(report, "striped-fine", config);
+
+    testMemory<StripedHashSet<int>>(report, "striped-memory", 128);
+    testMemory<StripedHashSet<int, FineList<int>>>(report, "striped-fine-memory", 128);
+
+    return report.exitCode();
+}
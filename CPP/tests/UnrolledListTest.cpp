@@ -0,0 +1,21 @@
+#include "ListTest.hpp"
+
+#include "../UnrolledList.hpp"
+
+int main(int argc, char** argv)
+{
+    TestConfig config = TestConfig::fromArgs(argc, argv);
+    TestReport report;
+
+    runListTests<UnrolledList<int>>(report, "unrolled", config);
+    runListTests<UnrolledList<int, 4>>(report, "unrolled-4", config);
+    runListTests<UnrolledList<int, 32>>(report, "unrolled-32", config);
+    runListTests<UnrolledList<int, 16, HazardPointerReclaimer>>(report, "unrolled-hp", config);
+    runListTests<UnrolledList<int, 16, EpochReclaimer, PoolAllocator<>>>(report, "unrolled-pool", config);
+    runListTests<UnrolledList<int, 16, EpochReclaimer, HeapAllocator, DirectOrder<int>>>(report, "unrolled-direct", config);
+    runListTests<UnrolledList<int, 4, EpochReclaimer, HeapAllocator, HashOrder<int, CollidingHash>>>(report, "unrolled-colliding", config);
+    runListTests<UnrolledList<int, 16, EpochReclaimer, HeapAllocator, HashOrder<int>, std::mutex>>(report, "unrolled-mutex", config);
+    runListTests<UnrolledList<int, 16, EpochReclaimer, HeapAllocator, HashOrder<int>, MCSLock>>(report, "unrolled-mcs", config);
+
+    return report.exitCode();
+}
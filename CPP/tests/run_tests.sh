@@ -0,0 +1,38 @@
+#!/bin/sh
+#
+# Build and run every test program.
+#
+#   ./run_tests.sh          optimized build, full sizes
+#   ./run_tests.sh asan     AddressSanitizer and UndefinedBehaviorSanitizer, --quick
+#   ./run_tests.sh tsan     ThreadSanitizer, --quick
+#
+# CXX picks the compiler, g++ by default.
+
+cd "$(dirname "$0")" || exit 1
+
+CXX=${CXX:-g++}
+MODE=${1:-plain}
+OUT=build-$MODE
+ARGS=
+
+case $MODE in
+    plain) FLAGS="-O2" ;;
+    asan)  FLAGS="-O1 -g -fno-omit-frame-pointer -fsanitize=address,undefined"; ARGS=--quick ;;
+    tsan)  FLAGS="-O1 -g -fsanitize=thread"; ARGS=--quick; export TSAN_OPTIONS="detect_deadlocks=0 suppressions=$(pwd)/tsan.supp $TSAN_OPTIONS" ;;
+    *)     echo "usage: $0 [plain|asan|tsan]"; exit 2 ;;
+esac
+
+mkdir -p "$OUT"
+status=0
+for test in *Test.cpp; do
+    name=${test%.cpp}
+    echo "== $name"
+    if ! $CXX -std=c++17 -Wall -Wextra -pthread $FLAGS "$test" -o "$OUT/$name"; then
+        status=1
+        continue
+    fi
+    if ! "./$OUT/$name" $ARGS; then
+        status=1
+    fi
+done
+exit $status